@@ -0,0 +1,19 @@
+#pragma once
+// Counts heap allocations made through operator new. Replaces the global
+// operator new and delete, so include it from exactly one file of a bench.
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<std::size_t> allocCount{0};
+
+void *operator new(std::size_t size) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,82 @@
+// Keyword recognition benchmark: the old runtime StringMap against the
+// constexpr keywordType() switch, on identifier-heavy input.
+//   keywordbench [identifiers]
+#include "Token.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <llvm/ADT/StringMap.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+  const llvm::StringMap<TokenType> &stringMapKeywords() {
+    static const llvm::StringMap<TokenType> keywords = {
+        {"and", AND}, {"or", OR}, {"false", FALSE}, {"true", TRUE},
+        {"class", CLASS}, {"super", SUPER}, {"self", SELF}, {"new", NEW},
+        {"if", IF}, {"elif", ELIF}, {"else", ELSE}, {"for", FOR},
+        {"while", WHILE}, {"decl", DECL}, {"def", DEF}, {"var", VAR},
+        {"none", NONE}, {"ref", REF}, {"return", RETURN}, {"break", BREAK},
+        {"continue", CONTINUE}, {"int", INT}, {"double", DOUBLE}, {"bool", BOOL},
+        {"str", STR}, {"char", CHAR}, {"list", LIST}, {"lambda", LAMBDA},
+        {"try", TRY}, {"throw", THROW}};
+    return keywords;
+  }
+
+  TokenType stringMapLookup(std::string_view text) {
+    const auto &keywords = stringMapKeywords();
+    auto it = keywords.find(text);
+    return it != keywords.end() ? it->second : IDENTIFIER;
+  }
+
+  // roughly the mix of a generated Cat program: mostly user identifiers,
+  // many sharing a length and first letter with some keyword
+  std::vector<std::string> makeWords(std::size_t n) {
+    const char *pool[] = {"i", "x", "count", "index", "value", "result", "def", "var",
+                          "int", "return", "while", "if", "self", "elem", "input",
+                          "dist", "class_name", "temp", "buffer", "continue_flag",
+                          "ret", "str", "string", "tmp", "node", "left", "right"};
+    std::vector<std::string> words;
+    words.reserve(n);
+    unsigned seed = 12345;
+    for (std::size_t i = 0; i < n; ++i) {
+      seed = seed * 1103515245u + 12345u;
+      words.emplace_back(pool[(seed >> 16) % (sizeof(pool) / sizeof(pool[0]))]);
+    }
+    return words;
+  }
+
+  template<typename Fn>
+  double measure(const std::vector<std::string> &words, Fn lookup, unsigned &keywords) {
+    auto t0 = std::chrono::steady_clock::now();
+    unsigned hits = 0;
+    for (const auto &word: words) {
+      hits += lookup(word) != IDENTIFIER;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    keywords = hits;
+    return std::chrono::duration<double>(t1 - t0).count();
+  }
+}// namespace
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+  auto words = makeWords(n);
+  unsigned hitsOld = 0, hitsNew = 0;
+  double best[2] = {1e9, 1e9};
+  for (int i = 0; i < 5; ++i) {
+    best[0] = std::min(best[0], measure(words, stringMapLookup, hitsOld));
+    best[1] = std::min(best[1], measure(words, keywordType, hitsNew));
+  }
+  if (hitsOld != hitsNew) {
+    std::fprintf(stderr, "recognizers disagree: %u vs %u keywords\n", hitsOld, hitsNew);
+    return 1;
+  }
+  std::printf("%zu identifiers, %u keywords\n", n, hitsNew);
+  std::printf("%-12s %8.2f ns/identifier\n", "StringMap", best[0] * 1e9 / n);
+  std::printf("%-12s %8.2f ns/identifier\n", "keywordType", best[1] * 1e9 / n);
+  return 0;
+}
@@ -0,0 +1,145 @@
+// Lexer throughput benchmark.
+//   lexbench [file.cat] [iterations]
+// Without a file a synthetic program of about 16 MB is generated.
+#include "AllocCounter.hpp"
+#include "Diagnostics.hpp"
+#include "Scanner.hpp"
+#include "SourceBuffer.hpp"
+#include "Token.hpp"
+#include "TokenBuffer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace {
+  const char *snippet = R"(class Point {
+    var x:int
+    var y:int
+    def constructor(px:int, py:int) {
+        x = px
+        y = py
+      }
+    def dist(other:Point) -> int {
+        var dx:int = x - other.x
+        var dy:int = y - other.y
+        return dx * dx + dy * dy
+      }
+}
+// iterative fibonacci
+def fib(n:int) -> int {
+    var a:int = 0
+    var b:int = 1
+    var i:int = 0
+    while (i < n) {
+        var t:int = a + b
+        a = b
+        b = t
+        i = i + 1
+      }
+    return a
+  }
+/* block comment with "quotes" */
+def greet(count:int) {
+    print("hello\tworld %d\n", count)
+    print("no escapes here")
+  }
+)";
+
+  std::string synthesize(std::size_t bytes) {
+    std::string src;
+    src.reserve(bytes + 1024);
+    while (src.size() < bytes) {
+      src += snippet;
+    }
+    return src;
+  }
+
+  struct Result {
+    std::size_t tokens = 0;
+    std::size_t allocs = 0;
+    double seconds = 0;
+  };
+
+  // copyLexemes mimics the old scanner, where every lexeme was a std::string
+  Result run(std::string_view source, bool copyLexemes) {
+    Result r;
+    std::size_t sink = 0;
+    auto before = allocCount.load();
+    auto t0 = std::chrono::steady_clock::now();
+    Scanner scanner(source);
+    for (Token tok = scanner.scanToken(); tok.type != TOKEN_EOF; tok = scanner.scanToken()) {
+      if (copyLexemes) {
+        std::string text(tok.lexeme);
+        sink += text.size();
+      } else {
+        sink += tok.lexeme.size();
+      }
+      ++r.tokens;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    r.allocs = allocCount.load() - before;
+    r.seconds = std::chrono::duration<double>(t1 - t0).count();
+    if (sink == 0) {
+      std::printf("empty input\n");
+    }
+    return r;
+  }
+
+  // lex everything into the TokenBuffer the parser consumes
+  Result runBuffered(std::string_view source) {
+    Result r;
+    auto before = allocCount.load();
+    auto t0 = std::chrono::steady_clock::now();
+    Scanner scanner(source);
+    TokenBuffer tokens = scanner.scanTokens();
+    auto t1 = std::chrono::steady_clock::now();
+    r.tokens = tokens.size() - 1;
+    r.allocs = allocCount.load() - before;
+    r.seconds = std::chrono::duration<double>(t1 - t0).count();
+    return r;
+  }
+
+  void report(const char *name, std::size_t bytes, const Result &r) {
+    double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::printf("%-20s %10zu tokens %8.1f MB/s %8.3f allocs/token\n", name, r.tokens,
+                mb / r.seconds, r.tokens ? static_cast<double>(r.allocs) / r.tokens : 0.0);
+  }
+}// namespace
+
+int main(int argc, char *argv[]) {
+  std::unique_ptr<SourceBuffer> buffer;
+  if (argc > 1) {
+    buffer = SourceBuffer::openFile(argv[1]);
+    if (!buffer) {
+      std::fprintf(stderr, "Failed to open file %s\n", argv[1]);
+      return 74;
+    }
+  } else {
+    buffer = SourceBuffer::fromString(synthesize(16 * 1024 * 1024), "<synthetic>");
+  }
+  int iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  std::string_view source = buffer->text();
+  std::printf("%s: %zu bytes%s, %d iterations\n", buffer->getName().c_str(), source.size(),
+              buffer->isMapped() ? " (mapped)" : "", iterations);
+
+  Result best[3];
+  for (int i = 0; i < iterations; ++i) {
+    for (int mode = 0; mode < 3; ++mode) {
+      Result r = mode == 2 ? runBuffered(source) : run(source, mode == 1);
+      if (i == 0 || r.seconds < best[mode].seconds) {
+        best[mode] = r;
+      }
+    }
+  }
+  report("string_view lexemes", source.size(), best[0]);
+  report("copied lexemes", source.size(), best[1]);
+  report("token buffer", source.size(), best[2]);
+  if (Diag::getInstance()->hasErrors()) {
+    Diag::getInstance()->printAll();
+  }
+  return 0;
+}
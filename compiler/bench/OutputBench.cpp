@@ -0,0 +1,85 @@
+// Print throughput benchmark.
+//   outputbench [lines] [output]
+// Prints `lines` lines of the form print("row %d: value=%d sum %u\n", ...)
+// three ways: one printf per line as print used to be, the typed pieces print
+// is lowered to written through stdio, and the same pieces through the cat_
+// runtime's OutputBuffer. The output goes to /dev/null unless a file is given;
+// the timings go to stderr.
+#include "OutputBuffer.hpp"
+#include "catlib.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  void stdioInt(int64_t value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    std::fwrite(digits, 1, end - digits, stdout);
+  }
+  void stdioLit(const char *text) { std::fwrite(text, 1, std::strlen(text), stdout); }
+
+  double printfLines(int32_t lines) {
+    auto t0 = Clock::now();
+    for (int32_t i = 0; i < lines; ++i) {
+      std::printf("row %d: value=%d sum %u\n", i, i * 3, static_cast<uint32_t>(i + 7));
+    }
+    std::fflush(stdout);
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  }
+
+  double stdioPieces(int32_t lines) {
+    auto t0 = Clock::now();
+    for (int32_t i = 0; i < lines; ++i) {
+      stdioLit("row ");
+      stdioInt(i);
+      stdioLit(": value=");
+      stdioInt(i * 3);
+      stdioLit(" sum ");
+      stdioInt(static_cast<uint32_t>(i + 7));
+      std::putchar('\n');
+    }
+    std::fflush(stdout);
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  }
+
+  double bufferedPieces(int32_t lines) {
+    auto t0 = Clock::now();
+    for (int32_t i = 0; i < lines; ++i) {
+      cat_write_lit("row ", 4);
+      cat_write_i32(i);
+      cat_write_lit(": value=", 8);
+      cat_write_i32(i * 3);
+      cat_write_lit(" sum ", 5);
+      cat_write_u32(static_cast<uint32_t>(i + 7));
+      cat_write_char('\n');
+    }
+    Catime::flushOutput();
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  }
+}// namespace
+
+int main(int argc, char *argv[]) {
+  const int32_t lines = argc > 1 ? static_cast<int32_t>(std::strtol(argv[1], nullptr, 10)) : 5000000;
+  const char *output = argc > 2 ? argv[2] : "/dev/null";
+  if (!std::freopen(output, "w", stdout)) {
+    std::fprintf(stderr, "cannot open %s\n", output);
+    return 1;
+  }
+
+  const double base = printfLines(lines);
+  const double pieces = stdioPieces(lines);
+  const double buffered = bufferedPieces(lines);
+  std::fprintf(stderr, "%-22s %10s %14s\n", "", "seconds", "Mlines/s");
+  std::fprintf(stderr, "%-22s %10.3f %14.2f\n", "printf per line", base, lines / base / 1e6);
+  std::fprintf(stderr, "%-22s %10.3f %14.2f\n", "stdio per piece", pieces, lines / pieces / 1e6);
+  std::fprintf(stderr, "%-22s %10.3f %14.2f\n", "OutputBuffer", buffered, lines / buffered / 1e6);
+  std::fprintf(stderr, "speedup over printf: %.2fx\n", base / buffered);
+  return 0;
+}
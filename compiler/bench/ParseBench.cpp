@@ -0,0 +1,135 @@
+// Parser benchmark: time to build and tear down the AST, plus peak RSS.
+//   parsebench [file.cat | function-count]
+//   parsebench --exprs [function-count]
+// Without a file a synthetic program of 100k functions is generated. With
+// --exprs the functions are mostly long flat expressions and deeply nested
+// parentheses, which is where the expression parser's cost shows. Run it
+// once per process; peak RSS is only meaningful for a single parse.
+#include "AllocCounter.hpp"
+#include "AST.hpp"
+#include "ASTContext.hpp"
+#include "Diagnostics.hpp"
+#include "Parser.hpp"
+#include "Scanner.hpp"
+#include "SourceBuffer.hpp"
+#include "SourceManager.hpp"
+#include "TokenBuffer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  std::string synthesize(std::size_t functions) {
+    std::string src;
+    src.reserve(functions * 200);
+    for (std::size_t i = 0; i < functions; ++i) {
+      std::string n = std::to_string(i);
+      src += "def f" + n + "(a:int, b:int) -> int {\n"
+             "    var x:int = a * 2 + b\n"
+             "    var i:int = 0\n"
+             "    while (i < b) {\n"
+             "        if (x > 10) { x = x - a } else { x = x + 1 }\n"
+             "        i = i + 1\n"
+             "      }\n"
+             "    print(\"%d\", x)\n"
+             "    return f" + n + "(x, i - 1) + x\n"
+             "  }\n";
+    }
+    src += "def main() -> int { return 0 }\n";
+    return src;
+  }
+
+  // operands of every precedence level, one long line each, then a nest of
+  // parentheses
+  std::string synthesizeExpressions(std::size_t functions) {
+    static const char *ops[] = {"+", "*", "-", "/", "==", "%", "and", "<", "or", "!="};
+    std::string src;
+    src.reserve(functions * 700);
+    for (std::size_t i = 0; i < functions; ++i) {
+      std::string n = std::to_string(i);
+      src += "def e" + n + "(a:int, b:int) -> int {\n    var x:int = a";
+      for (int k = 0; k < 40; ++k) {
+        src += std::string(" ") + ops[k % 10] + " b";
+        src += k % 3 ? "" : " - -a";
+      }
+      src += "\n    var y:int = ";
+      for (int depth = 0; depth < 32; ++depth) {
+        src += "(a + ";
+      }
+      src += "b";
+      src += std::string(32, ')');
+      src += "\n    return x + y\n  }\n";
+    }
+    src += "def main() -> int { return 0 }\n";
+    return src;
+  }
+
+  double since(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  }
+
+  long peakRssKb() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+}// namespace
+
+int main(int argc, char *argv[]) {
+  std::unique_ptr<SourceBuffer> buffer;
+  if (argc > 1 && std::string(argv[1]) == "--exprs") {
+    std::size_t functions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+    buffer = SourceBuffer::fromString(synthesizeExpressions(functions), "<synthetic expressions>");
+  } else if (argc > 1 && std::atoi(argv[1]) == 0) {
+    buffer = SourceBuffer::openFile(argv[1]);
+    if (!buffer) {
+      std::fprintf(stderr, "Failed to open file %s\n", argv[1]);
+      return 74;
+    }
+  } else {
+    std::size_t functions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    buffer = SourceBuffer::fromString(synthesize(functions), "<synthetic>");
+  }
+  std::string_view source = buffer->text();
+  auto fileId = SrcMgr::getInstance()->addFile(buffer->getName(), source);
+
+  Scanner scanner(source, fileId);
+  TokenBuffer tokens = scanner.scanTokens();
+  long rssBefore = peakRssKb();
+
+  std::size_t nodes = 0;
+  double parseMs = 0, freeMs = 0;
+  std::size_t allocs = 0;
+  {
+    auto ctx = std::make_unique<ASTContext>();
+    auto before = allocCount.load();
+    auto t0 = Clock::now();
+    Parser parser(tokens, *ctx);
+    Program *root = parser.parse();
+    parseMs = since(t0);
+    allocs = allocCount.load() - before;
+    nodes = ctx->nodeCount();
+    if (root->getDefs().empty()) {
+      std::printf("empty program\n");
+    }
+    t0 = Clock::now();
+    ctx.reset();
+    freeMs = since(t0);
+  }
+
+  std::printf("%s: %zu bytes, %zu tokens, %zu nodes\n", buffer->getName().c_str(), source.size(),
+              tokens.size(), nodes);
+  std::printf("parse    %9.1f ms  %10zu allocations\n", parseMs, allocs);
+  std::printf("teardown %9.1f ms\n", freeMs);
+  std::printf("peak RSS %9ld KB (%ld KB after lexing)\n", peakRssKb(), rssBefore);
+  if (Diag::getInstance()->hasErrors()) {
+    Diag::getInstance()->printAll();
+  }
+  return 0;
+}
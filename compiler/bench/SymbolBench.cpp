@@ -0,0 +1,82 @@
+// Symbol table scaling benchmark.
+//   symbolbench [locals-per-scope]
+// Opens nested scopes, declares locals in each, then resolves names that
+// live at the outermost, middle and innermost level. Lookup cost should not
+// depend on the nesting depth.
+#include "Diagnostics.hpp"
+#include "SemaType.hpp"
+#include "Symbol.hpp"
+#include "SymbolTable.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  std::string localName(std::size_t depth, std::size_t i) {
+    return "v" + std::to_string(depth) + "_" + std::to_string(i);
+  }
+
+  struct Result {
+    double declareNs = 0;
+    double lookupNs = 0;
+    double endScopeNs = 0;
+  };
+
+  Result run(std::size_t depth, std::size_t locals) {
+    Result r;
+    SymbolTable table;
+    std::size_t declared = 0;
+    auto t0 = Clock::now();
+    for (std::size_t d = 0; d < depth; ++d) {
+      table.beginScope();
+      for (std::size_t i = 0; i < locals; ++i) {
+        table.declare(std::make_unique<VarSymbol>(intern(localName(d, i)), makeIntType(), Location{}));
+        ++declared;
+      }
+    }
+    r.declareNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / declared;
+
+    // names from the outermost, middle and innermost scopes
+    std::vector<std::string> names;
+    for (std::size_t d: {std::size_t(0), depth / 2, depth - 1}) {
+      for (std::size_t i = 0; i < locals; i += locals / 8 + 1) {
+        names.push_back(localName(d, i));
+      }
+    }
+    const std::size_t rounds = 200000 / names.size() + 1;
+    std::size_t hits = 0;
+    t0 = Clock::now();
+    for (std::size_t k = 0; k < rounds; ++k) {
+      for (const auto &name: names) {
+        hits += table.lookup(name).found();
+      }
+    }
+    r.lookupNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (rounds * names.size());
+    if (hits != rounds * names.size()) {
+      std::printf("lookup failed\n");
+    }
+
+    t0 = Clock::now();
+    for (std::size_t d = 0; d < depth; ++d) {
+      table.endScope();
+    }
+    r.endScopeNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / depth;
+    return r;
+  }
+}// namespace
+
+int main(int argc, char *argv[]) {
+  std::size_t locals = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16;
+  std::printf("%8s %8s %14s %14s %14s\n", "depth", "locals", "declare ns", "lookup ns", "endScope ns");
+  for (std::size_t depth: {1, 8, 64, 256, 1024, 4096}) {
+    Result r = run(depth, locals);
+    std::printf("%8zu %8zu %14.1f %14.1f %14.1f\n", depth, depth * locals, r.declareNs, r.lookupNs, r.endScopeNs);
+  }
+  return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "AST.hpp"
+#include "ASTContext.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// On-disk cache of parsed ASTs (see ASTSerializer). An entry is named after
+// a hash of the source text and of the compiler binary, so an edited file or
+// a rebuilt compiler simply misses. Entries are written whole under a
+// temporary name and renamed, so concurrent builds sharing a directory never
+// read a partial file; failing to write one is not an error.
+class ASTCache {
+  public:
+  explicit ASTCache(std::string dir);
+
+  // nullptr on a miss; the nodes are created in ctx with locations in fileId
+  Program *load(std::string_view source, uint32_t fileId, ASTContext &ctx) const;
+  void store(std::string_view source, const Program &program) const;
+
+  private:
+  uint64_t key(std::string_view source) const;
+  std::string pathFor(uint64_t key) const;
+
+  std::string dir;
+  uint64_t compilerId;
+};
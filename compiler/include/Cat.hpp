@@ -3,8 +3,13 @@
 #include "Optimizer.hpp"
 #include <string>
 #include <string_view>
+#include <vector>
 using std::string;
 
+class CodeGen;
+class ParallelCodeGen;
+class Program;
+
 class Cat {
   public:
   Cat(int argc_, char *argv_[]) : argc(argc_), argv(argv_) {}
@@ -12,23 +17,39 @@ class Cat {
   // ---------------------------------------
   // build the program
   // ---------------------------------------
-  void build(const std::string &program, llvm::OptimizationLevel optLevel);
+  void build(std::string_view program, llvm::OptimizationLevel optLevel, const std::string &name = "<input>");
   void buildFile(std::string path, llvm::OptimizationLevel optLevel);
+  // stdin, a pipe or, with streamInput, any file: read in pieces, and each
+  // definition is checked and lowered as soon as it is parsed
+  void buildStream(const std::string &path, llvm::OptimizationLevel optLevel);
+  // several files or directories of .cat files, lexed and parsed on `jobs`
+  // threads and compiled as one program
+  void buildFiles(const std::vector<std::string> &inputs, llvm::OptimizationLevel optLevel);
+  // build and run the file, then again whenever it changes; only the
+  // functions an edit affects are checked and lowered again
+  void watchFile(std::string path, llvm::OptimizationLevel optLevel);
   // ---------------------------------------
   // run the program
   // ---------------------------------------
   // void run(const std::string &program);
   // void runFile(std::string path);
-  // ---------------------------------------
-  // read file
-  // ---------------------------------------
-  std::string readFile(std::string_view filename);
-
   public:
   static std::string logo;
   bool isUseJIT = false;
+  bool dumpAST = false; // print the AST after parsing
+  bool emitLLVM = false;// write ./out.ll and ./opt.ll
+  std::string reportFile;// --time-report/--mem-report go to stderr when empty
+  unsigned jobs = 1;     // threads parsing files, checking and lowering functions
+  std::string astCacheDir;// parsed ASTs are cached here, empty to disable
+  bool streamInput = false;// build files as streams, see buildStream
 
   private:
+  // everything after parsing: sema, codegen, optimization and the JIT
+  void compile(Program &root, llvm::OptimizationLevel optLevel);
+  // after codegen: optimization, verification and the JIT
+  void optimizeAndRun(CodeGen &codeGen, ParallelCodeGen &parallelCodeGen, llvm::OptimizationLevel optLevel);
+  void printReport() const;
+
   int argc;
   char **argv;
 };
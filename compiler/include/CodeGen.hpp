@@ -1,10 +1,12 @@
 #pragma once
 #include "AST.hpp"
-#include "ASTVisitor.hpp"
+#include "ASTWalker.hpp"
 #include "CodeGenCtx.hpp"
 #include "Diagnostics.hpp"
 #include "Environment.hpp"
 #include "Location.hpp"
+#include "PassDriver.hpp"
+#include "SSABuilder.hpp"
 #include "Symbol.hpp"
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Function.h>
@@ -12,106 +14,132 @@
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
 
-class CodeGen : public AstVisitor {
+class CodeGen : public AstWalker<CodeGen> {
   public:
-  explicit CodeGen(CodeGenCtx &codegenctx);
+  // a CodeGen lowering part of the program next to others only refers to the
+  // globals the main one defines
+  explicit CodeGen(CodeGenCtx &codegenctx, bool defineGlobals = true);
   virtual ~CodeGen() = default;
-  void compile(sptr<Program> root) {
-    root->accept(*this);
+  void compile(Program *root) {
+    walk(root);
+  }
+  // dump the unoptimized module, only done for --emit-llvm
+  void save(const std::string &path = "./out.ll") {
     std::error_code errorCode;
-    llvm::raw_fd_ostream outLL("./out.ll", errorCode);
+    llvm::raw_fd_ostream outLL(path, errorCode);
     ctx.getModule().print(outLL, nullptr);
   }
 
   CodeGenCtx &getContext() { return ctx; }
 
-  Environment::Env getGlobalEnvironment() const { return globalEnv; }
+  Environment &getGlobalEnvironment() { return env; }
 
-  void visit(Type &node) override;
-  void visit(FuncParameterType &node) override;
-  void visit(Program &node) override;
-  void visit(FuncParameterDecl &node) override;
-  void visit(Header &node) override;
-  void visit(VarDef &node) override;
-  void visit(FuncDecl &node) override;
-  void visit(FuncDef &node) override;
-  void visit(ClassDecl &node) override;
-  void visit(Block &node) override;
+  void visit(Type &node);
+  void visit(FuncParameterType &node);
+  void visit(Program &node);
+  void visit(FuncParameterDecl &node);
+  void visit(Header &node);
+  void visit(VarDef &node);
+  void visit(FuncDecl &node);
+  void visit(FuncDef &node);
+  void visit(ClassDecl &node);
+  void visit(Block &node);
 
-  void visit(SkipStmt &node) override;
-  void visit(ExitStmt &node) override;
-  void visit(AssignStmt &node) override;
-  void visit(ReturnStmt &node) override;
-  void visit(ProcCall &node) override;
-  void visit(BreakStmt &node) override;
-  void visit(ContinueStmt &node) override;
-  void visit(IfStmt &node) override;
-  void visit(LoopStmt &node) override;
+  void visit(SkipStmt &node);
+  void visit(ExitStmt &node);
+  void visit(AssignStmt &node);
+  void visit(ReturnStmt &node);
+  void visit(ProcCall &node);
+  void visit(BreakStmt &node);
+  void visit(ContinueStmt &node);
+  void visit(IfStmt &node);
+  void visit(LoopStmt &node);
 
-  void visit(IdLVal &node) override;
-  void visit(StringLiteralLVal &node) override;
-  void visit(IndexLVal &node) override;
-  void visit(MemberAccessLVal &node) override;
-  void visit(IntConst &node) override;
-  void visit(CharConst &node) override;
-  void visit(TrueConst &node) override;
-  void visit(FalseConst &node) override;
-  void visit(LValueExpr &node) override;
-  void visit(ParenExpr &node) override;
-  void visit(FuncCall &node) override;
-  void visit(MemberAccessExpr &node) override;
-  void visit(MethodCall &node) override;
-  void visit(NewExpr &node) override;
-  void visit(UnaryExpr &node) override;
-  void visit(BinaryExpr &node) override;
-  void visit(ExprCond &node) override;
-  void visit(ArrayExpr &node) override;
+  void visit(IdLVal &node);
+  void visit(StringLiteralLVal &node);
+  void visit(IndexLVal &node);
+  void visit(MemberAccessLVal &node);
+  void visit(IntConst &node);
+  void visit(CharConst &node);
+  void visit(TrueConst &node);
+  void visit(FalseConst &node);
+  void visit(LValueExpr &node);
+  void visit(ParenExpr &node);
+  void visit(FuncCall &node);
+  void visit(MemberAccessExpr &node);
+  void visit(MethodCall &node);
+  void visit(NewExpr &node);
+  void visit(UnaryExpr &node);
+  void visit(BinaryExpr &node);
+  void visit(ExprCond &node);
+  void visit(ArrayExpr &node);
 
   llvm::Function *ensureLLVMFunction(FuncSymbol *funcSym, const CodeGenCtx::FuncSignature &sig, const bool is_main = false);
 
+  // For lowering a program into several modules (see ParallelCodeGen).
+  // declareFunctions creates a prototype for every top-level function;
+  // importDeclarations also rebuilds the classes lowered into `header`, so
+  // any top-level function can then be lowered on its own.
+  void declareFunctions(Program &program);
+  void importDeclarations(Program &program, const CodeGenCtx &header);
+
   public:
-  void setupGlobalEnvironment() {
+  void setupGlobalEnvironment(bool defineGlobals = true) {
     Environment::ValueMap globalObjects{
-        {new VarSymbol("VERSION", nullptr, Location(0, 0)),
+        {new VarSymbol(intern("VERSION"), nullptr, Location::builtIn()),
          ctx.getBuilder().getInt32(42)},
     };
     Environment::ValueMap globalRecords{};
 
     for (auto &entry: globalObjects) {
-      globalRecords[entry.first] = ctx.createGlobalVariable(
-          entry.first->getName(), (llvm::Constant *) entry.second
-      );
+      globalRecords[entry.first] =
+          defineGlobals ? ctx.createGlobalVariable(entry.first->getName(), (llvm::Constant *) entry.second)
+                        : ctx.declareGlobalVariable(entry.first->getName(), entry.second->getType());
     }
-    globalEnv = std::make_shared<Environment>(nullptr, globalRecords, Environment::FuncMap{});
+    env = Environment(std::move(globalRecords));
   }
 
-  class EnvironmentGuard {
-public:
-    EnvironmentGuard(CodeGen &ir_generator, Environment::Env enclosing_env)
-        : ir_generator{ir_generator},
-          previous_env{ir_generator.currentEnv} {
-      ir_generator.currentEnv = std::move(enclosing_env);
-    }
-
-    ~EnvironmentGuard() {
-      ir_generator.currentEnv = std::move(previous_env);
-    }
-
-private:
-    CodeGen &ir_generator;
-    std::shared_ptr<Environment> previous_env;
-  };
-
   private:
   CodeGenCtx &ctx;
   // Result:
   // For Expression nodes: the most recently evaluated computed data result
   // For L-value nodes: memory address
   // For Statements/voids: nullptr
-  static llvm::Value *lastValue;
-  Environment::Env globalEnv = nullptr;    // global environment
-  Environment::Env &currentEnv = globalEnv;// current environment
-  llvm::Value *makeCall(FuncSymbol *calleeSym, const vec<uptr<Expr>> &args);
-  llvm::Value *makeBuiltinCall(FuncSymbol *calleeSym, const vec<uptr<Expr>> &args);
-  llvm::Value *emitPrint(FuncSymbol *calleeSym, const vec<uptr<Expr>> &args);
+  llvm::Value *lastValue = nullptr;
+  Environment env;
+  SSABuilder *ssa = nullptr;// of the function being lowered
+  // a scalar local whose address is never taken is promoted to SSA values,
+  // createLocal gives the others an alloca and returns it
+  llvm::Value *createLocal(Symbol *sym, llvm::Type *type);
+  void writeLocal(Symbol *sym, llvm::Value *value);
+  void bindParam(ParamSymbol *paramSym, llvm::Argument *arg);
+  bool isPromoted(const Symbol *sym) const { return ssa && ssa->isPromoted(sym); }
+  // arrays stay in memory and an array expression yields its address: a
+  // literal is built straight into its destination, other arrays are copied
+  void storeArray(Expr *init, llvm::Value *dest, llvm::Type *arrayTy);
+  void copyArray(llvm::Value *dest, llvm::Value *src, llvm::Type *arrayTy);
+  // a leaf of an array literal: a scalar, or a whole sub-array of `count`
+  // scalars when arrayTy is set
+  struct ArrayElement {
+    llvm::Value *value;
+    llvm::Type *arrayTy;
+    uint64_t count;
+  };
+  void collectElements(ArrayExpr &node, vec<ArrayElement> &elements);
+  llvm::Value *makeCall(FuncSymbol *calleeSym, ASTList<Expr> args);
+  llvm::Value *makeBuiltinCall(FuncSymbol *calleeSym, ASTList<Expr> args);
+  llvm::Value *emitPrint(FuncSymbol *calleeSym, ASTList<Expr> args);
+};
+
+// lowers each definition right after the checks fused in front of it
+class CodeGenDefinitionPass : public DefinitionPass {
+  public:
+  explicit CodeGenDefinitionPass(CodeGen &gen) : gen(gen) {}
+  const char *name() const override { return "codegen"; }
+  unsigned required() const override { return TypesResolved | ControlFlowChecked; }
+  unsigned provided() const override { return IREmitted; }
+  void runOnDefinition(ASTNode *def) override { gen.walk(def); }
+
+  private:
+  CodeGen &gen;
 };
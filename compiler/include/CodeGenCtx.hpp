@@ -4,6 +4,7 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include <llvm-20/llvm/ADT/StringMap.h>
 #include <llvm-20/llvm/IR/BasicBlock.h>
 #include <llvm-20/llvm/IR/Type.h>
 #include <llvm/IR/DerivedTypes.h>
@@ -35,9 +36,9 @@ struct ActiveFuncState {
 
 class CodeGenCtx {
   public:
-  using FieldMap = llvm::StringMap<llvm::Type *>;
-  using MethodMap = llvm::StringMap<llvm::Function *>;
-  static llvm::Function *curFunction;
+  // member ident -> position in declaration order
+  using FieldMap = llvm::DenseMap<Ident, unsigned>;
+  using MethodMap = llvm::DenseMap<Ident, unsigned>;
 
   CodeGenCtx(const std::string &moduleName)
       : ctx(std::make_unique<llvm::LLVMContext>()),
@@ -58,27 +59,30 @@ class CodeGenCtx {
   const llvm::IRBuilder<> &getBuilder() const { return *builder; }
   llvm::IRBuilder<> &getVarsBuilder() { return *varsBuilder; }
 
-  // class information
+  // class information, resolved once per class so member access never
+  // goes back to the type or global tables by name
   struct ClassInfo {
-    ClassInfo(llvm::StructType *clsTy, llvm::StructType *parTy, FieldMap &fmap, MethodMap &mmap)
-        : cls(clsTy), parent(parTy), fieldsMap(fmap), methodsMap(mmap) {}
     ClassInfo(llvm::StructType *clsTy, llvm::StructType *party)
-        : cls(clsTy), parent(party) {
-      fieldsMap = {};
-      methodsMap = {};
-    }
+        : cls(clsTy), parent(party) {}
     llvm::StructType *cls;
     llvm::StructType *parent;
+    llvm::StructType *vTableType = nullptr;
+    llvm::GlobalVariable *vTable = nullptr;
+    llvm::Function *ctor = nullptr;
     FieldMap fieldsMap;
+    vec<llvm::Type *> fieldTypes;
     MethodMap methodsMap;
+    vec<llvm::Function *> methods;
   };
 
   struct FuncSignature {
     vec<llvm::Type *> paramTys;
     llvm::Type *retTy;
   };
-  llvm::StructType *curCls = nullptr;// current class
-  llvm::Value *curThisCls = nullptr; // current this Pointer of current class
+  llvm::Function *curFunction = nullptr;// function being lowered
+  llvm::StructType *curCls = nullptr;   // current class
+  ClassInfo *curClsInfo = nullptr;
+  llvm::Value *curThisCls = nullptr;    // current this Pointer of current class
   private:
   uptr<llvm::LLVMContext> ctx;
   uptr<llvm::Module> module;
@@ -87,29 +91,39 @@ class CodeGenCtx {
       varsBuilder;// this builder always prepends to the beginning of the
                   // function entry block
 
-  using ClassMap = llvm::StringMap<uptr<ClassInfo>>;
+  using ClassMap = llvm::DenseMap<Ident, uptr<ClassInfo>>;
   vec<ActiveFuncState> funcStack;// Stack of active function states
   ClassMap classMap;             // Map of class symbols to their LLVM struct types
+  llvm::StringMap<llvm::GlobalVariable *> stringPool;
+  llvm::DenseMap<llvm::Constant *, llvm::GlobalVariable *> constantPool;
 
   public:
-  void addClsMap(string clsName, uptr<ClassInfo> clsInfo) {
-    classMap[clsName] = std::move(clsInfo);
+  ClassInfo *addClsMap(Ident clsName, uptr<ClassInfo> clsInfo) {
+    auto &slot = classMap[clsName];
+    slot = std::move(clsInfo);
+    return slot.get();
   }
-  ClassInfo *lookupClsMap(string clsName) {
-    if (classMap.find(clsName) != classMap.end()) {
-      return classMap[clsName].get();
-    }
-    return nullptr;
+  ClassInfo *lookupClsMap(Ident clsName) const {
+    auto it = classMap.find(clsName);
+    return it == classMap.end() ? nullptr : it->second.get();
   }
 
   public:
   // Type Translation
   llvm::Type *getLLVMType(const SemaType &ty, bool forParam = false);
   llvm::GlobalVariable *createGlobalVariable(const llvm::StringRef name, llvm::Constant *init);
+  // refer to a global defined in another module
+  llvm::GlobalVariable *declareGlobalVariable(const llvm::StringRef name, llvm::Type *type);
 
-  llvm::Value *createLocalVariable(Symbol *sym, llvm::Type *type, Environment::Env env);
-  llvm::Function *createFunction(const FuncSymbol *funcSym, llvm::FunctionType *fnType, Environment::Env env);
-  llvm::Function *createFunctionProto(const FuncSymbol *funcSym, llvm::FunctionType *fnType, Environment::Env env);
+  // one private constant per distinct string in the module, NUL terminated
+  llvm::GlobalVariable *internString(llvm::StringRef text);
+  // likewise for the constant array literals, copied out with memcpy
+  llvm::GlobalVariable *internConstant(llvm::Constant *init);
+  llvm::Value *createLocalVariable(Symbol *sym, llvm::Type *type, Environment &env);
+  // in the entry block of the current function, bound to no symbol
+  llvm::AllocaInst *createEntryAlloca(llvm::Type *type, const llvm::Twine &name);
+  llvm::Function *createFunction(const FuncSymbol *funcSym, llvm::FunctionType *fnType, Environment &env);
+  llvm::Function *createFunctionProto(const FuncSymbol *funcSym, llvm::FunctionType *fnType, Environment &env);
 
   void createFunctionBlock(llvm::Function *fn);// create a function block
   llvm::BasicBlock *
@@ -121,21 +135,21 @@ class CodeGenCtx {
   // void inheritClass(llvm::StructType *cls, llvm::StructType *parent); //
   // inherit parent class field
   size_t getTypeSize(llvm::Type *type);
-  llvm::Value *createInstance(const string &clsName, const string &varName, Environment::Env env);
+  llvm::Value *createInstance(const ClassInfo *clsInfo, const string &varName);
   llvm::Value *
-  mallocInstance(llvm::StructType *cls,
+  mallocInstance(const ClassInfo *clsInfo,
                  const std::string &name);// allocate an object of a given class on the heap
-  void buildClassInfo(llvm::StructType *cls, const ClassDecl &clsStmt,
-                      Environment::Env env); // build class info
-  void buildClassBody(llvm::StructType *cls);// build class body
-  void buildVTable(llvm::StructType *cls,
-                   ClassInfo *classInfo);// build vtable
-  size_t getFieldIndex(llvm::StructType *cls,
-                       const std::string &fieldName);// get field index
-  size_t getMethodIndex(llvm::StructType *cls,
-                        const std::string &methodName);// get method index
-  bool isMethod(llvm::StructType *cls,
-                const std::string &name);// check if a function is a method
+  void buildClassInfo(ClassInfo *clsInfo, const ClassDecl &clsStmt,
+                      Environment &env);// build class info
+  void buildClassBody(ClassInfo *clsInfo);    // build class body
+  void buildVTable(ClassInfo *classInfo);     // build vtable
+  // rebuild a class that was built into another module: same layout and
+  // member indices, method prototypes and a reference to its vtable
+  ClassInfo *importClass(const ClassDecl &clsStmt, const ClassInfo &defined, Environment &env);
+  size_t getFieldIndex(const ClassInfo *clsInfo,
+                       Ident fieldName) const;// get field index
+  size_t getMethodIndex(const ClassInfo *clsInfo,
+                        Ident methodName) const;// get method index
 
   // helper
   FuncSignature buildSignature(const FuncSymbol *funcSym, bool isMain = false, bool isMethod = false);
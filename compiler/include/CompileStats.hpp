@@ -0,0 +1,87 @@
+#pragma once
+#include "Diagnostics.hpp"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Backs --time-report and --mem-report. Each compiler phase is wrapped in a
+// PhaseTimer that records wall and CPU time, how much the peak RSS grew and
+// how many heap allocations it made; phases also report counts of what they
+// produced. The report is printed once, as text or as JSON.
+class CompileStats {
+  public:
+  enum class Format {
+    Text,
+    Json
+  };
+
+  struct Phase {
+    std::string name;
+    double wallMs = 0;
+    double cpuMs = 0;
+    long peakRssDeltaKB = 0;
+    uint64_t allocations = 0;
+    bool nested = false;// part of the phase listed before it, time only
+  };
+
+  class PhaseTimer {
+    public:
+    PhaseTimer(CompileStats &stats, std::string name);
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+    ~PhaseTimer() { stop(); }
+    void stop();
+
+    private:
+    CompileStats *stats;
+    std::string name;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+    long rssStart;
+    uint64_t allocStart;
+  };
+
+  PhaseTimer phase(std::string name) { return PhaseTimer(*this, std::move(name)); }
+  void count(std::string name, uint64_t value);
+  // time spent in one part of the phase that is running now, e.g. one pass
+  // of a fused pipeline; listed under that phase once it stops
+  void nestedPhase(std::string name, double wallMs, double cpuMs);
+
+  void enableTimeReport(bool on) { timeReport_ = on; }
+  // allocations are only counted while the memory report is on
+  void enableMemReport(bool on);
+  void setFormat(Format format) { format_ = format; }
+  bool timeReport() const { return timeReport_; }
+  bool memReport() const { return memReport_; }
+  bool enabled() const { return timeReport_ || memReport_; }
+  Format format() const { return format_; }
+
+  // LLVM's pass timings, already rendered in the report's format
+  void setPassTimings(std::string report) { passTimings_ = std::move(report); }
+
+  void print(std::ostream &out) const;
+
+  // heap allocations made so far by all threads
+  static uint64_t allocationCount();
+  static long peakRssKB();
+  static double cpuTimeMs();
+  // CPU time of the calling thread only, for work done on a worker
+  static double threadCpuTimeMs();
+
+  private:
+  void printText(std::ostream &out) const;
+  void printJson(std::ostream &out) const;
+
+  bool timeReport_ = false;
+  bool memReport_ = false;
+  Format format_ = Format::Text;
+  std::vector<Phase> phases_;
+  std::vector<Phase> pendingNested_;
+  std::vector<std::pair<std::string, uint64_t>> counts_;
+  std::string passTimings_;
+};
+
+using Stats = Singleton<CompileStats>;
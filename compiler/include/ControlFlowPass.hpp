@@ -1,13 +1,13 @@
 #pragma once
 #include "AST.hpp"
-#include "ASTVisitor.hpp"
+#include "ASTWalker.hpp"
 #include "SemanticCtx.hpp"
 #include "Symbol.hpp"
 
 // second pass
 // handle control flow: return statements, break/continue, if/else, loops
 // reachablility analysis
-class ControlFlowPass : public AstVisitor {
+class ControlFlowPass : public AstWalker<ControlFlowPass> {
   public:
   explicit ControlFlowPass(SemanticCtx &ctx) : semanticCtx(ctx) {};
 
@@ -28,41 +28,41 @@ class ControlFlowPass : public AstVisitor {
 
 
   public:
-  void visit(Type &node) override;
-  void visit(FuncParameterType &node) override;
-  void visit(Program &node) override;
-  void visit(FuncParameterDecl &node) override;
-  void visit(Header &node) override;
-  void visit(VarDef &node) override;
-  void visit(FuncDecl &node) override;
-  void visit(FuncDef &node) override;
-  void visit(ClassDecl &node) override;
-  void visit(Block &node) override;
-  void visit(SkipStmt &node) override;
-  void visit(ExitStmt &node) override;
-  void visit(AssignStmt &node) override;
-  void visit(ReturnStmt &node) override;
-  void visit(ProcCall &node) override;
-  void visit(BreakStmt &node) override;
-  void visit(ContinueStmt &node) override;
-  void visit(IfStmt &node) override;
-  void visit(LoopStmt &node) override;
-  void visit(IdLVal &node) override;
-  void visit(StringLiteralLVal &node) override;
-  void visit(IndexLVal &node) override;
-  void visit(MemberAccessLVal &node) override;
-  void visit(IntConst &node) override;
-  void visit(CharConst &node) override;
-  void visit(TrueConst &node) override;
-  void visit(FalseConst &node) override;
-  void visit(LValueExpr &node) override;
-  void visit(ParenExpr &node) override;
-  void visit(FuncCall &node) override;
-  void visit(MemberAccessExpr &node) override;
-  void visit(MethodCall &node) override;
-  void visit(NewExpr &node) override;
-  void visit(UnaryExpr &node) override;
-  void visit(BinaryExpr &node) override;
-  void visit(ArrayExpr &node) override;
-  void visit(ExprCond &node) override;
+  void visit(Type &node);
+  void visit(FuncParameterType &node);
+  void visit(Program &node);
+  void visit(FuncParameterDecl &node);
+  void visit(Header &node);
+  void visit(VarDef &node);
+  void visit(FuncDecl &node);
+  void visit(FuncDef &node);
+  void visit(ClassDecl &node);
+  void visit(Block &node);
+  void visit(SkipStmt &node);
+  void visit(ExitStmt &node);
+  void visit(AssignStmt &node);
+  void visit(ReturnStmt &node);
+  void visit(ProcCall &node);
+  void visit(BreakStmt &node);
+  void visit(ContinueStmt &node);
+  void visit(IfStmt &node);
+  void visit(LoopStmt &node);
+  void visit(IdLVal &node);
+  void visit(StringLiteralLVal &node);
+  void visit(IndexLVal &node);
+  void visit(MemberAccessLVal &node);
+  void visit(IntConst &node);
+  void visit(CharConst &node);
+  void visit(TrueConst &node);
+  void visit(FalseConst &node);
+  void visit(LValueExpr &node);
+  void visit(ParenExpr &node);
+  void visit(FuncCall &node);
+  void visit(MemberAccessExpr &node);
+  void visit(MethodCall &node);
+  void visit(NewExpr &node);
+  void visit(UnaryExpr &node);
+  void visit(BinaryExpr &node);
+  void visit(ArrayExpr &node);
+  void visit(ExprCond &node);
 };
@@ -2,13 +2,13 @@
 #include "Location.hpp"
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 template<typename T>
 using sptr = std::shared_ptr<T>;
 
 class Symbol;
-class Scope;
 
 struct InsertResult {
   enum class Status {
@@ -43,7 +43,8 @@ struct InsertResult {
 
 struct LookupResult {
   Symbol *symbol = nullptr;
-  sptr<const Scope> owner = nullptr;
+  // nesting depth of the scope the symbol was declared in, 1 = global
+  std::size_t depth = 0;
 
   bool found() const { return symbol != nullptr; }
 
@@ -51,11 +52,11 @@ struct LookupResult {
   // bool isGlobal() const;
 
   // factory methods
-  static LookupResult ok(Symbol *sym, sptr<const Scope> owner) {
-    return {sym, owner};
+  static LookupResult ok(Symbol *sym, std::size_t depth) {
+    return {sym, depth};
   }
   static LookupResult notFound() {
-    return {nullptr, nullptr};
+    return {nullptr, 0};
   }
 
   explicit operator bool() const {
@@ -87,9 +88,29 @@ class Diagnostics {
   };
 
   void report(Severity severity, Phase phase, const Location &location, const std::string &message);
-  void report(Severity severity, int line, int col, const char *fmt, ...);
+  void report(Severity severity, const Location &location, const char *fmt, ...);
+  // a second top-level definition of name, with a note at the first one; the
+  // serial and the parallel front end both report duplicates through this
+  void reportRedefinition(const std::string &name, const Location &location, const Location &previous);
   void printAll() const;
   void clear();
+  // append every entry of other, in order
+  void append(const Diagnostics &other);
+
+  // While alive, reports made on the constructing thread through any
+  // Diagnostics (in practice Diag::getInstance()) land in sink instead.
+  // Worker threads collect into their own buffers this way and the buffers
+  // are appended in a fixed order afterwards.
+  class Redirect {
+    public:
+    explicit Redirect(Diagnostics &sink);
+    ~Redirect();
+    Redirect(const Redirect &) = delete;
+    Redirect &operator=(const Redirect &) = delete;
+
+    private:
+    Diagnostics *previous;
+  };
 
   const std::vector<Entry> &getEntries() const;
   std::size_t errorCount() const;
@@ -98,6 +119,9 @@ class Diagnostics {
 
 
   private:
+  static thread_local Diagnostics *threadSink;
+
+  mutable std::mutex mutex;
   std::vector<Entry> entries;
   std::string fileName;
   std::size_t error_count = 0;
@@ -1,5 +1,6 @@
 #pragma once
 #include "Symbol.hpp"
+#include <cassert>
 #include <llvm-20/llvm/ADT/DenseMap.h>
 #include <llvm-20/llvm/Analysis/TargetLibraryInfo.h>
 #include <llvm/IR/Function.h>
@@ -7,46 +8,71 @@
 #include <memory>
 #include <sstream>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 template<typename T>
 using sptr = std::shared_ptr<T>;
 using std::unordered_map;
 
-class Environment : public std::enable_shared_from_this<Environment> {
+// The llvm value of every symbol codegen has lowered. Sema numbers the
+// parameters and locals of each function densely (Symbol::slot), so those of
+// the function being lowered sit in a flat frame indexed by slot; globals and
+// functions have no slot and are kept in maps of their own.
+class Environment {
   public:
-  using Env = sptr<Environment>;
+  struct Frame {
+    const FuncSymbol *owner = nullptr;
+    std::vector<llvm::Value *> values;
+  };
   using ValueMap = llvm::DenseMap<const Symbol *, llvm::Value *>;
   using FuncMap = llvm::DenseMap<const FuncSymbol *, llvm::Function *>;
-  explicit Environment(Env parent = nullptr) : parentEnv(std::move(parent)) {}
-  Environment(Env parent, ValueMap valMap, FuncMap funcMap)
-      : parentEnv(std::move(parent)),
-        llvmValRecords(std::move(valMap)),
-        llvmFuncRecords(std::move(funcMap)) {}
+  Environment() = default;
+  explicit Environment(ValueMap globals) : globalRecords(std::move(globals)) {}
+
+  // start the frame of `func`; the enclosing frame is returned, to be handed
+  // back to leaveFunction
+  Frame enterFunction(const FuncSymbol &func) {
+    Frame enclosing = std::move(frame);
+    frame.owner = func.frameOwner();
+    frame.values.assign(func.slotCount(), nullptr);
+    return enclosing;
+  }
+  void leaveFunction(Frame enclosing) { frame = std::move(enclosing); }
 
   void bind(Symbol *sym, llvm::Value *val) {
-    if (sym) {
-      llvmValRecords[sym] = val;
+    if (!sym) {
+      return;
+    }
+    if (sym->hasSlot()) {
+      assert(inFrame(sym) && "local bound outside the function that declares it");
+      if (inFrame(sym)) {
+        frame.values[sym->slot()] = val;
+      }
+      return;
     }
+    globalRecords[sym] = val;
   }
   void bindFunc(const FuncSymbol *sym, llvm::Function *func) {
     if (sym) {
       llvmFuncRecords[sym] = func;
     }
   }
-  llvm::Value *lookup(Symbol *sym) {
-    if (Env env = resolve(sym)) {
-      return env->llvmValRecords[sym];
+  llvm::Value *lookup(const Symbol *sym) const {
+    if (!sym) {
+      return nullptr;
     }
-    return nullptr;
-  }
-  llvm::Function *lookupFunc(FuncSymbol *sym) {
-    if (Env env = resolveFunc(sym)) {
-      return env->llvmFuncRecords[sym];
+    if (sym->hasSlot()) {
+      // a slot means nothing in the frame of another function
+      return inFrame(sym) ? frame.values[sym->slot()] : nullptr;
     }
-    return nullptr;
+    return globalRecords.lookup(sym);
+  }
+  llvm::Function *lookupFunc(const FuncSymbol *sym) const {
+    return llvmFuncRecords.lookup(sym);
   }
   string dump() const {
     std::stringstream sstream;
-    for (auto &valRec: llvmValRecords) {
+    for (auto &valRec: globalRecords) {
       sstream << valRec.first->getName() << ":" << valRec.second->getName().data();
     }
     for (auto &funRec: llvmFuncRecords) {
@@ -56,26 +82,11 @@ class Environment : public std::enable_shared_from_this<Environment> {
   }
 
   private:
-  ValueMap llvmValRecords;
-  FuncMap llvmFuncRecords;
-
-  Env parentEnv;
-  Env resolve(Symbol *sym) {
-    if (llvmValRecords.find(sym) != llvmValRecords.end()) {
-      return shared_from_this();
-    }
-    if (parentEnv) {
-      return parentEnv->resolve(sym);
-    }
-    return nullptr;
-  }
-  Env resolveFunc(FuncSymbol *sym) {
-    if (llvmFuncRecords.find(sym) != llvmFuncRecords.end()) {
-      return shared_from_this();
-    }
-    if (parentEnv) {
-      return parentEnv->resolveFunc(sym);
-    }
-    return nullptr;
+  bool inFrame(const Symbol *sym) const {
+    return sym->definingFunc() == frame.owner && sym->slot() < frame.values.size();
   }
+
+  Frame frame;// of the function being lowered
+  ValueMap globalRecords;
+  FuncMap llvmFuncRecords;
 };
@@ -0,0 +1,89 @@
+#pragma once
+#include "Diagnostics.hpp"
+#include <atomic>
+#include <cstdint>
+#include <llvm-20/llvm/ADT/DenseMapInfo.h>
+#include <llvm-20/llvm/ADT/StringMap.h>
+#include <llvm-20/llvm/Support/MathExtras.h>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// A dense id for an interned identifier. Id 0 is the empty name and doubles
+// as "no identifier".
+struct Ident {
+  uint32_t id = 0;
+
+  bool operator==(Ident other) const { return id == other.id; }
+  bool operator!=(Ident other) const { return id != other.id; }
+  explicit operator bool() const { return id != 0; }
+};
+
+// Every identifier is interned once, when it is lexed; later phases key
+// their tables on the id and only go back to the spelling for output.
+// Lexing and parsing run on several threads, so the table is split into
+// shards by hash, each with a lock of its own that hits only take shared.
+// Spellings are kept in chunks that are never moved, so spelling() reads them
+// without a lock.
+class Interner {
+  public:
+  Interner();
+  Interner(const Interner &) = delete;
+  Interner &operator=(const Interner &) = delete;
+  ~Interner();
+
+  Ident intern(std::string_view text);
+  // the id of text if it was ever interned, otherwise Ident{}
+  Ident find(std::string_view text) const;
+  const std::string &spelling(Ident ident) const {
+    auto [chunk, index] = locate(ident.id);
+    return chunks[chunk].load(std::memory_order_acquire)[index];
+  }
+  std::size_t size() const { return count.load(std::memory_order_acquire); }
+
+  private:
+  static constexpr unsigned shardCount = 16;
+  // chunk k holds 2^(k + firstChunkBits) spellings
+  static constexpr unsigned firstChunkBits = 10;
+  static constexpr unsigned chunkCount = 33 - firstChunkBits;
+
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    llvm::StringMap<uint32_t> ids;
+  };
+
+  static std::pair<unsigned, uint32_t> locate(uint32_t id) {
+    const uint64_t n = uint64_t(id) + (uint64_t(1) << firstChunkBits);
+    const unsigned chunk = llvm::Log2_64(n) - firstChunkBits;
+    return {chunk, static_cast<uint32_t>(n - (uint64_t(1) << (chunk + firstChunkBits)))};
+  }
+  Shard &shardFor(std::string_view text) const;
+  // stores the spelling of a new identifier and returns its id
+  uint32_t append(std::string_view text);
+
+  mutable Shard shards[shardCount];
+  std::mutex appendMutex;
+  std::atomic<uint32_t> count{0};
+  std::atomic<std::string *> chunks[chunkCount] = {};
+};
+
+using Idents = Singleton<Interner>;
+
+inline Ident intern(std::string_view text) {
+  return Idents::getInstance()->intern(text);
+}
+inline const std::string &spelling(Ident ident) {
+  return Idents::getInstance()->spelling(ident);
+}
+
+namespace llvm {
+  template<>
+  struct DenseMapInfo<Ident> {
+    static Ident getEmptyKey() { return Ident{~0u}; }
+    static Ident getTombstoneKey() { return Ident{~0u - 1}; }
+    static unsigned getHashValue(Ident ident) { return ident.id * 37u; }
+    static bool isEqual(Ident a, Ident b) { return a == b; }
+  };
+}// namespace llvm
@@ -5,19 +5,19 @@
 #include "llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
 #include "llvm/ExecutionEngine/Orc/ExecutorProcessControl.h"
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
-#include "llvm/ExecutionEngine/Orc/IRTransformLayer.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "llvm/ExecutionEngine/Orc/Mangling.h"
 #include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/IRReader/IRReader.h"
-#include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/Error.h"
-#include <llvm/Analysis/AliasAnalysis.h>
 #include <llvm/ExecutionEngine/Orc/ExecutorProcessControl.h>
 #include <llvm/Support/InitLLVM.h>
 #include <memory>
+#include <vector>
 template<typename T>
 using uptr = std::unique_ptr<T>;
 template<typename T>
@@ -33,6 +33,8 @@ class JIT {
   JIT(CodeGen &ir_generator_) : ir_generator(ir_generator_) {}
   uptr<llvm::Module> loadModule();
   llvm::Error run(uptr<llvm::Module> module, uptr<llvm::LLVMContext> ctx, int argc, char *argv[]);
+  // modules lowered separately are linked by the JIT itself
+  llvm::Error run(std::vector<llvm::orc::ThreadSafeModule> modules, int argc, char *argv[]);
 };
 
 //using orc api to build a jit from scratch
@@ -54,14 +56,17 @@ class CatJIT {
   MangleAndInterner Mangle;
   uptr<RTDyldObjectLinkingLayer> ObjectLinkingLayer;
   uptr<IRCompileLayer> CompileLayer;
-  uptr<IRTransformLayer> OptimizeLayer;
   JITDylib &MainJitDylib;
+  uptr<IndirectStubsManager> Stubs;// created on first use
 
   public:
   ~CatJIT() {
     if (auto Err = MainJitDylib.clear()) {
       llvm::errs() << "Error clearing MainJitDylib: " << Err << "\n";
     }
+    if (auto Err = ES->endSession()) {
+      llvm::errs() << "Error ending the session: " << Err << "\n";
+    }
   }
 
   llvm::orc::JITDylib &getMainJITDylib() {
@@ -96,7 +101,6 @@ class CatJIT {
         Mangle(*ES, DL),
         ObjectLinkingLayer(std::move(createObjectLinkingLayer(*ES, JTMB))),
         CompileLayer(std::move(createCompileLayer(*ES, *ObjectLinkingLayer, std::move(JTMB)))),
-        OptimizeLayer(std::move(createOptIRLayer(*ES, *CompileLayer))),
         MainJitDylib(ES->createBareJITDylib("<main>")) {
     MainJitDylib.addGenerator(llvm::cantFail(DynamicLibrarySearchGenerator::GetForCurrentProcess(DL.getGlobalPrefix())));
   }
@@ -124,41 +128,52 @@ class CatJIT {
     return IRCLayer;
   }
 
-  // using opt layer instead of translate IR to machine code
-  static uptr<llvm::orc::IRTransformLayer> createOptIRLayer(llvm::orc::ExecutionSession &ES, llvm::orc::IRCompileLayer &CompileLayer) {
-    // The optimizeModule() function is an example of a transformation on an IR module.
-    auto OptIRLayer = std::make_unique<llvm::orc::IRTransformLayer>(ES, CompileLayer, optimizeModule);
-    return OptIRLayer;
-  }
-  static llvm::Expected<llvm::orc::ThreadSafeModule> optimizeModule(llvm::orc::ThreadSafeModule TSM, const llvm::orc::MaterializationResponsibility &R) {
-    TSM.withModuleDo([](llvm::Module &M) { 
-            // bool DebugPM = false; 
-            llvm::PassBuilder PB; 
-            llvm::LoopAnalysisManager LAM; 
-            llvm::FunctionAnalysisManager FAM; 
-            llvm::CGSCCAnalysisManager CGAM; 
-            llvm::ModuleAnalysisManager MAM; 
-            FAM.registerPass( [&] { 
-                return PB.buildDefaultAAPipeline(); 
-            }); 
-                PB.registerModuleAnalyses(MAM); 
-                PB.registerCGSCCAnalyses(CGAM); 
-                PB.registerFunctionAnalyses(FAM); 
-                PB.registerLoopAnalyses(LAM); 
-                PB.crossRegisterProxies(LAM, FAM, CGAM, MAM); 
-                llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2); 
-                MPM.run(M, MAM); });
-    return TSM;
-  }
-
+  // modules come in optimized at the level asked for, see Optimizier
   llvm::Error addIRModule(llvm::orc::ThreadSafeModule TSM, llvm::orc::ResourceTrackerSP RT = nullptr) {
     if (!RT) {
       RT = MainJitDylib.getDefaultResourceTracker();
     }
-    return OptimizeLayer->add(RT, std::move(TSM));
+    return CompileLayer->add(RT, std::move(TSM));
   }
 
   llvm::Expected<ExecutorSymbolDef> lookup(llvm::StringRef Name) {
     return ES->lookup({&MainJitDylib}, Mangle(Name.data()));
   }
+  // one lookup materializes everything it needs at once
+  llvm::Expected<SymbolMap> lookup(llvm::ArrayRef<std::string> Names) {
+    SymbolLookupSet Set;
+    for (const auto &Name: Names) {
+      Set.add(Mangle(Name));
+    }
+    return ES->lookup(makeJITDylibSearchOrder(&MainJitDylib), std::move(Set));
+  }
+  SymbolStringPtr mangle(llvm::StringRef Name) { return Mangle(Name); }
+
+  // modules added under a tracker of their own can be removed again
+  ResourceTrackerSP createResourceTracker() { return MainJitDylib.createResourceTracker(); }
+
+  // Functions that are replaced while the program stays loaded are called
+  // through a stub: `Name` is defined as a jump through a pointer, which
+  // updateStub points at the latest body. A new stub jumps nowhere until then.
+  llvm::Error defineStubs(llvm::ArrayRef<std::string> Names) {
+    if (!Stubs) {
+      Stubs = createLocalIndirectStubsManagerBuilder(ES->getTargetTriple())();
+    }
+    const auto Flags = llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable;
+    SymbolMap Symbols;
+    for (const auto &Name: Names) {
+      if (auto Err = Stubs->createStub(Name, ExecutorAddr(), Flags)) {
+        return Err;
+      }
+      Symbols[Mangle(Name)] = Stubs->findStub(Name, true);
+    }
+    return MainJitDylib.define(absoluteSymbols(std::move(Symbols)));
+  }
+  llvm::Error updateStub(llvm::StringRef Name, ExecutorAddr Body) {
+    return Stubs->updatePointer(Name, Body);
+  }
 };
+
+// the runtime functions generated code calls, which live in the compiler, and
+// the C library from the host process
+llvm::Error defineRuntime(CatJIT &Jit);
@@ -1,12 +1,19 @@
 #pragma once
+#include <cstdint>
+// A byte offset into a file registered with the SourceManager. Line and
+// column are only computed when something is printed.
 struct Location {
-  int line;
-  int column;
+  static constexpr uint32_t invalidFile = ~0u;
 
-  Location() : line(0), column(0) {}
-  Location(int l, int c) : line(l), column(c) {}
+  uint32_t offset;
+  uint32_t fileId;
+
+  Location() : offset(0), fileId(invalidFile) {}
+  Location(uint32_t o, uint32_t f) : offset(o), fileId(f) {}
+
+  bool isValid() const { return fileId != invalidFile; }
 
   static Location builtIn() {
-    return Location{-1, -1};
+    return Location{};
   }
 };
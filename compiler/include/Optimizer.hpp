@@ -2,20 +2,30 @@
 #include <llvm/Analysis/CGSCCPassManager.h>
 #include <llvm/Analysis/LoopAnalysisManager.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/PassInstrumentation.h>
 #include <llvm/IR/PassManager.h>
+#include <llvm/IR/PassTimingInfo.h>
 #include <llvm/Passes/PassBuilder.h>
+#include <memory>
+#include <string>
 class Optimizier {
   public:
-  Optimizier();
+  // timePasses records per-pass timings for --time-report
+  explicit Optimizier(bool timePasses = false);
 
   void optimize(llvm::Module &module, llvm::OptimizationLevel);
-  void save(llvm::Module &module) {
+  void save(llvm::Module &module, const std::string &path = "./opt.ll") {
     std::error_code errorCode;
-    llvm::raw_fd_ostream outLL("./opt.ll", errorCode);
+    llvm::raw_fd_ostream outLL(path, errorCode);
     module.print(outLL, nullptr);
   }
+  // the pass timings collected so far, as LLVM's table or as JSON members
+  std::string passReport(bool json);
 
   private:
+  // must outlive passBuilder, which keeps a pointer to them
+  llvm::PassInstrumentationCallbacks instrumentation;
+  std::unique_ptr<llvm::TimePassesHandler> timePasses;
   llvm::LoopAnalysisManager loopAM;
   llvm::FunctionAnalysisManager functionAM;
   llvm::CGSCCAnalysisManager cgsccAM;
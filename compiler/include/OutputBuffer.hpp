@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Catime {
+  // Standard output of the running Cat program. Every thread fills a buffer of
+  // its own, so print takes no lock; a buffer is written out when it is full,
+  // when the thread ends and when main returns, or at every newline if stdout
+  // is a terminal. Writes that do not fit go out with one writev together with
+  // what is buffered. The cat_write_* functions print is lowered to all end
+  // up here.
+  class OutputBuffer {
+    public:
+    static constexpr std::size_t capacity = 64 * 1024;
+
+    OutputBuffer();
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+    ~OutputBuffer() { flush(); }
+
+    // the calling thread's buffer
+    static OutputBuffer &current();
+
+    void write(const char *text, std::size_t length) {
+      if (length > capacity - used) {
+        writeThrough(text, length);
+        return;
+      }
+      std::memcpy(data + used, text, length);
+      used += length;
+      if (lineBuffered && std::memchr(text, '\n', length)) {
+        flush();
+      }
+    }
+    void put(char c) {
+      if (used == capacity) {
+        flush();
+      }
+      data[used++] = c;
+      if (lineBuffered && c == '\n') {
+        flush();
+      }
+    }
+    void writeSigned(int64_t value);
+    void writeUnsigned(uint64_t value);
+    void flush();
+
+    private:
+    void writeThrough(const char *text, std::size_t length);
+
+    bool lineBuffered;
+    std::size_t used = 0;
+    char data[capacity];
+  };
+
+  // writes out the calling thread's buffer, when a program run ends
+  inline void flushOutput() { OutputBuffer::current().flush(); }
+}// namespace Catime
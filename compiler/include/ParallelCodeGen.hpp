@@ -0,0 +1,48 @@
+#pragma once
+#include "AST.hpp"
+#include "CodeGen.hpp"
+#include "CodeGenCtx.hpp"
+#include "SemanticCtx.hpp"
+#include <memory>
+
+// Lowers the top-level functions of a checked program on several threads.
+// The main CodeGen lowers everything else (classes and their methods,
+// forward declarations) into its module. Each worker then gets a CodeGenCtx
+// of its own (context, module and builder), declares what the main module
+// defines and lowers a contiguous share of the functions. The modules are
+// not linked: each is optimized on its own and handed to the JIT separately.
+class ParallelCodeGen {
+  public:
+  ParallelCodeGen(CodeGen &header, SemanticCtx &semCtx, unsigned jobs);
+
+  // top-level variables are bound to storage in whatever function was lowered
+  // before them, so such programs are left to the serial CodeGen
+  static bool supports(const Program &program);
+  void run(Program &program);
+  // lower only `selected` of the program's top-level functions, each into a
+  // module of its own so that it can be replaced on its own later
+  void run(Program &program, llvm::ArrayRef<ASTNode *> selected);
+
+  // the worker modules, in source order of the functions they hold
+  vec<CodeGenCtx *> modules() const;
+  // write the worker modules next to ./out.ll as ./out.<n>.ll
+  void save();
+
+  private:
+  // classes, declarations and prototypes into the main module; collects the
+  // top-level functions
+  void lowerHeader(Program &program);
+  void lowerFunctions(Program &program, std::size_t moduleCount);
+
+  struct Worker {
+    uptr<CodeGenCtx> ctx;
+    uptr<CodeGen> gen;
+    ASTList<ASTNode> defs;
+  };
+
+  CodeGen &header;
+  SemanticCtx &semCtx;
+  unsigned jobs;
+  vec<ASTNode *> functions;// top-level FuncDefs, the workers get slices of it
+  vec<Worker> workers;
+};
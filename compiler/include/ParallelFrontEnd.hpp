@@ -0,0 +1,86 @@
+#pragma once
+#include "AST.hpp"
+#include "ASTCache.hpp"
+#include "ASTContext.hpp"
+#include "Diagnostics.hpp"
+#include "SourceBuffer.hpp"
+#include "TokenBuffer.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+// Lexes and parses a set of input files on several threads and merges them
+// into one Program. The files are concatenated in the order they are given,
+// so a definition is visible to the files after it, and earlier files use
+// forward declarations for anything defined later. While a file is parsed
+// its top-level definitions are collected; duplicates across all files are
+// reported in file order, whichever thread finished first.
+//
+// Large files are cut into chunks of whole definitions
+// (Scanner::splitDefinitions) that are lexed and parsed independently. A file
+// any of whose chunks reports a diagnostic is parsed again in one piece, so
+// what gets printed is exactly what the serial parse prints.
+//
+// With an ASTCache, files whose AST is cached are loaded instead of parsed
+// and every file parsed without a diagnostic is stored afterwards.
+class ParallelFrontEnd {
+  public:
+  // files smaller than this are never split
+  static constexpr std::size_t minChunkBytes = 64 * 1024;
+
+  struct Chunk {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    uptr<TokenBuffer> tokens;
+    uptr<ASTContext> astCtx;
+    Program *root = nullptr;
+    // names the chunk defines at global scope, in source order
+    vec<std::pair<Ident, Location>> definitions;
+    uptr<Diagnostics> diags;
+    std::chrono::steady_clock::time_point started, finished;
+    double cpuMs = 0;
+    bool cached = false;// loaded from the AST cache, no tokens
+  };
+
+  struct File {
+    uptr<SourceBuffer> source;
+    uint32_t fileId = 0;
+    vec<Chunk> chunks;// in source order
+    double wallMs = 0;// first chunk started to last chunk finished
+    double cpuMs = 0; // summed over the threads that parsed it
+  };
+
+  explicit ParallelFrontEnd(unsigned jobs, const ASTCache *cache = nullptr) : jobs(jobs), cache(cache) {}
+
+  // directories stand for the .cat files below them, sorted by path
+  static vec<std::string> expandInputs(const vec<std::string> &inputs);
+  // throws std::runtime_error once every file's diagnostics are in Diag
+  Program *run(vec<uptr<SourceBuffer>> sources);
+
+  const vec<File> &getFiles() const { return files; }
+  std::size_t tokenCount() const;
+  std::size_t nodeCount() const;
+  std::size_t bytesAllocated() const;
+  std::size_t cacheHits() const;
+
+  private:
+  // one chunk per file unless split and the file is large enough
+  void splitFile(File &file, bool split) const;
+  void parseChunk(const File &file, Chunk &chunk);
+  // a single chunk holding the cached AST, or no chunks on a miss
+  void loadCached(File &file) const;
+  void storeCached(const File &file) const;
+  static void collectDefinitions(Chunk &chunk);
+  static bool failed(const Chunk &chunk);
+  // calls fn(0) .. fn(count - 1) on up to `jobs` threads
+  void forEachOnPool(std::size_t count, const std::function<void(std::size_t)> &fn) const;
+  void checkDefinitions() const;
+
+  unsigned jobs;
+  const ASTCache *cache;
+  vec<File> files;
+  ASTContext programCtx;// the merged Program node and its definition list
+};
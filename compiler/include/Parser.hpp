@@ -8,8 +8,9 @@
 #include <vector>
 
 #include "AST.hpp"
+#include "ASTContext.hpp"
 #include "Location.hpp"
-#include "Scanner.hpp"
+#include "TokenBuffer.hpp"
 
 using std::initializer_list;
 using std::runtime_error;
@@ -22,45 +23,41 @@ using std::vector;
 
 class Parser {
   public:
-  explicit Parser(Scanner &scanner_) : scanner(scanner_) {}
-  sptr<Program> parse();
+  Parser(const TokenBuffer &tokens_, ASTContext &ctx_) : tokens(tokens_), ctx(ctx_) {}
+  Program *parse();
 
   private:
-  Scanner &scanner;
-  Token currentToken;
-  Token lastToken;
+  const TokenBuffer &tokens;
+  ASTContext &ctx;
+  std::size_t current = 0;
 
   private:
-  uptr<ASTNode> parseDeclarations();
-  uptr<FuncDecl> parseFuncDecl();
-  uptr<FuncDef> parseFuncDef();
-  uptr<Header> parseHeader();
-  vector<uptr<FuncParameterDecl>> parseParameters();
-  uptr<FuncParameterDecl> parseFuncParameterDecl();
-  uptr<FuncParameterType> parseFuncParameterType(bool is_ref);
-  uptr<VarDef> parseVarDef();
-  uptr<ClassDecl> parseClassDef();
-  uptr<Type> parseType();
+  ASTNode *parseDeclarations();
+  FuncDecl *parseFuncDecl();
+  FuncDef *parseFuncDef();
+  Header *parseHeader();
+  ASTList<FuncParameterDecl> parseParameters();
+  FuncParameterDecl *parseFuncParameterDecl();
+  FuncParameterType *parseFuncParameterType(bool is_ref);
+  VarDef *parseVarDef();
+  ClassDecl *parseClassDef();
+  Type *parseType();
   DataType::DataType parseDataType();
-  uptr<Block> parseBlock();
-  uptr<Stmt> parseStmt();
-  uptr<Stmt> parseAssignmentOrProcCall();
-  uptr<Stmt> parseExprStmt();
-  uptr<IfStmt> parseIfStmt();
-  uptr<LoopStmt> parseLoopStmt();
-  uptr<Lval> parseLVal();
-  uptr<Expr> parseCall();
-  uptr<Expr> parseExpr();
-  uptr<Expr> parseLogicalOr();
-  uptr<Expr> parseLogicalAnd();
-  uptr<Expr> parseEquality();
-  uptr<Expr> parseRelational();
-  uptr<Expr> parseAdditive();
-  uptr<Expr> parseMultiplicative();
-  uptr<Expr> parseUnary();
-  uptr<Expr> parsePrimary();
-  std::vector<uptr<Expr>> parseArguments();
-  uptr<Cond> parseCond();
+  Block *parseBlock();
+  Stmt *parseStmt();
+  Stmt *parseAssignmentOrProcCall();
+  Stmt *parseExprStmt();
+  IfStmt *parseIfStmt();
+  LoopStmt *parseLoopStmt();
+  Lval *parseLVal();
+  Expr *parseCall();
+  Expr *parseExpr();
+  // operands joined by binary operators of at least this precedence
+  Expr *parseBinary(int minPrecedence);
+  Expr *parseUnary();
+  Expr *parsePrimary();
+  ASTList<Expr> parseArguments();
+  Cond *parseCond();
   // uptr<Cond> parseLogicalOrCond();
   // uptr<Cond> parseLogicalAndCond();
   // uptr<Cond> parseUnaryCond();
@@ -72,7 +69,7 @@ class Parser {
   bool check(TokenType type);
   Token advance();
   bool isAtEnd();
-  Token peek() const;
+  Token peek(std::size_t ahead = 0) const;
   Token previous() const;
   Token consume(TokenType type, string message);
   Location currentLocation() const;
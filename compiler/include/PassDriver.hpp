@@ -1,15 +1,84 @@
 #pragma once
 
 #include "AST.hpp"
+#include "ControlFlowPass.hpp"
 #include "SemanticCtx.hpp"
 #include "SemanticPass.hpp"
+#include <memory>
+
+// What a top-level definition is known to have once a pass has run over it
+enum PassTraits : unsigned {
+  TypesResolved = 1u << 0,
+  ControlFlowChecked = 1u << 1,
+  IREmitted = 1u << 2,
+};
+
+// A pass that can be fused with others. The driver hands it one top-level
+// definition at a time, after every earlier pass has finished with that
+// definition, so a function is checked and lowered while its nodes are still
+// in cache. finish() runs once all definitions are done.
+class DefinitionPass {
+  public:
+  virtual ~DefinitionPass() = default;
+  virtual const char *name() const = 0;
+  // traits earlier passes must provide
+  virtual unsigned required() const { return 0; }
+  virtual unsigned provided() const { return 0; }
+  virtual void runOnDefinition(ASTNode *def) = 0;
+  virtual void finish(Program &program) {}
+};
+
+class SemanticDefinitionPass : public DefinitionPass {
+  public:
+  explicit SemanticDefinitionPass(SemanticCtx &ctx) : pass(ctx) {}
+  const char *name() const override { return "sema"; }
+  unsigned provided() const override { return TypesResolved; }
+  void runOnDefinition(ASTNode *def) override { pass.analyzeDefinition(def); }
+  void finish(Program &program) override { pass.VerifyEntryPoint(program); }
+
+  private:
+  SemanticPass pass;
+};
+
+class ControlFlowDefinitionPass : public DefinitionPass {
+  public:
+  explicit ControlFlowDefinitionPass(SemanticCtx &ctx) : pass(ctx) {}
+  const char *name() const override { return "controlflow"; }
+  unsigned required() const override { return TypesResolved; }
+  unsigned provided() const override { return ControlFlowChecked; }
+  void runOnDefinition(ASTNode *def) override { pass.walk(def); }
+
+  private:
+  ControlFlowPass pass;
+};
+
 class PassDriver {
   public:
   PassDriver(Program &ast) : astRoot(ast) {}
 
+  // whole-program traversals, one pass at a time
   void runSemanticPass(SemanticCtx &ctx);
   void runControlFlowPass(SemanticCtx &ctx);
+  // Declarations are checked in order on this thread, then function bodies
+  // on `jobs` threads. Each worker layers its own symbol table over the
+  // globals and sees only those declared before the body it checks, so the
+  // result and the diagnostics are the same as for the serial pass.
+  // Bodies of the definitions marked in `unchanged` checked clean in an
+  // earlier build of the same text and are skipped.
+  void runSemanticPass(SemanticCtx &ctx, unsigned jobs, const vec<bool> &unchanged = {});
+
+  // fused pipeline: every added pass runs over one definition before the
+  // next definition is started, in the order the passes were added
+  void addPass(std::unique_ptr<DefinitionPass> pass);
+  void run();
+  // the same in steps, for definitions that are parsed while earlier ones
+  // are lowered: run() on each batch as it arrives, then finish() once
+  void run(ASTList<ASTNode> defs);
+  void finish();
 
   private:
   Program &astRoot;
+  vec<std::unique_ptr<DefinitionPass>> passes;
+  unsigned available = 0;// PassTraits of whatever has run or been added
+  vec<double> wallMs, cpuMs;// per pass, with --time-report
 };
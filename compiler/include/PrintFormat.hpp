@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The format string of print, split at compile time into runs of text and
+// printf conversions. Sema checks the arguments against the conversions and
+// CodeGen lowers each piece to a typed runtime call, so nothing parses the
+// format while the program runs.
+struct FormatPiece {
+  enum class Kind {
+    Text,    // printed as is, %% already folded to %
+    Int,     // %d or %i
+    Unsigned,// %u
+    Char,    // %c
+    Str,     // %s
+    Spec,    // a conversion with flags, a width or a precision, or %o %x %X;
+             // printed through cat_print on its own
+    Invalid  // anything else, Cat has no value for it
+  };
+  Kind kind;
+  std::string text;   // the text, or the whole conversion from its '%'
+  char conversion = 0;// the conversion letter, 0 for text
+};
+
+std::vector<FormatPiece> parseFormat(std::string_view format);
@@ -0,0 +1,59 @@
+#pragma once
+#include "Symbol.hpp"
+#include <cstdint>
+#include <llvm-20/llvm/ADT/DenseMap.h>
+#include <llvm-20/llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Value.h>
+#include <utility>
+#include <vector>
+
+// Puts the promoted locals of the function being lowered straight into SSA
+// form while CodeGen emits it, after Braun et al., "Simple and Efficient
+// Construction of Static Single Assignment Form". Every block remembers the
+// value each local was last given in it; a read in a block with several
+// predecessors becomes a phi, and a block is sealed once all of its
+// predecessors are emitted. Until then reads in it get phis whose operands are
+// filled in by seal(). Phis that turn out to merge a single value are
+// replaced by it.
+class SSABuilder {
+  public:
+  SSABuilder(llvm::IRBuilder<> &builder, const FuncSymbol &func)
+      : builder(builder), owner(func.frameOwner()), types(func.slotCount(), nullptr) {}
+
+  // `sym` lives in registers from now on, as values of `type`
+  void declare(const Symbol &sym, llvm::Type *type) { types[sym.slot()] = type; }
+  bool isPromoted(const Symbol *sym) const {
+    // slots are only meaningful in the function being lowered
+    return sym && sym->hasSlot() && sym->definingFunc() == owner && sym->slot() < types.size() &&
+           types[sym->slot()];
+  }
+
+  // `value` is converted to the local's type if it is an integer of another
+  // width, as a store of it followed by a load would have done
+  void write(const Symbol &sym, llvm::BasicBlock *block, llvm::Value *value);
+  llvm::Value *read(const Symbol &sym, llvm::BasicBlock *block) { return read(sym.slot(), block); }
+  // every predecessor of `block` has been emitted
+  void seal(llvm::BasicBlock *block);
+  // erase the phis that were replaced, once the function is lowered
+  void finish();
+
+  private:
+  llvm::Value *read(uint32_t slot, llvm::BasicBlock *block);
+  llvm::Value *readRecursive(uint32_t slot, llvm::BasicBlock *block);
+  llvm::PHINode *createPhi(uint32_t slot, llvm::BasicBlock *block);
+  llvm::Value *addOperands(uint32_t slot, llvm::PHINode *phi);
+  llvm::Value *removeTrivialPhi(llvm::PHINode *phi);
+
+  llvm::IRBuilder<> &builder;
+  const FuncSymbol *owner;
+  std::vector<llvm::Type *> types;// by slot, null for a local kept in memory
+  llvm::DenseMap<std::pair<llvm::BasicBlock *, uint32_t>, llvm::Value *> defs;
+  llvm::DenseMap<llvm::BasicBlock *, std::vector<std::pair<uint32_t, llvm::PHINode *>>> incompletePhis;
+  llvm::SmallPtrSet<llvm::BasicBlock *, 16> sealed;
+  llvm::SmallPtrSet<llvm::PHINode *, 8> filling;     // getting their operands
+  llvm::DenseMap<llvm::Value *, llvm::Value *> replaced;// defs may still name a removed phi
+  std::vector<llvm::PHINode *> removed;
+};
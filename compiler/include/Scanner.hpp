@@ -2,23 +2,33 @@
 #define SCANNER_HPP_
 
 #include "Token.hpp"
-#include <llvm-20/llvm/ADT/StringMap.h>
+#include "TokenBuffer.hpp"
+#include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
 using std::string;
 using std::vector;
 
 class Scanner {
   private:
-  string source;
-  static const llvm::StringMap<TokenType> keywords;
+  std::string_view source;
+  // unescaped string literals; a deque so views into it stay valid
+  std::deque<string> unescaped;
+  uint32_t fileId;
   size_t start = 0;
   size_t current = 0;
-  int line = 1;
-  int column = 1;
+  size_t end;// scanning stops here, locations stay relative to the whole file
+  uint32_t base = 0;// offset of source in its file, when only a piece of it is at hand
+  const char *cursor() const { return source.data() + current; }
+  const char *limit() const { return source.data() + end; }
+  void moveTo(const char *pos) { current = pos - source.data(); }
+  Location location() const { return Location{base + static_cast<uint32_t>(start), fileId}; }
+  void skipWhitespace();
+  void skipBlockComment();
   char advance();
   Token makeToken(TokenType type);
-  Token makeToken(TokenType type, string value);
+  Token makeToken(TokenType type, std::string_view value);
   bool match(char expected);
 
   Token String();
@@ -33,9 +43,22 @@ class Scanner {
   inline bool isAtEnd() const;
 
   public:
-  explicit Scanner(string source);
+  // the source is not copied and must outlive the scanner and its tokens
+  explicit Scanner(std::string_view source, uint32_t fileId = 0);
+  // lex only [begin, end) of source, e.g. a chunk from splitDefinitions
+  Scanner(std::string_view source, uint32_t fileId, size_t begin, size_t end);
+  // lex a piece of a file that is read as a stream, which starts at `base`
+  Scanner(std::string_view piece, uint32_t fileId, uint32_t base);
   Token scanToken();
-  //vector<Token> scanTokens();
+  // lex the remaining input in one go, up to and including TOKEN_EOF
+  TokenBuffer scanTokens();
+
+  // Offsets at which source can be cut into chunks of whole top-level
+  // definitions, each about chunkBytes long or more; the first is always 0.
+  // A cut is made only after a '}' that closes nesting level 0 and before a
+  // def, decl, class or var, so each chunk lexes and parses on its own.
+  // Braces inside string literals and comments are skipped.
+  static vector<size_t> splitDefinitions(std::string_view source, size_t chunkBytes);
 };
 
 #endif// SCANNER_HPP_
@@ -1,10 +1,16 @@
 #pragma once
 
+#include "Interner.hpp"
 #include <cstddef>
-#include <memory>
+#include <llvm-20/llvm/ADT/FoldingSet.h>
+#include <llvm-20/llvm/Support/Casting.h>
 #include <optional>
 #include <ostream>
+#include <string>
 #include <vector>
+
+// Semantic types are uniqued by the TypeContext: two types are equal exactly
+// when they are the same object, so type checks compare pointers.
 class SemaType {
   public:
   enum class TypeKind {
@@ -21,8 +27,9 @@ class SemaType {
   };
 
   virtual ~SemaType() = default;
+  SemaType(const SemaType &) = delete;
+  SemaType &operator=(const SemaType &) = delete;
   TypeKind getKind() const;
-  virtual bool equals(const SemaType &other) const = 0;// for type-checking
 
   void dump(std::ostream &out) const;
 
@@ -33,7 +40,7 @@ class SemaType {
   TypeKind kind_;
 };
 
-using SemaTypePtr = std::shared_ptr<const SemaType>;
+using SemaTypePtr = const SemaType *;
 
 // ---------- Primitive types ----------
 
@@ -41,31 +48,24 @@ class IntType : public SemaType {
   public:
   IntType() : SemaType(TypeKind::INT) {}
 
-  bool equals(const SemaType &other) const override;
 };
 
 class BoolType : public SemaType {
   public:
   BoolType() : SemaType(TypeKind::BOOL) {}
 
-  bool equals(const SemaType &other) const override;
 };
 
 class CharType : public SemaType {
   public:
   CharType() : SemaType(TypeKind::CHAR) {}
 
-  bool equals(const SemaType &other) const override;
 };
 
+// string literals share one type whatever their length
 class StrType : public SemaType {
   public:
-  StrType(std::size_t length) : SemaType(TypeKind::STR), length_(length) {}
-
-  bool equals(const SemaType &other) const override;
-
-  private:
-  std::size_t length_;
+  StrType() : SemaType(TypeKind::STR) {}
 };
 
 
@@ -73,19 +73,21 @@ class ByteType : public SemaType {
   public:
   ByteType() : SemaType(TypeKind::BYTE) {}
 
-  bool equals(const SemaType &other) const override;
 };
 
 // ---------- Array type ----------
 
-class ArrayType : public SemaType {
+class ArrayType : public SemaType, public llvm::FoldingSetNode {
   public:
   ArrayType(SemaTypePtr elementType, std::optional<std::size_t> size);
+  static bool classof(const SemaType *t) { return t->getKind() == TypeKind::ARRAY; }
 
-  const SemaTypePtr &elementType() const;
+  SemaTypePtr elementType() const;
   std::optional<std::size_t> size() const;
 
-  bool equals(const SemaType &other) const override;
+  void Profile(llvm::FoldingSetNodeID &id) const { Profile(id, elem_, size_); }
+  static void Profile(llvm::FoldingSetNodeID &id, SemaTypePtr elem, std::optional<std::size_t> size);
+
 
   private:
   SemaTypePtr elem_;
@@ -99,14 +101,17 @@ class ArrayType : public SemaType {
 
 // ---------- Function type ----------
 
-class FuncType : public SemaType {
+class FuncType : public SemaType, public llvm::FoldingSetNode {
   public:
   FuncType(SemaTypePtr returnType, std::vector<SemaTypePtr> params);
+  static bool classof(const SemaType *t) { return t->getKind() == TypeKind::FUNC; }
 
-  const SemaTypePtr &returnType() const;
+  SemaTypePtr returnType() const;
   const std::vector<SemaTypePtr> &params() const;
 
-  bool equals(const SemaType &other) const override;
+  void Profile(llvm::FoldingSetNodeID &id) const { Profile(id, ret_, params_); }
+  static void Profile(llvm::FoldingSetNodeID &id, SemaTypePtr ret, const std::vector<SemaTypePtr> &params);
+
 
   private:
   SemaTypePtr ret_;
@@ -119,40 +124,39 @@ class VoidType : public SemaType {
   public:
   VoidType() : SemaType(TypeKind::VOID) {}
 
-  bool equals(const SemaType &other) const override;
 };
 
 // ----------- Class type ---------------------------------------------------------
 
 class ClassType : public SemaType {
   public:
-  ClassType(const std::string &className);
+  ClassType(Ident className);
+  static bool classof(const SemaType *t) { return t->getKind() == TypeKind::CLS; }
   const std::string &className() const;
-  bool equals(const SemaType &other) const override;
+  Ident classIdent() const { return className_; }
 
   private:
-  std::string className_;
+  Ident className_;
 };
 
 class InstanceType : public SemaType {
   public:
-  InstanceType(const std::string &className);
+  InstanceType(Ident className);
+  static bool classof(const SemaType *t) { return t->getKind() == TypeKind::INST; }
   const std::string &className() const;
-  bool equals(const SemaType &other) const override;
-  void setClassName(const std::string &name);
-  const std::string &getClassName() const { return className_; }
+  Ident classIdent() const { return className_; }
 
   private:
-  std::string className_;
+  Ident className_;
 };
 
 SemaTypePtr makeIntType();
 SemaTypePtr makeBoolType();
 SemaTypePtr makeCharType();
-SemaTypePtr makeStrType(std::size_t length = 0);
+SemaTypePtr makeStrType();
 SemaTypePtr makeByteType();
 SemaTypePtr makeVoidType();
 SemaTypePtr makeArrayType(SemaTypePtr elementType, std::optional<std::size_t> size);
 SemaTypePtr makeFuncType(SemaTypePtr returnType, std::vector<SemaTypePtr> params);
-SemaTypePtr makeClassType(const std::string &className);
-SemaTypePtr makeInstanceType(const std::string &className = "");
+SemaTypePtr makeClassType(Ident className);
+SemaTypePtr makeInstanceType(Ident className = Ident{});
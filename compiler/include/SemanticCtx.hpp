@@ -17,14 +17,18 @@ class SemanticCtx {
   std::size_t scopeDepth() const { return symbol_table.scopeDepth(); }
 
   InsertResult declareSymbol(uptr<Symbol> sym, bool isRedeclared = false);
+  // bring a symbol declared earlier (and owned elsewhere) into the current scope
+  InsertResult bindSymbol(Symbol *sym) { return symbol_table.bind(sym); }
+  LookupResult lookup(Ident name) const;
   LookupResult lookup(const llvm::StringRef name) const;
-  LookupResult lookupLocalSymbol(const llvm::StringRef name) const;
-  bool replaceSymbol(const llvm::StringRef name, uptr<Symbol> newSymbol);
+  LookupResult lookupLocalSymbol(Ident name) const;
+  bool replaceSymbol(Ident name, uptr<Symbol> newSymbol);
 
   struct FunctionFrame {
     FuncSymbol *symbol = nullptr;
     SemaTypePtr return_type;
     bool is_procedure = false;
+    uint32_t slots = 0;// parameters and locals numbered so far
   };
 
   void enterFunction(sptr<FunctionFrame> frame);
@@ -1,6 +1,6 @@
 #pragma once
 #include "AST.hpp"
-#include "ASTVisitor.hpp"
+#include "ASTWalker.hpp"
 #include "Location.hpp"
 #include "SemaType.hpp"
 #include "SemanticCtx.hpp"
@@ -10,84 +10,95 @@
 class SemanticCtx;
 
 struct ParamInfo {
-  std::string name;
+  Ident name;
   Location loc;
   SemaTypePtr type;
   Symbol::ParamPass passMode = Symbol::ParamPass::BY_VAL;
 };
 
-class SemanticPass : public AstVisitor {
+class SemanticPass : public AstWalker<SemanticPass> {
   public:
   SemanticPass(SemanticCtx &ctx) : semanticCtx(ctx) {}
 
-  void visit(Type &node) override;
-  void visit(FuncParameterType &node) override;
+  void visit(Type &node);
+  void visit(FuncParameterType &node);
 
-  void visit(Program &node) override;
-  void visit(Header &node) override;
-  void visit(ClassDecl &node) override;
-  void visit(VarDef &node) override;
-  void visit(FuncDecl &node) override;
-  void visit(FuncDef &node) override;
-  void visit(FuncParameterDecl &node) override;
+  void visit(Program &node);
+  void visit(Header &node);
+  void visit(ClassDecl &node);
+  void visit(VarDef &node);
+  void visit(FuncDecl &node);
+  void visit(FuncDef &node);
+  void visit(FuncParameterDecl &node);
 
-  void visit(Block &node) override;
-  void visit(SkipStmt &node) override;
-  void visit(ExitStmt &node) override;
-  void visit(AssignStmt &node) override;
-  void visit(ReturnStmt &node) override;
-  void visit(ProcCall &node) override;
-  void visit(BreakStmt &node) override;
-  void visit(ContinueStmt &node) override;
-  void visit(IfStmt &node) override;
-  void visit(LoopStmt &node) override;
+  void visit(Block &node);
+  void visit(SkipStmt &node);
+  void visit(ExitStmt &node);
+  void visit(AssignStmt &node);
+  void visit(ReturnStmt &node);
+  void visit(ProcCall &node);
+  void visit(BreakStmt &node);
+  void visit(ContinueStmt &node);
+  void visit(IfStmt &node);
+  void visit(LoopStmt &node);
 
-  void visit(IdLVal &node) override;
-  void visit(StringLiteralLVal &node) override;
-  void visit(IndexLVal &node) override;
-  void visit(MemberAccessLVal &node) override;
+  void visit(IdLVal &node);
+  void visit(StringLiteralLVal &node);
+  void visit(IndexLVal &node);
+  void visit(MemberAccessLVal &node);
 
-  void visit(IntConst &node) override;
-  void visit(CharConst &node) override;
-  void visit(TrueConst &node) override;
-  void visit(FalseConst &node) override;
+  void visit(IntConst &node);
+  void visit(CharConst &node);
+  void visit(TrueConst &node);
+  void visit(FalseConst &node);
 
-  void visit(LValueExpr &node) override;
-  void visit(ParenExpr &node) override;
-  void visit(FuncCall &node) override;
-  void visit(MemberAccessExpr &node) override;
-  void visit(MethodCall &node) override;
-  void visit(NewExpr &node) override;
-  void visit(UnaryExpr &node) override;
-  void visit(BinaryExpr &node) override;
-  void visit(ArrayExpr &node) override;
-  void visit(ExprCond &node) override;
+  void visit(LValueExpr &node);
+  void visit(ParenExpr &node);
+  void visit(FuncCall &node);
+  void visit(MemberAccessExpr &node);
+  void visit(MethodCall &node);
+  void visit(NewExpr &node);
+  void visit(UnaryExpr &node);
+  void visit(BinaryExpr &node);
+  void visit(ArrayExpr &node);
+  void visit(ExprCond &node);
+
+  // check one top-level definition; visit(Program) is these plus VerifyEntryPoint
+  void analyzeDefinition(ASTNode *def);
+  void VerifyEntryPoint(const Program &program);
+
+  // analyzeDefinition in two halves. declareDefinition does everything but a
+  // function body and returns the function whose body is still unchecked;
+  // checkBody checks it later, possibly on another pass whose symbol table is
+  // layered over this one's.
+  FuncDef *declareDefinition(ASTNode *def);
+  void checkBody(FuncDef &def);
 
 
   private:
-  static bool isIntType(const SemaTypePtr &t) {
+  static bool isIntType(SemaTypePtr t) {
     return t && t->getKind() == SemaType::TypeKind::INT;
   }
-  static bool isChartype(const SemaTypePtr &t) {
+  static bool isChartype(SemaTypePtr t) {
     return t && t->getKind() == SemaType::TypeKind::CHAR;
   }
-  static bool isBoolType(const SemaTypePtr &t) {
+  static bool isBoolType(SemaTypePtr t) {
     return t && t->getKind() == SemaType::TypeKind::BOOL;
   }
-  static bool isByteType(const SemaTypePtr &t) {
+  static bool isByteType(SemaTypePtr t) {
     return t && t->getKind() == SemaType::TypeKind::BYTE;
   }
-  static bool isArrayType(const SemaTypePtr &t) {
+  static bool isArrayType(SemaTypePtr t) {
     return t && t->getKind() == SemaType::TypeKind::ARRAY;
   }
-  static bool isCharStrCompatible(const SemaTypePtr &a, const SemaTypePtr &b) {
+  static bool isCharStrCompatible(SemaTypePtr a, SemaTypePtr b) {
     if (!a || !b) {
       return false;
     }
     if (a->getKind() != SemaType::TypeKind::STR) {
       return false;
     }
-    auto arr_type = std::dynamic_pointer_cast<const ArrayType>(b);
+    auto arr_type = llvm::dyn_cast<ArrayType>(b);
     if (!arr_type) {
       return false;
     }
@@ -97,29 +108,35 @@ class SemanticPass : public AstVisitor {
     }
     return elem_type->getKind() == SemaType::TypeKind::CHAR;
   }
-  static bool typesEqual(const SemaTypePtr &a, const SemaTypePtr &b) {
+  // types are uniqued, so only str/char[] needs more than a pointer compare
+  static bool typesEqual(SemaTypePtr a, SemaTypePtr b) {
     if (a == b) return true;
-    if (isCharStrCompatible(a, b) || isCharStrCompatible(b, a)) return true;
-    if (!a || !b) return false;
-    return a->equals(*b);
+    return isCharStrCompatible(a, b) || isCharStrCompatible(b, a);
   }
   static bool arrayTypesCompatible(const ArrayType *actual, const ArrayType *expected);
-  static bool typesCompatible(const SemaTypePtr &actual, const SemaTypePtr &expected);
+  static bool typesCompatible(SemaTypePtr actual, SemaTypePtr expected);
   static SemaTypePtr scalarType(DataType::DataType dt);
   bool validateDimension(const std::optional<int> &dim, bool allowUnsized, const Location &loc);
   SemaTypePtr buildArrayType(const Location &loc, SemaTypePtr base, const vec<std::optional<int>> &dims, bool allowUnsizedFirst);
   SemaTypePtr resolveType(const Type &node, bool allowUnsizedFirst = false);
   SemaTypePtr resolveParamType(const FuncParameterType &node, Symbol::ParamPass &pass);
-  static std::string typeToString(const SemaTypePtr &type);
+  static std::string typeToString(SemaTypePtr type);
 
   // Semantic analysis helpers
+  bool noteEntryPoint(ASTNode *def);
+  void checkEntryPoint(FuncDef &mainFunc);
+  FuncSymbol *declareFunction(FuncDef &node);
+  void checkFunctionBody(FuncDef &node, FuncSymbol *fsym);
   bool collectParams(const Header &header, std::vector<ParamInfo> &params);
-  bool signaturesMatch(bool isProcedure, const SemaTypePtr &returnType, const std::vector<ParamInfo> &params, const Symbol *symbol);
-  bool checkArguments(const vec<uptr<Expr>> &args, const std::vector<ParamSymbol *> &params, const std::string &callee, const Location &loc, bool isVarArg);
-
-  //
-  void VerifyEntryPoint(const vec<uptr<ASTNode>> &defs);
+  bool signaturesMatch(bool isProcedure, SemaTypePtr returnType, const std::vector<ParamInfo> &params, const Symbol *symbol);
+  bool checkArguments(ASTList<Expr> args, const std::vector<ParamSymbol *> &params, const std::string &callee, const Location &loc, bool isVarArg);
+  // print's format must be a literal whose conversions match the arguments
+  void checkFormat(ASTList<Expr> args, const Location &loc);
 
   private:
   SemanticCtx &semanticCtx;
+  const Ident ctorIdent = intern("constructor");
+  const Ident mainIdent = intern("main");
+  const Ident printIdent = intern("print");
+  bool hasEntryPoint = false;
 };
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#define CAT_SIMD_SCAN 1
+#endif
+
+// Vectorized character-class skipping for the scanner. The block width is
+// picked at build time: AVX2 when the compiler targets it (see the
+// CAT_NATIVE_ARCH option), SSE2 on any other x86-64, scalar elsewhere.
+// Every routine finishes the last partial block with scalar code.
+namespace simd {
+
+#if defined(__AVX2__)
+  struct Block {
+    static constexpr unsigned width = 32;
+    static constexpr uint32_t all = 0xFFFFFFFFu;
+    __m256i v;
+
+    static Block load(const char *p) {
+      return {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))};
+    }
+    uint32_t eq(char c) const {
+      return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+    }
+    // lo and hi are ASCII, so the signed byte compares are safe
+    static uint32_t inRange(__m256i x, char lo, char hi) {
+      __m256i ge = _mm256_cmpgt_epi8(x, _mm256_set1_epi8(static_cast<char>(lo - 1)));
+      __m256i le = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), x);
+      return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(ge, le)));
+    }
+    uint32_t digit() const { return inRange(v, '0', '9'); }
+    uint32_t alpha() const { return inRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z'); }
+  };
+#elif defined(__SSE2__)
+  struct Block {
+    static constexpr unsigned width = 16;
+    static constexpr uint32_t all = 0xFFFFu;
+    __m128i v;
+
+    static Block load(const char *p) {
+      return {_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))};
+    }
+    uint32_t eq(char c) const {
+      return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+    }
+    static uint32_t inRange(__m128i x, char lo, char hi) {
+      __m128i ge = _mm_cmpgt_epi8(x, _mm_set1_epi8(static_cast<char>(lo - 1)));
+      __m128i le = _mm_cmplt_epi8(x, _mm_set1_epi8(static_cast<char>(hi + 1)));
+      return static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(ge, le)));
+    }
+    uint32_t digit() const { return inRange(v, '0', '9'); }
+    uint32_t alpha() const { return inRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'); }
+  };
+#endif
+
+  inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\0';
+  }
+  inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+  inline bool isIdentChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || isDigit(c);
+  }
+
+  namespace detail {
+    // Run whole blocks until stopMask reports a hit; returns the hit, or the
+    // start of the final partial block.
+    template<typename StopFn>
+    inline const char *blocks(const char *p, const char *end, StopFn stopMask) {
+#ifdef CAT_SIMD_SCAN
+      while (static_cast<std::size_t>(end - p) >= Block::width) {
+        uint32_t stop = stopMask(Block::load(p));
+        if (stop) {
+          return p + __builtin_ctz(stop);
+        }
+        p += Block::width;
+      }
+#endif
+      return p;
+    }
+  }// namespace detail
+
+  // whitespace as the scanner defines it: ' ', \t, \r, \n and NUL
+  inline const char *skipWhitespace(const char *p, const char *end) {
+#ifdef CAT_SIMD_SCAN
+    p = detail::blocks(p, end, [](const Block &b) {
+      return ~(b.eq(' ') | b.eq('\t') | b.eq('\r') | b.eq('\n') | b.eq('\0')) & Block::all;
+    });
+#endif
+    while (p < end && isSpace(*p)) {
+      ++p;
+    }
+    return p;
+  }
+
+  // [A-Za-z0-9_]*
+  inline const char *skipIdentifier(const char *p, const char *end) {
+#ifdef CAT_SIMD_SCAN
+    p = detail::blocks(p, end, [](const Block &b) {
+      return ~(b.alpha() | b.digit() | b.eq('_')) & Block::all;
+    });
+#endif
+    while (p < end && isIdentChar(*p)) {
+      ++p;
+    }
+    return p;
+  }
+
+  // [0-9]*
+  inline const char *skipDigits(const char *p, const char *end) {
+#ifdef CAT_SIMD_SCAN
+    p = detail::blocks(p, end, [](const Block &b) { return ~b.digit() & Block::all; });
+#endif
+    while (p < end && isDigit(*p)) {
+      ++p;
+    }
+    return p;
+  }
+
+  // first c in [p, end), or end
+  inline const char *findChar(const char *p, const char *end, char c) {
+#ifdef CAT_SIMD_SCAN
+    p = detail::blocks(p, end, [c](const Block &b) { return b.eq(c); });
+#endif
+    while (p < end && *p != c) {
+      ++p;
+    }
+    return p;
+  }
+
+  // first '{', '}', '"' or '/' in [p, end): all Scanner::splitDefinitions
+  // has to look at
+  inline const char *findStructural(const char *p, const char *end) {
+#ifdef CAT_SIMD_SCAN
+    p = detail::blocks(p, end, [](const Block &b) {
+      return b.eq('{') | b.eq('}') | b.eq('"') | b.eq('/');
+    });
+#endif
+    while (p < end && *p != '{' && *p != '}' && *p != '"' && *p != '/') {
+      ++p;
+    }
+    return p;
+  }
+
+}// namespace simd
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Read-only view of a source file. Regular files are memory-mapped so the
+// scanner can hand out lexemes that point straight into the file contents;
+// anything that cannot be mapped (pipes, empty files) is read into memory.
+class SourceBuffer {
+  public:
+  static std::unique_ptr<SourceBuffer> openFile(const std::string &path);
+  static std::unique_ptr<SourceBuffer> fromString(std::string source, std::string name = "<memory>");
+
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+  ~SourceBuffer();
+
+  std::string_view text() const { return {data, size}; }
+  const std::string &getName() const { return name; }
+  bool isMapped() const { return mapped; }
+
+  private:
+  SourceBuffer() = default;
+
+  const char *data = nullptr;
+  std::size_t size = 0;
+  bool mapped = false;
+  std::string owned;
+  std::string name;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include "Diagnostics.hpp"
+#include "Location.hpp"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Owns the list of input files and turns offset-based Locations back into
+// line/column pairs. A file's line-start table is built the first time one
+// of its locations is resolved.
+class SourceManager {
+  public:
+  struct LineColumn {
+    int line = 0;
+    int column = 0;
+  };
+
+  // the text is not copied and must stay alive while locations into it
+  // may still be printed
+  uint32_t addFile(std::string name, std::string_view text);
+  // the file was read again: locations into it now resolve against text,
+  // which replaces the old one under the same contract
+  void setText(uint32_t fileId, std::string_view text);
+  // A file read as a stream, whose text is never at hand as a whole. Its
+  // line table is built from the pieces handed to addLines in order, which
+  // need not stay alive; getText is empty for it.
+  uint32_t addStream(std::string name);
+  void addLines(uint32_t fileId, std::string_view piece, uint32_t base);
+
+  LineColumn resolve(const Location &loc) const;
+  const std::string &getFileName(uint32_t fileId) const;
+  std::string_view getText(uint32_t fileId) const;
+  // "file:line:col", or "<builtin>" for locations outside any file
+  std::string format(const Location &loc) const;
+
+  private:
+  struct File {
+    std::string name;
+    std::string_view text;
+    std::vector<uint32_t> lineStarts;
+    bool scanned = false;
+  };
+  const File *lineTable(uint32_t fileId) const;
+
+  mutable std::mutex mutex;
+  mutable std::deque<File> files;
+};
+
+using SrcMgr = Singleton<SourceManager>;
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Source that is read front to back in pieces rather than held whole: stdin,
+// a pipe, or a file too large to keep around with its AST. next() hands out
+// runs of whole top-level definitions, cut where Scanner::splitDefinitions
+// cuts, so no token, comment or definition straddles two runs. Only the
+// unfinished definition at the end of a run is kept for the next one, so
+// memory follows the largest definition rather than the input.
+class SourceStream {
+  public:
+  // about how much text next() hands out at a time
+  static constexpr std::size_t chunkBytes = 256 * 1024;
+
+  // "-" reads stdin; nullptr if the file cannot be opened
+  static std::unique_ptr<SourceStream> open(const std::string &path);
+
+  SourceStream(const SourceStream &) = delete;
+  SourceStream &operator=(const SourceStream &) = delete;
+  ~SourceStream();
+
+  // the next run of definitions, empty at the end of the input; valid until
+  // the next call. Throws std::runtime_error if reading fails.
+  std::string_view next();
+  // where the text last returned by next() starts in the input
+  uint32_t offset() const { return base; }
+  const std::string &getName() const { return name; }
+
+  private:
+  SourceStream() = default;
+  void refill();
+
+  int fd = -1;
+  bool eof = false;
+  std::string name;
+  std::string pending;   // read and not yet handed out, after the last run
+  std::size_t handed = 0;// length of the last run, still at the front of pending
+  uint32_t base = 0;
+};
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "AST.hpp"
+#include "Interner.hpp"
 #include "Location.hpp"
 #include "SemaType.hpp"
+#include <cstdint>
+#include <llvm-20/llvm/ADT/DenseMap.h>
 #include <ostream>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 template<typename T>
@@ -30,11 +32,13 @@ class Symbol {
 
   virtual ~Symbol() = default;
   const std::string &getName() const;
-  void setName(const std::string &newname) { name_ = newname; }
+  Ident getIdent() const { return name_; }
+  void setName(Ident newname) { name_ = newname; }
   SymKind getKind() const;
 
-  const SemaTypePtr &getType() const;
+  SemaTypePtr getType() const;
   Location getLocation() const;
+  void setLocation(Location loc) { loc_ = loc; }
 
   FuncSymbol *definingFunc() const;
   void setDefiningFunc(FuncSymbol *f);
@@ -50,13 +54,23 @@ class Symbol {
   void markDefined();
   bool isDefined() const;
 
+  // Parameters and locals are numbered densely within their function, see
+  // FuncSymbol::slotCount; globals, fields and functions have no slot.
+  static constexpr uint32_t noSlot = ~0u;
+  bool hasSlot() const { return slot_ != noSlot; }
+  uint32_t slot() const { return slot_; }
+  void setSlot(uint32_t slot) { slot_ = slot; }
+  // set for a local passed to a by-ref parameter, codegen keeps it in memory
+  bool isAddressTaken() const { return addressTaken_; }
+  void markAddressTaken() { addressTaken_ = true; }
+
   void dump(std::ostream &out) const;
 
   protected:
-  Symbol(std::string name, SymKind kind, SemaTypePtr type, Location loc);
+  Symbol(Ident name, SymKind kind, SemaTypePtr type, Location loc);
 
   private:
-  std::string name_;
+  Ident name_;
   SymKind kind_;
   SemaTypePtr type_;
   Location loc_;
@@ -64,29 +78,31 @@ class Symbol {
   ClassSymbol *definingClass_ = nullptr;
   bool isForward_ = false;
   bool isDefined_ = false;
+  uint32_t slot_ = noSlot;
+  bool addressTaken_ = false;
 };
 
 class VarSymbol : public Symbol {
   public:
-  VarSymbol(std::string name, SemaTypePtr type, Location loc)
-      : Symbol(std::move(name), SymKind::VAR, std::move(type), loc) {};
+  VarSymbol(Ident name, SemaTypePtr type, Location loc)
+      : Symbol(name, SymKind::VAR, std::move(type), loc) {};
 
   protected:
-  VarSymbol(std::string name, SymKind kind, SemaTypePtr type, Location loc)
+  VarSymbol(Ident name, SymKind kind, SemaTypePtr type, Location loc)
       : Symbol(name, kind, std::move(type), loc) {}
 };
 
 // Field is a variable defined in a class
 class FieldSymbol : public VarSymbol {
   public:
-  FieldSymbol(std::string name, SemaTypePtr type, Location loc)
-      : VarSymbol(std::move(name), SymKind::FIELD, std::move(type), loc) {};
+  FieldSymbol(Ident name, SemaTypePtr type, Location loc)
+      : VarSymbol(name, SymKind::FIELD, std::move(type), loc) {};
 };
 
 class ParamSymbol : public Symbol {
   public:
-  ParamSymbol(std::string name, SemaTypePtr type, ParamPass pass, Location loc)
-      : Symbol(std::move(name), SymKind::PARAM, std::move(type), loc), pass_(pass) {};
+  ParamSymbol(Ident name, SemaTypePtr type, ParamPass pass, Location loc)
+      : Symbol(name, SymKind::PARAM, std::move(type), loc), pass_(pass) {};
   ParamPass getPass() const;
 
   private:
@@ -96,8 +112,11 @@ class ParamSymbol : public Symbol {
 // Note: A FuncSymbol's type is its signature type (return type + parameter types)
 class FuncSymbol : public Symbol {
   public:
-  FuncSymbol(std::string name, SemaTypePtr sigType, bool isProc, bool isVariadic, Location loc)
-      : Symbol(std::move(name), SymKind::FUNC, std::move(sigType), loc), isProcedure_(isProc), isVariadic_(isVariadic) {};
+  FuncSymbol(Ident name, SemaTypePtr sigType, bool isProc, bool isVariadic, Location loc)
+      : Symbol(name, SymKind::FUNC, std::move(sigType), loc), isProcedure_(isProc), isVariadic_(isVariadic) {};
+  static bool classof(const Symbol *sym) {
+    return sym->getKind() == SymKind::FUNC || sym->getKind() == SymKind::METHOD;
+  }
 
   void addParam(ParamSymbol *param);
   const std::vector<ParamSymbol *> &getParams() const;
@@ -106,41 +125,61 @@ class FuncSymbol : public Symbol {
   bool isBuiltin() const;
   void setBuiltin(bool is_builtin);
   void clearParams();
+  // parameters and locals of the body, set once it is checked
+  uint32_t slotCount() const { return slotCount_; }
+  void setSlotCount(uint32_t count) { slotCount_ = count; }
+  // what the slotted symbols of the body name as their defining function; a
+  // method keeps that of the function symbol it was converted from
+  const FuncSymbol *frameOwner() const { return frameOwner_ ? frameOwner_ : this; }
+  void setFrameOwner(const FuncSymbol *owner) { frameOwner_ = owner; }
 
   protected:
   // Protected constructor for derived classes (e.g., MethodSymbol)
-  FuncSymbol(std::string name, SymKind kind, SemaTypePtr sigType, bool isProc, Location loc)
-      : Symbol(std::move(name), kind, std::move(sigType), loc), isProcedure_(isProc), isVariadic_(false) {};
+  FuncSymbol(Ident name, SymKind kind, SemaTypePtr sigType, bool isProc, Location loc)
+      : Symbol(name, kind, std::move(sigType), loc), isProcedure_(isProc), isVariadic_(false) {};
 
   private:
   std::vector<ParamSymbol *> params_;
   bool isProcedure_;
   bool isVariadic_;
   bool isBuiltin_{false};
+  uint32_t slotCount_ = 0;
+  const FuncSymbol *frameOwner_ = nullptr;
 };
 
 // Method is a function defined in a class (has implicit 'this' parameter)
 class MethodSymbol : public FuncSymbol {
   public:
-  MethodSymbol(std::string name, SemaTypePtr sigType, bool isProc, Location loc)
-      : FuncSymbol(std::move(name), SymKind::METHOD, sigType, isProc, loc) {}
+  MethodSymbol(Ident name, SemaTypePtr sigType, bool isProc, Location loc)
+      : FuncSymbol(name, SymKind::METHOD, sigType, isProc, loc) {}
+  static bool classof(const Symbol *sym) { return sym->getKind() == SymKind::METHOD; }
 };
 
 class ClassSymbol : public Symbol {
   public:
-  using MemberMap = std::unordered_map<std::string, Symbol *>;
-  ClassSymbol(std::string name, SemaTypePtr classType, Location loc)
-      : Symbol(std::move(name), SymKind::CLASS, std::move(classType), loc) {};
+  using MemberMap = llvm::DenseMap<Ident, Symbol *>;
+  ClassSymbol(Ident name, SemaTypePtr classType, Location loc)
+      : Symbol(name, SymKind::CLASS, std::move(classType), loc) {};
+  static bool classof(const Symbol *sym) { return sym->getKind() == SymKind::CLASS; }
   void addField(FieldSymbol *field) {
     fields_.push_back(field);
-    memberMap_[field->getName()] = field;
+    memberMap_[field->getIdent()] = field;
   }
   void addMethod(MethodSymbol *method) {
     methods_.push_back(method);
-    memberMap_[method->getName()] = method;
+    memberMap_[method->getIdent()] = method;
   }
   const vec<FieldSymbol *> &getFields() const { return fields_; }
   const vec<MethodSymbol *> &getMethods() const { return methods_; }
+  // nullptr when the class has no such member
+  FieldSymbol *findField(Ident name) const {
+    Symbol *member = findMember(name);
+    return member && member->isField() ? static_cast<FieldSymbol *>(member) : nullptr;
+  }
+  MethodSymbol *findMethod(Ident name) const {
+    Symbol *member = findMember(name);
+    return member && member->isMethod() ? static_cast<MethodSymbol *>(member) : nullptr;
+  }
   void clearAll() {
     fields_.clear();
     methods_.clear();
@@ -148,6 +187,11 @@ class ClassSymbol : public Symbol {
   }
 
   private:
+  Symbol *findMember(Ident name) const {
+    auto it = memberMap_.find(name);
+    return it == memberMap_.end() ? nullptr : it->second;
+  }
+
   vec<FieldSymbol *> fields_;
   vec<MethodSymbol *> methods_;
   MemberMap memberMap_;
@@ -1,24 +1,47 @@
 #pragma once
 #include "AST.hpp"
-#include "Scope.hpp"
+#include "Diagnostics.hpp"
+#include "Interner.hpp"
 #include "Symbol.hpp"
 #include <cstddef>
+#include <cstdint>
+#include <llvm-20/llvm/ADT/SmallVector.h>
+#include <llvm-20/llvm/ADT/StringRef.h>
 
+// All scopes share one table. Each interned identifier owns a stack of the
+// bindings that currently shadow each other, innermost on top, indexed by
+// its id; lookup is one array access however deep the nesting is.
+// Declarations are recorded in an undo log that endScope() unwinds.
+//
+// A table can be layered over a read-only table of globals: names it does not
+// bind itself are looked up there. Function bodies are checked on worker
+// threads this way, each worker seeing only the globals declared before the
+// definition it is working on.
 class SymbolTable {
   public:
   SymbolTable();
+  explicit SymbolTable(const SymbolTable *globals);
 
   InsertResult declare(uptr<Symbol> symbol);
+  // bind a symbol owned elsewhere in the current scope
+  InsertResult bind(Symbol *symbol);
+  LookupResult lookup(Ident name) const;
+  LookupResult lookupLocal(Ident name) const;
+  bool replaceSymbol(Ident name, uptr<Symbol> newSymbol);
+  // names that were never interned cannot be bound
   LookupResult lookup(const llvm::StringRef name) const;
-  bool replaceSymbol(const llvm::StringRef name, uptr<Symbol> newSymbol);
 
   void beginScope();
   void endScope();
 
-  Scope &currentScope();
-  const Scope &currentScope() const;
-
   std::size_t scopeDepth() const;
+  std::size_t symbolCount() const { return symbols_.size(); }
+  // number of bindings made so far; at global scope this only grows
+  std::size_t declarationCount() const { return undo_.size(); }
+  // only the first `count` declarations of the globals table are visible
+  void limitGlobals(std::size_t count) { globalsVisible_ = count; }
+  // take over the symbols another table owns, AST nodes still point at them
+  void adopt(SymbolTable &other);
 
   void dump(std::ostream &out) const {
     for (std::size_t i = 0; i < symbols_.size(); ++i) {
@@ -29,6 +52,18 @@ class SymbolTable {
   }
 
   private:
-  vec<sptr<Scope>> scopes_;
+  struct Binding {
+    Symbol *symbol;
+    uint32_t depth;
+    uint32_t seq;// position in undo_ when it was made
+  };
+  const Binding *top(Ident name) const;
+  LookupResult lookupGlobal(Ident name) const;
+
+  vec<llvm::SmallVector<Binding, 2>> bindings_;// indexed by Ident::id
+  vec<uint32_t> undo_;                         // ids declared, in order
+  vec<std::size_t> scopeStarts_;               // undo_ size at each beginScope
   vec<uptr<Symbol>> symbols_;
+  const SymbolTable *globals_ = nullptr;
+  std::size_t globalsVisible_ = 0;
 };
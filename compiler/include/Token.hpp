@@ -1,10 +1,13 @@
 #ifndef TOKEN_HPP_
 #define TOKEN_HPP_
+#include "Interner.hpp"
 #include "Location.hpp"
+#include <cstdint>
 #include <string>
+#include <string_view>
 using std::string;
 using std::to_string;
-typedef enum {
+typedef enum : uint8_t {
   LEFT_PAREN, // (
   RIGHT_PAREN,// )
   LEFT_BRACE, // {
@@ -90,20 +93,88 @@ typedef enum {
   TOKEN_EOF
 } TokenType;
 
+// Map an identifier to its keyword token, or IDENTIFIER. Dispatches on
+// length and first character so each lookup is at most one compare.
+constexpr TokenType keywordType(std::string_view text) {
+  auto is = [&](std::string_view kw, TokenType type) {
+    return text == kw ? type : IDENTIFIER;
+  };
+  switch (text.size()) {
+    case 2:
+      switch (text[0]) {
+        case 'i': return is("if", IF);
+        case 'o': return is("or", OR);
+      }
+      break;
+    case 3:
+      switch (text[0]) {
+        case 'a': return is("and", AND);
+        case 'd': return is("def", DEF);
+        case 'f': return is("for", FOR);
+        case 'i': return is("int", INT);
+        case 'n': return is("new", NEW);
+        case 'r': return is("ref", REF);
+        case 's': return is("str", STR);
+        case 't': return is("try", TRY);
+        case 'v': return is("var", VAR);
+      }
+      break;
+    case 4:
+      switch (text[0]) {
+        case 'b': return is("bool", BOOL);
+        case 'c': return is("char", CHAR);
+        case 'd': return is("decl", DECL);
+        case 'e': return text[2] == 'i' ? is("elif", ELIF) : is("else", ELSE);
+        case 'l': return is("list", LIST);
+        case 'n': return is("none", NONE);
+        case 's': return is("self", SELF);
+        case 't': return is("true", TRUE);
+      }
+      break;
+    case 5:
+      switch (text[0]) {
+        case 'b': return is("break", BREAK);
+        case 'c': return is("class", CLASS);
+        case 'f': return is("false", FALSE);
+        case 's': return is("super", SUPER);
+        case 't': return is("throw", THROW);
+        case 'w': return is("while", WHILE);
+      }
+      break;
+    case 6:
+      switch (text[0]) {
+        case 'd': return is("double", DOUBLE);
+        case 'l': return is("lambda", LAMBDA);
+        case 'r': return is("return", RETURN);
+      }
+      break;
+    case 8:
+      return is("continue", CONTINUE);
+  }
+  return IDENTIFIER;
+}
+
+static_assert(keywordType("elif") == ELIF && keywordType("else") == ELSE);
+static_assert(keywordType("continue") == CONTINUE && keywordType("contin") == IDENTIFIER);
+
 class Token {
   public:
   Token()
-      : type(TokenType::NONE), lexeme(""), location(-1, -1) {}
-  Token(TokenType type, string lexeme, int line, int column = -1)
-      : type(type), lexeme(lexeme), location(line, column) {}
+      : type(TokenType::NONE), lexeme(""), location() {}
+  Token(TokenType type, std::string_view lexeme, Location location, Ident ident = Ident{})
+      : type(type), lexeme(lexeme), location(location), ident(ident) {}
 
   string toString() {
-    auto msg = to_string(type) + " lexeme: '" + lexeme + "'";
+    auto msg = to_string(type) + " lexeme: '" + string(lexeme) + "'";
     return msg;
   }
   TokenType type;
-  string lexeme;
+  // points into the scanned source, or into the scanner's storage for
+  // string literals that needed unescaping
+  std::string_view lexeme;
   Location location;
+  // interned name, set for IDENTIFIER tokens only
+  Ident ident;
 };
 
 #endif// TOKEN_HPP_
@@ -0,0 +1,58 @@
+#ifndef TOKEN_BUFFER_HPP_
+#define TOKEN_BUFFER_HPP_
+
+#include "Location.hpp"
+#include "Token.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A fully lexed source file, stored as parallel arrays so the parser can
+// walk it by index. Lexemes are offset+length slices of the source; string
+// literals that had escapes point into the buffer's own storage instead.
+class TokenBuffer {
+  public:
+  TokenBuffer(std::string_view source, uint32_t fileId, uint32_t base = 0)
+      : source(source), fileId(fileId), base(base) {}
+
+  void push(const Token &token);
+
+  std::size_t size() const { return kinds.size(); }
+  TokenType kind(std::size_t i) const { return kinds[i]; }
+  Location location(std::size_t i) const { return Location{base + offsets[i], fileId}; }
+  std::string_view lexeme(std::size_t i) const {
+    if (lengths[i] & UNESCAPED) {
+      return unescaped[lengths[i] & ~UNESCAPED];
+    }
+    // a literal's location is its opening quote, the text follows it
+    const bool quoted = lengths[i] & QUOTED;
+    return source.substr(offsets[i] + quoted, lengths[i] & ~QUOTED);
+  }
+  Ident ident(std::size_t i) const { return Ident{idents[i]}; }
+  Token get(std::size_t i) const {
+    return Token(kinds[i], lexeme(i), location(i), ident(i));
+  }
+
+  void reserve(std::size_t n);
+  void dump(std::ostream &os) const;
+
+  private:
+  static constexpr uint32_t UNESCAPED = 1u << 31;
+  static constexpr uint32_t QUOTED = 1u << 30;
+
+  std::string_view source;
+  uint32_t fileId;
+  uint32_t base;// offset of source in the file, offsets are relative to source
+  std::vector<TokenType> kinds;
+  std::vector<uint32_t> offsets;
+  // the lexeme length, with QUOTED if it starts one past the token's location;
+  // for unescaped literals: UNESCAPED | index into unescaped
+  std::vector<uint32_t> lengths;
+  // interned id of IDENTIFIER tokens, 0 for everything else
+  std::vector<uint32_t> idents;
+  std::vector<string> unescaped;
+};
+
+#endif// TOKEN_BUFFER_HPP_
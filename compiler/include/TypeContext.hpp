@@ -0,0 +1,56 @@
+#pragma once
+#include "Diagnostics.hpp"
+#include "SemaType.hpp"
+#include <cstddef>
+#include <llvm-20/llvm/ADT/DenseMap.h>
+#include <llvm-20/llvm/ADT/FoldingSet.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Owns every SemaType and hands out one object per distinct type.
+// Primitives are members; arrays and signatures are hash-consed on their
+// (already unique) component pointers, classes and instances on the
+// interned class name.
+// Types live as long as the compiler does. Sema workers build types
+// concurrently, so the composite factories take a lock; primitives do not.
+class TypeContext {
+  public:
+  SemaTypePtr intType() const { return &intTy; }
+  SemaTypePtr boolType() const { return &boolTy; }
+  SemaTypePtr charType() const { return &charTy; }
+  SemaTypePtr strType() const { return &strTy; }
+  SemaTypePtr byteType() const { return &byteTy; }
+  SemaTypePtr voidType() const { return &voidTy; }
+
+  SemaTypePtr arrayType(SemaTypePtr elementType, std::optional<std::size_t> size);
+  SemaTypePtr funcType(SemaTypePtr returnType, std::vector<SemaTypePtr> params);
+  SemaTypePtr classType(Ident className);
+  SemaTypePtr instanceType(Ident className);
+
+  private:
+  template<typename T>
+  T *own(std::unique_ptr<T> type) {
+    T *raw = type.get();
+    owned.push_back(std::move(type));
+    return raw;
+  }
+
+  std::mutex mutex;
+  IntType intTy;
+  BoolType boolTy;
+  CharType charTy;
+  StrType strTy;
+  ByteType byteTy;
+  VoidType voidTy;
+
+  llvm::FoldingSet<ArrayType> arrays;
+  llvm::FoldingSet<FuncType> funcs;
+  llvm::DenseMap<Ident, const ClassType *> classes;
+  llvm::DenseMap<Ident, const InstanceType *> instances;
+  std::vector<std::unique_ptr<SemaType>> owned;
+};
+
+using TypeCtx = Singleton<TypeContext>;
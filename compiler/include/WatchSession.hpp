@@ -0,0 +1,59 @@
+#pragma once
+#include "AST.hpp"
+#include "Jit.hpp"
+#include "SourceBuffer.hpp"
+#include <cstdint>
+#include <llvm-20/llvm/ADT/DenseMap.h>
+#include <llvm-20/llvm/ADT/StringSet.h>
+#include <llvm-20/llvm/Passes/OptimizationLevel.h>
+#include <string>
+#include <string_view>
+
+// Keeps a program loaded and rebuilds and runs it whenever its file changes
+// (`cat watch file.cat`). Every top-level function is remembered by a hash
+// of its text and one of the interfaces of the globals it uses, as seen from
+// where it stands in the file. A function whose hashes still match is not
+// checked or lowered again; the others are lowered into a module each and
+// added to the JIT under a ResourceTracker of their own, which is removed
+// once a newer body replaces it. Calls between top-level functions go
+// through stubs pointed at the newest bodies, so callers that did not change
+// keep their code.
+//
+// Editing a class, a global variable or a forward declaration rebuilds
+// everything, and so does every edit of a program with global variables,
+// which ParallelCodeGen does not lower.
+class WatchSession {
+  public:
+  WatchSession(std::string path, unsigned jobs, llvm::OptimizationLevel optLevel, int argc, char **argv);
+  // builds and runs the program, then again after every change of the file
+  void run();
+
+  private:
+  // a top-level function as of the last good build
+  struct Function {
+    uint64_t text = 0;
+    uint64_t deps = 0;
+    vec<Ident> uses;          // names its body refers to
+    ResourceTrackerSP tracker;// null while its body is part of a full build
+  };
+
+  // false if the program has errors, which are printed; the last good build
+  // stays loaded then
+  bool rebuild(std::string_view source);
+  void runMain();
+
+  std::string path;
+  unsigned jobs;
+  llvm::OptimizationLevel optLevel;
+  int argc;
+  char **argv;
+
+  uptr<SourceBuffer> source;// what the diagnostics point into
+  uint32_t fileId = 0;// registered with SrcMgr once, rebuild swaps in the new text
+  uptr<CatJIT> jit;
+  llvm::DenseMap<Ident, Function> functions;
+  llvm::StringSet<> stubs;// functions that have one
+  uint64_t shape = 0;     // hash of every definition that is not a function
+  unsigned generation = 0;// names the bodies of each build apart
+  bool patchable = false; // the loaded build can take single functions
+};
@@ -1,7 +1,9 @@
 #pragma once
 #include <cstddef>
 #include <iostream>
+#include <llvm-20/llvm/ADT/ArrayRef.h>
 #include <llvm-20/llvm/IR/Intrinsics.h>
+#include <llvm-20/llvm/Support/Casting.h>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -9,6 +11,7 @@
 #include <utility>
 #include <vector>
 
+#include "Interner.hpp"
 #include "Location.hpp"
 #include "Operator.hpp"
 #include "SemaType.hpp"
@@ -23,25 +26,62 @@ template<class T>
 using uptr = std::unique_ptr<T>;
 template<class T>
 using vec = std::vector<T>;
+// child lists live in the ASTContext arena alongside the nodes
+template<class T>
+using ASTList = llvm::ArrayRef<T *>;
 
-class AstVisitor;
 class Symbol;
 class FuncSymbol;
 class VarSymbol;
 class MethodSymbol;
 class ClassSymbol;
-// Base AST Node class
+// One kind per concrete node, used by classof/isa/dyn_cast and AstWalker
+enum class NodeKind : uint8_t {
+#define AST_NODE(Class) Class,
+#include "ASTNodes.def"
+  FirstDecl = Header,
+  LastDecl = ClassDecl,
+  FirstType = Type,
+  LastType = FuncParameterType,
+  FirstStmt = VarDef,
+  LastStmt = LoopStmt,
+  FirstLval = IdLVal,
+  LastLval = MemberAccessLVal,
+  FirstExpr = LValueExpr,
+  LastExpr = ExprCond,
+  FirstRval = IntConst,
+  LastRval = FalseConst,
+  FirstCond = ExprCond,
+  LastCond = ExprCond,
+};
+
+// Base AST Node class. Nodes have no vtable: the kind says what a node is,
+// and print/destruction dispatch on it like AstWalker does.
 class ASTNode {
   public:
   Location loc;
 
   public:
-  explicit ASTNode(Location loc);
-  virtual ~ASTNode() = 0;
-  virtual void accept(AstVisitor &v) = 0;
-  virtual void print(std::ostream &out) const = 0;
+  void print(std::ostream &out) const;
+  NodeKind getKind() const { return kind_; }
+
+  protected:
+  ASTNode(NodeKind kind, Location loc);
+  ~ASTNode() = default;
+
+  private:
+  const NodeKind kind_;
 };
 
+#define AST_CLASSOF(Class)                     \
+  static bool classof(const ASTNode *node) {   \
+    return node->getKind() == NodeKind::Class; \
+  }
+#define AST_CLASSOF_RANGE(Base)                                                                   \
+  static bool classof(const ASTNode *node) {                                                      \
+    return node->getKind() >= NodeKind::First##Base && node->getKind() <= NodeKind::Last##Base; \
+  }
+
 // Overload << operator for printing AST nodes
 inline std::ostream &operator<<(std::ostream &out, const ASTNode &node) {
   node.print(out);
@@ -49,17 +89,17 @@ inline std::ostream &operator<<(std::ostream &out, const ASTNode &node) {
 }
 
 /* Base classes in the hierarchy, directly derived from ASTNode 
- * Each node class stores certain attributes. The pointer attributes (uptr=unique_ptr)
- * are the actual children nodes of a node in the AST. The other are just attributes
- * that uniquely define an AST node.
+ * Each node class stores certain attributes. The pointer attributes are the actual
+ * children nodes of a node in the AST; they, like the node itself, are owned by the
+ * ASTContext that created them. The other are just attributes that uniquely define
+ * an AST node.
  * */
 
 // Expression nodes
 class Expr : public ASTNode {
   public:
-  explicit Expr(Location loc);
-  virtual ~Expr();
-  virtual void print(std::ostream &out) const override = 0;
+  Expr(NodeKind kind, Location loc);
+  AST_CLASSOF_RANGE(Expr)
   SemaTypePtr type() const;
   void setType(SemaTypePtr type);
   bool isLValue() const;
@@ -70,42 +110,40 @@ class Expr : public ASTNode {
   void setConstExpr(bool v);
 
   private:
-  SemaTypePtr resolvedType_;
+  // flags first so they pack in behind the node kind
   bool isLValue_ = false;
   bool assignable_ = false;
   bool constExpr_ = false;
+  SemaTypePtr resolvedType_ = nullptr;
 };
 
 // Statements
 class Stmt : public ASTNode {
   public:
-  explicit Stmt(Location l);
-  virtual ~Stmt() override;
-  virtual void print(std::ostream &out) const override = 0;
+  Stmt(NodeKind kind, Location l);
+  AST_CLASSOF_RANGE(Stmt)
 };
 
 // L-values - the left part of an assignment statement
 class Lval : public ASTNode {
   public:
-  explicit Lval(Location l);
-  virtual ~Lval() override;
-  virtual void print(std::ostream &out) const override = 0;
+  Lval(NodeKind kind, Location l);
+  AST_CLASSOF_RANGE(Lval)
   SemaTypePtr type() const;
   void setType(SemaTypePtr type);
   bool isAssignable() const;
   void setAssignable(bool v);
 
   private:
-  SemaTypePtr resolvedType_;
   bool assignable_ = true;
+  SemaTypePtr resolvedType_ = nullptr;
 };
 
 // R-Values are expressions - the right part of an assignment statement
 class Rval : public Expr {
   public:
-  explicit Rval(Location l);
-  virtual ~Rval() override = default;
-  virtual void print(std::ostream &out) const override = 0;
+  Rval(NodeKind kind, Location l);
+  AST_CLASSOF_RANGE(Rval)
 };
 
 // Types
@@ -114,27 +152,27 @@ class Type : public ASTNode {
   DataType::DataType base;
   vec<std::optional<int>> dims;// dimensions for array types
   void printTypeDetails(std::ostream &out) const;
-  std::optional<string> type_name;
+  Ident type_name;// class name of an instance type
+  Type(NodeKind kind, Location l, DataType::DataType b, vec<std::optional<int>> d = {});
 
   public:
+  AST_CLASSOF_RANGE(Type)
   Type(Location l, DataType::DataType b, vec<std::optional<int>> d = {});
-  virtual ~Type() override = default;
   DataType::DataType data_type() const;
-  void setTypeName(const string &name);
-  const optional<string> &getName() const;
+  void setTypeName(Ident name);
+  Ident typeName() const;
   const vec<std::optional<int>> &dimensions() const;
-  void accept(AstVisitor &v) override;
-  virtual void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
 };
 
 class FuncParameterType : public Type {
   public:
+  AST_CLASSOF(FuncParameterType)
   FuncParameterType(Location l, bool ref, DataType::DataType type);
   FuncParameterType(Location l, bool ref, DataType::DataType type, vec<std::optional<int>> d);
 
   bool isByRef() const;
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
 
   private:
   bool by_ref;
@@ -143,91 +181,92 @@ class FuncParameterType : public Type {
 // Blocks
 class Block : public ASTNode {
   public:
-  Block(Location l, vec<uptr<Stmt>> stmts);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  const vec<uptr<Stmt>> &statementsList() const { return statements; }
+  AST_CLASSOF(Block)
+  Block(Location l, ASTList<Stmt> stmts);
+  void print(std::ostream &out) const;
+  ASTList<Stmt> statementsList() const { return statements; }
 
   private:
-  vec<uptr<Stmt>> statements;
+  ASTList<Stmt> statements;
 };
 
 // Definitions
 class Decl : public ASTNode {
   public:
-  explicit Decl(Location l);
-  void print(std::ostream &out) const override;
+  Decl(NodeKind kind, Location l);
+  AST_CLASSOF_RANGE(Decl)
 };
 
 // Program root node
 class Program : public ASTNode {
   public:
-  Program(Location l, vec<uptr<ASTNode>> defs = {});
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  const vec<uptr<ASTNode>> &getDefs() const { return defs; }
+  AST_CLASSOF(Program)
+  Program(Location l, ASTList<ASTNode> defs = {});
+  void print(std::ostream &out) const;
+  ASTList<ASTNode> getDefs() const { return defs; }
 
   private:
-  vec<uptr<ASTNode>> defs;
+  ASTList<ASTNode> defs;
 };
 
 // ===== High-level program and definition nodes =====
 
 class FuncParameterDecl : public Decl {
   public:
-  FuncParameterDecl(Location l, vec<string> names, uptr<FuncParameterType> t);
-  void accept(AstVisitor &v) override;
-  const vec<string> &names() const;
+  AST_CLASSOF(FuncParameterDecl)
+  FuncParameterDecl(Location l, vec<Ident> names, FuncParameterType *t);
+  const vec<Ident> &names() const;
   FuncParameterType *parameterType() {
-    return type.get();
+    return type;
   }
   const FuncParameterType *parameterType() const;
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
 
   private:
-  vec<string> identifiers;
-  uptr<FuncParameterType> type;
+  vec<Ident> identifiers;
+  FuncParameterType *type;
 };
 
 class Header : public Decl {
   public:
-  Header(Location l, string n, optional<DataType::DataType> r, vec<uptr<FuncParameterDecl>> p);
+  AST_CLASSOF(Header)
+  Header(Location l, Ident n, optional<DataType::DataType> r, ASTList<FuncParameterDecl> p);
 
-  void accept(AstVisitor &v) override;
   const string &identifier() const;
-  const vec<uptr<FuncParameterDecl>> &parameters() const;
+  Ident ident() const { return name; }
+  ASTList<FuncParameterDecl> parameters() const;
   optional<DataType::DataType> returnType() const;
   FuncSymbol *symbol() const { return symbol_; }
   void setSymbol(FuncSymbol *sym) { symbol_ = sym; }
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
 
   private:
-  string name;
+  Ident name;
   optional<DataType::DataType> return_type;
-  vec<uptr<FuncParameterDecl>> params;
+  ASTList<FuncParameterDecl> params;
   // function symbol initialized with header
   FuncSymbol *symbol_ = nullptr;
 };
 
 class VarDef : public Stmt {
   private:
-  vec<string> names;
-  uptr<Type> declared_type;
+  vec<Ident> names;
+  Type *declared_type;
   vec<VarSymbol *> symbols_;
-  std::optional<uptr<Expr>> init_expr_;
+  Expr *init_expr_;
   bool field = false;
 
   public:
-  VarDef(Location l, vec<string> ids, uptr<Type> t, optional<uptr<Expr>> init = std::nullopt);
+  AST_CLASSOF(VarDef)
+  VarDef(Location l, vec<Ident> ids, Type *t, Expr *init = nullptr);
 
-  void accept(AstVisitor &v) override;
   vec<VarSymbol *> &symbols() { return symbols_; }
   const vec<VarSymbol *> &symbols() const { return symbols_; }
-  const vec<string> &identifiers() const { return names; }
-  const optional<uptr<Expr>> &initExpr() const { return init_expr_; }
-  Type *declaredType() { return declared_type.get(); }
-  const Type *declaredType() const { return declared_type.get(); }
-  void print(std::ostream &out) const override;
+  const vec<Ident> &identifiers() const { return names; }
+  Expr *initExpr() const { return init_expr_; }
+  Type *declaredType() { return declared_type; }
+  const Type *declaredType() const { return declared_type; }
+  void print(std::ostream &out) const;
   bool isField() const { return field; }
   void setIsField(bool isField) { field = isField; }
   void setSymbol(size_t i, VarSymbol *sym) { symbols_[i] = sym; }
@@ -235,127 +274,116 @@ class VarDef : public Stmt {
 
 class FuncDecl : public Decl {
   public:
-  explicit FuncDecl(Location l, uptr<Header> h);
+  AST_CLASSOF(FuncDecl)
+  explicit FuncDecl(Location l, Header *h);
 
-  void accept(AstVisitor &v) override;
-  Header *funcHeader() const { return header.get(); }
-  void print(std::ostream &out) const override;
+  Header *funcHeader() const { return header; }
+  void print(std::ostream &out) const;
 
   private:
-  uptr<Header> header;
+  Header *header;
 };
 
 class FuncDef : public Stmt {
   public:
-  FuncDef(Location l, uptr<Header> h, uptr<Block> b);
+  AST_CLASSOF(FuncDef)
+  FuncDef(Location l, Header *h, Block *b);
 
-  void accept(AstVisitor &v) override;
-  Header *funcHeader() const { return header.get(); }
-  Block *funcBody() const { return body.get(); }
-  void print(std::ostream &out) const override;
+  Header *funcHeader() const { return header; }
+  Block *funcBody() const { return body; }
+  void print(std::ostream &out) const;
   bool isEntrypoint();
   bool isMethod();
   void setEntrypoint(bool cond);
   void setIsMethod(bool cond);
 
   private:
-  uptr<Header> header;
-  uptr<Block> body;
-  bool isEntrypoint_;
+  Header *header;
+  Block *body;
+  bool isEntrypoint_ = false;
   bool isMethod_ = false;
 };
 
 class ClassDecl : public Decl {
   public:
-  ClassDecl(Location l, string n, vec<uptr<VarDef>> f, vec<uptr<FuncDef>> m);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  const string &identifier() const { return name; }
-  const vec<uptr<VarDef>> &fieldList() const { return fields; }
-  const vec<uptr<FuncDef>> &methodList() const { return methods; }
-  vec<uptr<VarDef>> &fieldList() { return fields; }
-  vec<uptr<FuncDef>> &methodList() { return methods; }
+  AST_CLASSOF(ClassDecl)
+  ClassDecl(Location l, Ident n, ASTList<VarDef> f, ASTList<FuncDef> m);
+  void print(std::ostream &out) const;
+  const string &identifier() const { return spelling(name); }
+  Ident ident() const { return name; }
+  ASTList<VarDef> fieldList() const { return fields; }
+  ASTList<FuncDef> methodList() const { return methods; }
   void addClassSymbol(ClassSymbol *newSym) { classSymbol = newSym; }
   const ClassSymbol *getClassSymbol() const { return classSymbol; }
 
   private:
-  string name;// class name
-  vec<uptr<VarDef>> fields;
-  vec<uptr<FuncDef>> methods;
+  Ident name;// class name
+  ASTList<VarDef> fields;
+  ASTList<FuncDef> methods;
   ClassSymbol *classSymbol;
 };
 // ===== Blocks and statements =====
-class ExpressionStmt : public Stmt {
-  public:
-  explicit ExpressionStmt(Location loc, uptr<Expr> expr);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  Expr *getExpr() const { return expression.get(); }
-
-  private:
-  uptr<Expr> expression;
-};
-
 class SkipStmt : public Stmt {
   public:
+  AST_CLASSOF(SkipStmt)
   explicit SkipStmt(Location l);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
 };
 
 class ExitStmt : public Stmt {
   public:
+  AST_CLASSOF(ExitStmt)
   explicit ExitStmt(Location l);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
 };
 
 class AssignStmt : public Stmt {
   public:
-  AssignStmt(Location l, uptr<Lval> left, uptr<Expr> right);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  Lval *left() const { return lhs.get(); }
-  Expr *right() const { return rhs.get(); }
+  AST_CLASSOF(AssignStmt)
+  AssignStmt(Location l, Lval *left, Expr *right);
+  void print(std::ostream &out) const;
+  Lval *left() const { return lhs; }
+  Expr *right() const { return rhs; }
 
   private:
-  uptr<Lval> lhs;
-  uptr<Expr> rhs;
+  Lval *lhs;
+  Expr *rhs;
 };
 
 class ReturnStmt : public Stmt {
   public:
-  ReturnStmt(Location l, uptr<Expr> expr);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  Expr *returnValue() const { return value.get(); }
+  AST_CLASSOF(ReturnStmt)
+  ReturnStmt(Location l, Expr *expr);
+  void print(std::ostream &out) const;
+  Expr *returnValue() const { return value; }
 
   private:
-  uptr<Expr> value;
+  Expr *value;
 };
 
 class ProcCall : public Stmt {
   public:
-  ProcCall(Location l, string id, vec<uptr<Expr>> a);
+  AST_CLASSOF(ProcCall)
+  ProcCall(Location l, Ident id, ASTList<Expr> a);
   FuncSymbol *funcSymbol() const { return symbol_; }
   void setFuncSymbol(FuncSymbol *sym) { symbol_ = sym; }
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  const string &identifier() const { return name; }
-  const vec<uptr<Expr>> &arguments() const { return args; }
+  void print(std::ostream &out) const;
+  const string &identifier() const { return spelling(name); }
+  Ident ident() const { return name; }
+  ASTList<Expr> arguments() const { return args; }
 
   private:
-  string name;
-  vec<uptr<Expr>> args;
+  Ident name;
+  ASTList<Expr> args;
   // store associated symbol (callee)
   FuncSymbol *symbol_ = nullptr;
 };
 
 class BreakStmt : public Stmt {
   public:
+  AST_CLASSOF(BreakStmt)
   BreakStmt(Location l, optional<string> lbl);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
+  void print(std::ostream &out) const;
   const optional<string> &loopLabel() const { return label; }
 
   private:
@@ -364,9 +392,9 @@ class BreakStmt : public Stmt {
 
 class ContinueStmt : public Stmt {
   public:
+  AST_CLASSOF(ContinueStmt)
   ContinueStmt(Location l, optional<string> lbl);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
+  void print(std::ostream &out) const;
   const optional<string> &loopLabel() const { return label; }
 
   private:
@@ -377,56 +405,57 @@ class ContinueStmt : public Stmt {
 class Cond;
 class IfStmt : public Stmt {
   public:
-  IfStmt(Location l, uptr<Cond> cond, uptr<Block> then_block, vec<std::pair<uptr<Cond>, uptr<Block>>> elifs, std::optional<uptr<Block>> else_block);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  Cond *conditionExpr() const { return condition.get(); }
-  Block *thenBlock() const { return then_branch.get(); }
-  const vec<std::pair<uptr<Cond>, uptr<Block>>> &elifs() const { return elif_branches; }
-  Block *elseBlock() const { return else_branch ? else_branch->get() : nullptr; }
+  AST_CLASSOF(IfStmt)
+  IfStmt(Location l, Cond *cond, Block *then_block, llvm::ArrayRef<std::pair<Cond *, Block *>> elifs, Block *else_block);
+  void print(std::ostream &out) const;
+  Cond *conditionExpr() const { return condition; }
+  Block *thenBlock() const { return then_branch; }
+  llvm::ArrayRef<std::pair<Cond *, Block *>> elifs() const { return elif_branches; }
+  Block *elseBlock() const { return else_branch; }
 
   private:
-  uptr<Cond> condition;
-  uptr<Block> then_branch;
-  vec<std::pair<uptr<Cond>, uptr<Block>>> elif_branches;
-  optional<uptr<Block>> else_branch;
+  Cond *condition;
+  Block *then_branch;
+  llvm::ArrayRef<std::pair<Cond *, Block *>> elif_branches;
+  Block *else_branch;
 };
 
 class LoopStmt : public Stmt {
   private:
-  uptr<Cond> condition;
-  uptr<Block> body;
+  Cond *condition;
+  Block *body;
 
   public:
-  LoopStmt(Location l, uptr<Cond> cond, uptr<Block> blk);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  Cond *conditionExpr() const { return condition.get(); }
-  Block *loopBody() const { return body.get(); }
+  AST_CLASSOF(LoopStmt)
+  LoopStmt(Location l, Cond *cond, Block *blk);
+  void print(std::ostream &out) const;
+  Cond *conditionExpr() const { return condition; }
+  Block *loopBody() const { return body; }
 };
 
 // ===== L-values =====
 
 class IdLVal : public Lval {
   public:
-  IdLVal(Location l, string id);
+  AST_CLASSOF(IdLVal)
+  IdLVal(Location l, Ident id);
   Symbol *symbol() const { return symbol_; }
   void setSymbol(Symbol *sym) { symbol_ = sym; }
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  const string &identifier() const { return name; }
+  void print(std::ostream &out) const;
+  const string &identifier() const { return spelling(name); }
+  Ident ident() const { return name; }
 
   private:
-  string name;
+  Ident name;
   // store associated symbol
   Symbol *symbol_ = nullptr;
 };
 
 class StringLiteralLVal : public Lval {
   public:
+  AST_CLASSOF(StringLiteralLVal)
   StringLiteralLVal(Location l, string v);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
+  void print(std::ostream &out) const;
   const string &literal() const { return value; }
 
   private:
@@ -435,31 +464,32 @@ class StringLiteralLVal : public Lval {
 
 class IndexLVal : public Lval {
   public:
-  IndexLVal(Location l, uptr<Lval> b, uptr<Expr> idx);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  Lval *baseExpr() const { return base.get(); }
-  Expr *indexExpr() const { return index.get(); }
+  AST_CLASSOF(IndexLVal)
+  IndexLVal(Location l, Lval *b, Expr *idx);
+  void print(std::ostream &out) const;
+  Lval *baseExpr() const { return base; }
+  Expr *indexExpr() const { return index; }
 
   private:
-  uptr<Lval> base;
-  uptr<Expr> index;
+  Lval *base;
+  Expr *index;
 };
 
 // Member access as Lval (e.g., a.b on the left side of assignment)
 class MemberAccessLVal : public Lval {
   public:
-  MemberAccessLVal(Location l, uptr<Expr> obj, string member);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  Expr *object() const { return object_.get(); }
-  const string &memberName() const { return member_; }
+  AST_CLASSOF(MemberAccessLVal)
+  MemberAccessLVal(Location l, Expr *obj, Ident member);
+  void print(std::ostream &out) const;
+  Expr *object() const { return object_; }
+  const string &memberName() const { return spelling(member_); }
+  Ident memberIdent() const { return member_; }
   Symbol *memberSymbol() const { return memberSymbol_; }
   void setMemberSymbol(Symbol *sym) { memberSymbol_ = sym; }
 
   private:
-  uptr<Expr> object_;
-  string member_;
+  Expr *object_;
+  Ident member_;
   Symbol *memberSymbol_ = nullptr;
 };
 
@@ -470,9 +500,9 @@ class IntConst : public Rval {
   int value;
 
   public:
+  AST_CLASSOF(IntConst)
   IntConst(Location l, int v);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
   int getValue() const { return value; }
 };
 
@@ -481,64 +511,65 @@ class CharConst : public Rval {
   unsigned char value;
 
   public:
+  AST_CLASSOF(CharConst)
   CharConst(Location l, unsigned char v);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
   unsigned char getValue() const { return value; }
 };
 
 class TrueConst : public Rval {
   public:
+  AST_CLASSOF(TrueConst)
   explicit TrueConst(Location l);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
 };
 
 class FalseConst : public Rval {
   public:
+  AST_CLASSOF(FalseConst)
   explicit FalseConst(Location l);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  void print(std::ostream &out) const;
 };
 
 // ===== Expressions =====
 
 class LValueExpr : public Expr {
   public:
-  LValueExpr(Location l, uptr<Lval> val);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  Lval *lvalue() const { return value.get(); }
-  uptr<Lval> releaseLVal() { return std::move(value); }
+  AST_CLASSOF(LValueExpr)
+  LValueExpr(Location l, Lval *val);
+  void print(std::ostream &out) const;
+  Lval *lvalue() const { return value; }
+  Lval *releaseLVal() { return value; }
 
   private:
-  uptr<Lval> value;
+  Lval *value;
 };
 
 class ParenExpr : public Expr {
   public:
-  ParenExpr(Location l, uptr<Expr> expr);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  Expr *innerExpr() const { return inner.get(); }
+  AST_CLASSOF(ParenExpr)
+  ParenExpr(Location l, Expr *expr);
+  void print(std::ostream &out) const;
+  Expr *innerExpr() const { return inner; }
 
   private:
-  uptr<Expr> inner;
+  Expr *inner;
 };
 
 class FuncCall : public Expr {
   public:
-  FuncCall(Location l, string id, vec<uptr<Expr>> a);
+  AST_CLASSOF(FuncCall)
+  FuncCall(Location l, Ident id, ASTList<Expr> a);
   FuncSymbol *funcSymbol() const { return symbol_; }
   void setFuncSymbol(FuncSymbol *sym) { symbol_ = sym; }
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  const string &identifier() const { return name; }
-  const vec<uptr<Expr>> &arguments() const { return args; }
+  void print(std::ostream &out) const;
+  const string &identifier() const { return spelling(name); }
+  Ident ident() const { return name; }
+  ASTList<Expr> arguments() const { return args; }
 
   private:
-  string name;
-  vec<uptr<Expr>> args;
+  Ident name;
+  ASTList<Expr> args;
   // store associated symbol (callee)
   FuncSymbol *symbol_ = nullptr;
 };
@@ -546,89 +577,92 @@ class FuncCall : public Expr {
 // Member access expression (e.g., a.b, a.func)
 class MemberAccessExpr : public Expr {
   public:
-  MemberAccessExpr(Location l, uptr<Expr> obj, string member);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  Expr *object() const { return object_.get(); }
-  const string &memberName() const { return member_; }
+  AST_CLASSOF(MemberAccessExpr)
+  MemberAccessExpr(Location l, Expr *obj, Ident member);
+  void print(std::ostream &out) const;
+  Expr *object() const { return object_; }
+  const string &memberName() const { return spelling(member_); }
+  Ident memberIdent() const { return member_; }
   Symbol *memberSymbol() const { return memberSymbol_; }
   void setMemberSymbol(Symbol *sym) { memberSymbol_ = sym; }
 
   private:
-  uptr<Expr> object_;
-  string member_;
+  Expr *object_;
+  Ident member_;
   Symbol *memberSymbol_ = nullptr;
 };
 
 // Method call expression (e.g., a.func(args))
 class MethodCall : public Expr {
   public:
-  MethodCall(Location l, uptr<Expr> obj, string method, vec<uptr<Expr>> args);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  Expr *object() const { return object_.get(); }
-  const string &methodName() const { return method_; }
-  const vec<uptr<Expr>> &arguments() const { return args; }
+  AST_CLASSOF(MethodCall)
+  MethodCall(Location l, Expr *obj, Ident method, ASTList<Expr> args);
+  void print(std::ostream &out) const;
+  Expr *object() const { return object_; }
+  const string &methodName() const { return spelling(method_); }
+  Ident methodIdent() const { return method_; }
+  ASTList<Expr> arguments() const { return args; }
   MethodSymbol *methodSymbol() const { return symbol_; }
   void setMethodSymbol(MethodSymbol *sym) { symbol_ = sym; }
 
   private:
-  uptr<Expr> object_;
-  string method_;
-  vec<uptr<Expr>> args;
+  Expr *object_;
+  Ident method_;
+  ASTList<Expr> args;
   MethodSymbol *symbol_ = nullptr;
 };
 
 class NewExpr : public Expr {
   public:
-  NewExpr(Location loc, string clsName, vec<uptr<Expr>> args);
-  void print(std::ostream &out) const override;
-  void accept(AstVisitor &v) override;
-  const string &getCotorName() const { return clsName; }
-  const vec<uptr<Expr>> &getArgs() const { return args; }
+  AST_CLASSOF(NewExpr)
+  NewExpr(Location loc, Ident clsName, ASTList<Expr> args);
+  void print(std::ostream &out) const;
+  const string &getCotorName() const { return spelling(clsName); }
+  Ident classIdent() const { return clsName; }
+  ASTList<Expr> getArgs() const { return args; }
 
   private:
-  string clsName;
-  vec<uptr<Expr>> args;
+  Ident clsName;
+  ASTList<Expr> args;
 };
 
 class UnaryExpr : public Expr {
   public:
-  UnaryExpr(Location l, UnOp operation, uptr<Expr> expr);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  AST_CLASSOF(UnaryExpr)
+  UnaryExpr(Location l, UnOp operation, Expr *expr);
+  void print(std::ostream &out) const;
   UnOp opKind() const { return op; }
-  Expr *operandExpr() const { return operand.get(); }
+  Expr *operandExpr() const { return operand; }
 
   private:
   UnOp op;
-  uptr<Expr> operand;
+  Expr *operand;
 };
 
 class BinaryExpr : public Expr {
   public:
-  BinaryExpr(Location l, BinOp operation, uptr<Expr> left, uptr<Expr> right);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
+  AST_CLASSOF(BinaryExpr)
+  BinaryExpr(Location l, BinOp operation, Expr *left, Expr *right);
+  void print(std::ostream &out) const;
   BinOp opKind() const { return op; }
-  Expr *leftExpr() const { return lhs.get(); }
-  Expr *rightExpr() const { return rhs.get(); }
+  Expr *leftExpr() const { return lhs; }
+  Expr *rightExpr() const { return rhs; }
 
   private:
   BinOp op;
-  uptr<Expr> lhs;
-  uptr<Expr> rhs;
+  Expr *lhs;
+  Expr *rhs;
 };
 
 class ArrayExpr : public Expr {
   public:
-  ArrayExpr(Location loc, vec<uptr<Expr>> elems);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  const vec<uptr<Expr>> &getElements() const { return elements; }
+  AST_CLASSOF(ArrayExpr)
+  ArrayExpr(Location loc, ASTList<Expr> elems);
+  void print(std::ostream &out) const;
+  ASTList<Expr> getElements() const { return elements; }
 
   private:
-  vec<uptr<Expr>> elements;
+  ASTList<Expr> elements;
 };
 
 // class SelfExpr : public Expr {
@@ -659,20 +693,19 @@ class ArrayExpr : public Expr {
 
 class Cond : public Expr {
   public:
-  explicit Cond(Location l);
-  ~Cond() override = default;
-  virtual void print(std::ostream &out) const override = 0;
+  Cond(NodeKind kind, Location l);
+  AST_CLASSOF_RANGE(Cond)
 };
 
 class ExprCond : public Cond {
   public:
-  ExprCond(Location l, uptr<Expr> e);
-  void accept(AstVisitor &v) override;
-  void print(std::ostream &out) const override;
-  Expr *expression() const { return expr.get(); }
+  AST_CLASSOF(ExprCond)
+  ExprCond(Location l, Expr *e);
+  void print(std::ostream &out) const;
+  Expr *expression() const { return expr; }
 
   private:
-  uptr<Expr> expr;
+  Expr *expr;
 };
 
 // class ParenCond : public Cond {
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <llvm-20/llvm/ADT/ArrayRef.h>
+#include <llvm-20/llvm/Support/Allocator.h>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class ASTNode;
+
+// Owns every node of one parse. Nodes and child lists are bump-allocated
+// into slabs; destroying the context runs the destructors of the nodes that
+// have one and then releases the slabs all at once.
+class ASTContext {
+  public:
+  ASTContext() = default;
+  ASTContext(const ASTContext &) = delete;
+  ASTContext &operator=(const ASTContext &) = delete;
+  ~ASTContext();
+
+  template<typename T, typename... Args>
+  T *create(Args &&...args) {
+    void *mem = allocator.Allocate(sizeof(T), alignof(T));
+    T *node = new (mem) T(std::forward<Args>(args)...);
+    ++nodeCount_;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      needsDestroy.push_back(node);
+    }
+    return node;
+  }
+
+  // copy a list built by the parser into the arena
+  template<typename T>
+  llvm::ArrayRef<T> list(llvm::ArrayRef<T> items) {
+    static_assert(std::is_trivially_destructible<T>::value, "arena lists are never destroyed");
+    if (items.empty()) {
+      return {};
+    }
+    T *mem = allocator.Allocate<T>(items.size());
+    std::uninitialized_copy(items.begin(), items.end(), mem);
+    return {mem, items.size()};
+  }
+
+  std::size_t nodeCount() const { return nodeCount_; }
+  std::size_t bytesAllocated() const { return allocator.getBytesAllocated(); }
+
+  private:
+  llvm::BumpPtrAllocator allocator;
+  std::vector<ASTNode *> needsDestroy;
+  std::size_t nodeCount_ = 0;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include "AST.hpp"
+#include "ASTContext.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Binary form of a parsed AST, what the AST cache stores. The file is a
+// header, a string table and the nodes as one stream of 32-bit words in
+// pre-order, so it can be mapped and walked in place:
+//
+//   header      FileHeader below
+//   offsets     stringCount + 1 words, start of each string in the blob
+//   blob        the strings back to back, padded to a word
+//   nodes       wordCount words
+//
+// A node is a word holding its NodeKind in the low byte and a small payload
+// above it (an operator, a flag), the offset of its location, then its
+// fields in declaration order: strings as table indices, child nodes inline,
+// lists as a count followed by the elements. A missing optional child is
+// the single word nullNode. Identifiers are stored by spelling and interned
+// again when read, since Ident ids differ between runs; locations are
+// stored without a file and read back into the file being built.
+//
+// Only what the parser produces is stored. Symbols, types and flags set by
+// sema point into the tables of one build and are recomputed.
+class ASTSerializer {
+  public:
+  // bump whenever a node gains, loses or reorders a field
+  static constexpr uint32_t formatVersion = 1;
+  static constexpr uint32_t nullNode = ~0u;
+
+  struct FileHeader {
+    char magic[4];// "CAST"
+    uint32_t version;
+    uint64_t key;     // identifies the source text and the compiler that parsed it
+    uint64_t checksum;// of everything after the header
+    uint32_t sourceBytes;
+    uint32_t stringCount;
+    uint32_t blobWords;
+    uint32_t wordCount;
+  };
+
+  static std::string serialize(const Program &program, uint64_t key, std::size_t sourceBytes);
+  // nullptr unless data is an intact AST file written for this key
+  static Program *deserialize(std::string_view data, uint64_t key, std::size_t sourceBytes, uint32_t fileId, ASTContext &ctx);
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "AST.hpp"
+
+// Statically dispatched traversal. A pass derives from AstWalker<Pass> and
+// provides visit(Node &) for every concrete node; walk() switches on the
+// node kind and calls straight into the pass, so no vtable is involved and
+// the visit bodies can be inlined into the switch.
+template<typename Derived>
+class AstWalker {
+  public:
+  void walk(ASTNode *node) {
+    switch (node->getKind()) {
+#define AST_NODE(Class)                                    \
+  case NodeKind::Class:                                    \
+    return derived().visit(*static_cast<Class *>(node));
+#include "ASTNodes.def"
+    }
+  }
+  void walk(ASTNode &node) { walk(&node); }
+
+  private:
+  Derived &derived() { return *static_cast<Derived *>(this); }
+};
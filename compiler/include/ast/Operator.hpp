@@ -23,6 +23,40 @@ enum class BinOp {
   Or
 };
 
+// How tightly a binary operator binds, higher binds tighter; 0 for the
+// operators the parser never produces. Every level is left associative except
+// the relational one: a < b < c is a syntax error, not (a < b) < c.
+constexpr int binOpPrecedence(BinOp op) {
+  switch (op) {
+    case BinOp::Or:
+      return 1;
+    case BinOp::And:
+      return 2;
+    case BinOp::Eq:
+    case BinOp::Ne:
+      return 3;
+    case BinOp::Lt:
+    case BinOp::Gt:
+    case BinOp::Le:
+    case BinOp::Ge:
+      return 4;
+    case BinOp::Add:
+    case BinOp::Sub:
+      return 5;
+    case BinOp::Mul:
+    case BinOp::Div:
+    case BinOp::Mod:
+      return 6;
+    case BinOp::AndBits:
+    case BinOp::OrBits:
+      return 0;
+  }
+  return 0;
+}
+
+constexpr bool binOpChains(BinOp op) {
+  return binOpPrecedence(op) != binOpPrecedence(BinOp::Lt);
+}
 
 inline const char *unOpName(UnOp op) {
   switch (op) {
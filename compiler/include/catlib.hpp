@@ -1,16 +1,52 @@
 #pragma once
 #include "CodeGen.hpp"
 #include "SemanticCtx.hpp"
+#include <array>
+#include <cstdint>
+
+// defined in OutputBuffer.cpp
+extern "C" {
+void cat_print(const char *fmt, ...);
+void cat_write_lit(const char *text, int64_t length);
+void cat_write_i32(int32_t value);
+void cat_write_u32(uint32_t value);
+void cat_write_char(char value);
+void cat_write_str(const char *text);
+}
 
 namespace Catime {
+  // the llvm types runtime functions are declared with
+  enum class RuntimeType { Void, I8, I32, I64, Ptr };
   struct CatBuiltin {
     const char *runtimeName;
     const char *catName;
+    RuntimeType result;
+    std::array<RuntimeType, 2> params;// up to the first Void
+    bool isVariadic;
   };
 
+  // the entries without a Cat name are what print is lowered to; genBuiltins
+  // declares every entry in each module with the signature given here
   inline constexpr CatBuiltin builtinTable[] = {
-      {"cat_print", "print"},
-
+      {"cat_print", "print", RuntimeType::Void, {RuntimeType::Ptr}, true},
+      {"cat_write_lit", nullptr, RuntimeType::Void, {RuntimeType::Ptr, RuntimeType::I64}, false},
+      {"cat_write_i32", nullptr, RuntimeType::Void, {RuntimeType::I32}, false},
+      {"cat_write_u32", nullptr, RuntimeType::Void, {RuntimeType::I32}, false},
+      {"cat_write_char", nullptr, RuntimeType::Void, {RuntimeType::I8}, false},
+      {"cat_write_str", nullptr, RuntimeType::Void, {RuntimeType::Ptr}, false},
+  };
+  struct RuntimeSymbol {
+    const char *name;
+    void *address;
+  };
+  // the functions lowered programs call, defined in the JIT by defineRuntime
+  inline const RuntimeSymbol runtimeSymbols[] = {
+      {"cat_print", reinterpret_cast<void *>(&cat_print)},
+      {"cat_write_lit", reinterpret_cast<void *>(&cat_write_lit)},
+      {"cat_write_i32", reinterpret_cast<void *>(&cat_write_i32)},
+      {"cat_write_u32", reinterpret_cast<void *>(&cat_write_u32)},
+      {"cat_write_char", reinterpret_cast<void *>(&cat_write_char)},
+      {"cat_write_str", reinterpret_cast<void *>(&cat_write_str)},
   };
   // class CodeGenCtx;
   // class SemanticCtx;
@@ -1,9 +1,14 @@
 // #include "ASTPrinter.hpp"
 #include "Cat.hpp"
+#include "CompileStats.hpp"
 #include <llvm-c-20/llvm-c/Types.h>
 #include <llvm/IR/DiagnosticInfo.h>
 #include <llvm/IR/Value.h>
 #include <llvm/Support/CommandLine.h>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <vector>
 int main(int argc, char *argv[]) {
     Cat cat(argc, argv);
     enum OptLv { O0,
@@ -15,7 +20,7 @@ int main(int argc, char *argv[]) {
         llvm::cl::desc("<mode>"),
         llvm::cl::Required
     );
-    llvm::cl::opt<string> inputFile(llvm::cl::Positional, llvm::cl::desc("<input file>"), llvm::cl::Required);
+    llvm::cl::list<string> inputFiles(llvm::cl::Positional, llvm::cl::desc("<input files or directories>"), llvm::cl::OneOrMore);
     llvm::cl::opt<string> outputFile("o", llvm::cl::desc("Specify output file name"), llvm::cl::value_desc("filename"));
     llvm::cl::opt<OptLv> optLv(
         "Level",
@@ -29,9 +34,36 @@ int main(int argc, char *argv[]) {
         ),
         llvm::cl::init(OptLv::O0)
     );
+    llvm::cl::opt<bool> timeReport("time-report", llvm::cl::desc("Report wall and CPU time per compiler phase and LLVM pass"));
+    llvm::cl::opt<bool> memReport("mem-report", llvm::cl::desc("Report peak RSS growth and allocations per compiler phase"));
+    llvm::cl::opt<CompileStats::Format> reportFormat(
+        "report-format",
+        llvm::cl::desc("Format of --time-report/--mem-report"),
+        llvm::cl::values(
+            clEnumValN(CompileStats::Format::Text, "text", "Human readable table"),
+            clEnumValN(CompileStats::Format::Json, "json", "JSON object")
+        ),
+        llvm::cl::init(CompileStats::Format::Text)
+    );
+    llvm::cl::opt<string> reportFile("report-file", llvm::cl::desc("Write the report here instead of stderr"), llvm::cl::value_desc("filename"));
+    llvm::cl::opt<bool> emitAST("emit-ast", llvm::cl::desc("Print the AST after parsing"));
+    llvm::cl::opt<bool> emitLLVM("emit-llvm", llvm::cl::desc("Write the IR to ./out.ll and the optimized IR to ./opt.ll"));
+    llvm::cl::opt<unsigned> jobs("j", llvm::cl::desc("Parse files, check and lower functions on N threads (0: one per core)"), llvm::cl::value_desc("N"), llvm::cl::Prefix, llvm::cl::init(1));
+    llvm::cl::opt<string> astCache("ast-cache", llvm::cl::desc("Cache parsed ASTs in this directory (empty: no cache)"), llvm::cl::value_desc("dir"));
+    llvm::cl::opt<bool> stream("stream", llvm::cl::desc("Read the input in pieces and lower each definition as soon as it is parsed"));
     llvm::cl::ParseCommandLineOptions(argc, argv, "Cat Language Compiler!\n");
     // = "/home/buyi/code/cat-lang/test/test.cat";
     cat.isUseJIT = true;
+    cat.dumpAST = emitAST;
+    cat.emitLLVM = emitLLVM;
+    cat.reportFile = reportFile;
+    cat.astCacheDir = astCache;
+    cat.streamInput = stream;
+    cat.jobs = jobs ? jobs : std::max(1u, std::thread::hardware_concurrency());
+    auto stats = Stats::getInstance();
+    stats->enableTimeReport(timeReport);
+    stats->enableMemReport(memReport);
+    stats->setFormat(reportFormat);
     llvm::OptimizationLevel optLevel = llvm::OptimizationLevel::O0;
     switch (optLv) {
         case OptLv::O0:
@@ -50,7 +82,15 @@ int main(int argc, char *argv[]) {
     if (mode == "run") {
         // cat.runFile(filePath);
     } else if (mode == "build") {
-        cat.buildFile(inputFile, optLevel);
+        std::vector<string> inputs(inputFiles.begin(), inputFiles.end());
+        if (inputs.size() == 1 && !std::filesystem::is_directory(inputs.front())) {
+            cat.buildFile(inputs.front(), optLevel);
+        } else {
+            cat.buildFiles(inputs, optLevel);
+        }
+    } else if (mode == "watch") {
+        // rebuilds and reruns the file on every save, until interrupted
+        cat.watchFile(inputFiles.front(), optLevel);
     }
     return 0;
 }
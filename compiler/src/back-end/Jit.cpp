@@ -1,4 +1,7 @@
 #include "Jit.hpp"
+#include "CompileStats.hpp"
+#include "OutputBuffer.hpp"
+#include "catlib.hpp"
 #include <cstdlib>
 #include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
@@ -13,7 +16,6 @@
 #include <llvm/Support/TargetSelect.h>
 #include <memory>
 #include <utility>
-extern "C" void cat_print(int x);
 
 uptr<llvm::Module> JIT::loadModule() {
     llvm::SMDiagnostic err;
@@ -26,36 +28,55 @@ uptr<llvm::Module> JIT::loadModule() {
 }
 
 llvm::Error JIT::run(uptr<llvm::Module> module, uptr<llvm::LLVMContext> ctx, int argc, char *argv[]) {
-    auto JIT = CatJIT::Create();
-    if (!JIT) {
-        return JIT.takeError();
-    }
+    std::vector<llvm::orc::ThreadSafeModule> modules;
+    modules.emplace_back(std::move(module), std::move(ctx));
+    return run(std::move(modules), argc, argv);
+}
 
+llvm::Error defineRuntime(CatJIT &Jit) {
     // 手动添加符号映射 - 在添加模块之前
-    auto &MainJD = (*JIT)->getMainJITDylib();
+    auto &MainJD = Jit.getMainJITDylib();
     llvm::orc::SymbolMap Symbols;
-    llvm::orc::MangleAndInterner Mangle((*JIT)->getMainJITDylib().getExecutionSession(), (*JIT)->getDataLayout());
 
-    // 将 cat_print 函数地址添加到符号表
-    Symbols[Mangle("cat_print")] = {
-        llvm::orc::ExecutorAddr::fromPtr(reinterpret_cast<void *>(&cat_print)),
-        llvm::JITSymbolFlags::Callable | llvm::JITSymbolFlags::Exported
-    };
-
-    llvm::cantFail(MainJD.define(llvm::orc::absoluteSymbols(Symbols)));
-
-    // add module to the jit
-    if (auto err = (*JIT)->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(ctx)))) {
+    // 将运行时函数地址添加到符号表
+    for (const auto &runtime: Catime::runtimeSymbols) {
+        Symbols[Jit.mangle(runtime.name)] = {
+            llvm::orc::ExecutorAddr::fromPtr(runtime.address),
+            llvm::JITSymbolFlags::Callable | llvm::JITSymbolFlags::Exported
+        };
+    }
+    if (auto err = MainJD.define(llvm::orc::absoluteSymbols(Symbols))) {
         return err;
     }
 
     // add dynamic library search resolve symbols from the host process
-    const llvm::DataLayout &DL = (*JIT)->getDataLayout();
+    const llvm::DataLayout &DL = Jit.getDataLayout();
     auto DLSG = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(DL.getGlobalPrefix());
     if (!DLSG) {
         return DLSG.takeError();
     }
-    (*JIT)->getMainJITDylib().addGenerator(std::move(*DLSG));
+    MainJD.addGenerator(std::move(*DLSG));
+    return llvm::Error::success();
+}
+
+llvm::Error JIT::run(std::vector<llvm::orc::ThreadSafeModule> modules, int argc, char *argv[]) {
+    auto &stats = *Stats::getInstance();
+    auto jitPhase = stats.phase("jit");
+    auto JIT = CatJIT::Create();
+    if (!JIT) {
+        return JIT.takeError();
+    }
+
+    if (auto err = defineRuntime(**JIT)) {
+        return err;
+    }
+
+    // add the modules to the jit, references between them resolve in MainJD
+    for (auto &module: modules) {
+        if (auto err = (*JIT)->addIRModule(std::move(module))) {
+            return err;
+        }
+    }
 
     // search main symbol
     auto mainSys = (*JIT)->lookup("main");
@@ -63,8 +84,12 @@ llvm::Error JIT::run(uptr<llvm::Module> module, uptr<llvm::LLVMContext> ctx, int
         return mainSys.takeError();
     }
     auto main = mainSys->getAddress().toPtr<int (*)(int, char **)>();
+    jitPhase.stop();
 
     // call main function in IR
+    auto runPhase = stats.phase("run");
     (void) main(argc, argv);
+    Catime::flushOutput();
+    runPhase.stop();
     return llvm::Error::success();
 }
@@ -0,0 +1,76 @@
+#include "ASTCache.hpp"
+#include "ASTSerializer.h"
+#include "SourceBuffer.hpp"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <llvm-20/llvm/Support/xxhash.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+  // changes whenever the compiler binary is rebuilt or replaced
+  uint64_t hashCompiler() {
+    uint64_t id[4] = {ASTSerializer::formatVersion, 0, 0, 0};
+    struct stat st;
+    if (::stat("/proc/self/exe", &st) == 0) {
+      id[1] = st.st_size;
+      id[2] = st.st_mtim.tv_sec;
+      id[3] = st.st_mtim.tv_nsec;
+    }
+    return llvm::xxh3_64bits(llvm::ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(id), sizeof(id)));
+  }
+}// namespace
+
+ASTCache::ASTCache(std::string dir) : dir(std::move(dir)), compilerId(hashCompiler()) {}
+
+uint64_t ASTCache::key(std::string_view source) const {
+  return llvm::xxh3_64bits(llvm::StringRef(source.data(), source.size())) ^ compilerId;
+}
+
+std::string ASTCache::pathFor(uint64_t key) const {
+  char name[24];
+  std::snprintf(name, sizeof(name), "%016llx.ast", static_cast<unsigned long long>(key));
+  return dir + "/" + name;
+}
+
+Program *ASTCache::load(std::string_view source, uint32_t fileId, ASTContext &ctx) const {
+  const uint64_t k = key(source);
+  auto file = SourceBuffer::openFile(pathFor(k));
+  if (!file) {
+    return nullptr;
+  }
+  return ASTSerializer::deserialize(file->text(), k, source.size(), fileId, ctx);
+}
+
+void ASTCache::store(std::string_view source, const Program &program) const {
+  const uint64_t k = key(source);
+  const std::string path = pathFor(k);
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return;
+  }
+  // unique per process and per call, several threads may store at once
+  static std::atomic<unsigned> serial{0};
+  const std::string tmp = path + "." + std::to_string(::getpid()) + "." + std::to_string(serial++) + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return;
+    }
+    const std::string data = ASTSerializer::serialize(program, k, source.size());
+    out.write(data.data(), data.size());
+    if (!out) {
+      out.close();
+      std::filesystem::remove(tmp, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+  }
+}
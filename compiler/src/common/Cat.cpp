@@ -1,22 +1,34 @@
 #include "Cat.hpp"
+#include "ASTCache.hpp"
 #include "CodeGen.hpp"
 #include "CodeGenCtx.hpp"
+#include "CompileStats.hpp"
 #include "Diagnostics.hpp"
+#include "Interner.hpp"
 #include "Jit.hpp"
 #include "Optimizer.hpp"
+#include "ParallelCodeGen.hpp"
+#include "ParallelFrontEnd.hpp"
 #include "Parser.hpp"
 #include "PassDriver.hpp"
 #include "Scanner.hpp"
 #include "SemanticCtx.hpp"
+#include "SourceBuffer.hpp"
+#include "SourceManager.hpp"
+#include "SourceStream.hpp"
 #include "SymbolTable.hpp"
+#include "WatchSession.hpp"
 #include "catlib.hpp"
+#include <algorithm>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
-#include <ios>
 #include <iostream>
 #include <llvm-20/llvm/IR/Verifier.h>
 #include <llvm-20/llvm/Passes/OptimizationLevel.h>
+#include <string>
 #include <utility>
+#include <vector>
 std::string Cat::logo{R"(
 ├─Welcome to Cat Programming Language!─┤
 ________________________________________
@@ -66,87 +78,301 @@ ________________________________________
 //     std::cout << "Result: " << AS_INT(res) << '\n';
 // }
 
-void Cat::build(const string &program, llvm::OptimizationLevel optLevel) {
+void Cat::build(std::string_view program, llvm::OptimizationLevel optLevel, const std::string &name) {
+  auto &stats = *Stats::getInstance();
   // define diagnostics
   try {
     // ---------------------------------------------------------------------------
 
-    // lexer analysis
-    auto scanner = Scanner(program);
-    // ---------------------------------------------------------------------------
+    auto fileId = SrcMgr::getInstance()->addFile(name, program);
+    // the AST lives in this arena until the build finishes
+    ASTContext astCtx;
+    Program *root = nullptr;
+    ASTCache cache(astCacheDir);
+    if (!astCacheDir.empty()) {
+      auto cachePhase = stats.phase("ast cache");
+      root = cache.load(program, fileId, astCtx);
+      cachePhase.stop();
+      stats.count("ast cache hits", root ? 1 : 0);
+    }
+    if (!root) {
+      // lexer analysis
+      auto lexPhase = stats.phase("lex");
+      auto scanner = Scanner(program, fileId);
+      auto tokens = scanner.scanTokens();
+      lexPhase.stop();
+      stats.count("tokens", tokens.size());
+      // ---------------------------------------------------------------------------
 
-    // syntax analysis
-    auto parser = Parser(scanner);
-    auto root = parser.parse();
-    root->print(std::cout);
-    // ---------------------------------------------------------------------------
+      // syntax analysis
+      auto parsePhase = stats.phase("parse");
+      auto parser = Parser(tokens, astCtx);
+      root = parser.parse();
+      parsePhase.stop();
+      // a hit reports nothing, so only files that reported nothing are stored
+      if (!astCacheDir.empty() && Diag::getInstance()->getEntries().empty()) {
+        cache.store(program, *root);
+      }
+    }
+    stats.count("ast nodes", astCtx.nodeCount());
+    stats.count("ast bytes", astCtx.bytesAllocated());
+    compile(*root, optLevel);
+  } catch (const std::runtime_error &e) {
+    Diag::getInstance()->printAll();
+    std::cerr << "Build failed: " << e.what() << std::endl;
+    printReport();
+    return;
+  }
+  printReport();
+}
 
-    // semantic analysis
-    // 知道变量类型，作用域，函数调用，重定义，未定义等行为
-    auto passDriver = PassDriver(*root);
-    auto symbolTable = SymbolTable();
-    auto semanticCtx = SemanticCtx(symbolTable);
-    Catime::declareBuiltins(semanticCtx);
-    passDriver.runSemanticPass(semanticCtx);
+void Cat::buildFiles(const vec<std::string> &inputs, llvm::OptimizationLevel optLevel) {
+  auto &stats = *Stats::getInstance();
+  vec<uptr<SourceBuffer>> sources;
+  for (const auto &path: ParallelFrontEnd::expandInputs(inputs)) {
+    auto source = SourceBuffer::openFile(path);
+    if (!source) {
+      std::cerr << "Failed to open file " << path << '\n';
+      std::exit(74);// I/O error
+    }
+    sources.push_back(std::move(source));
+  }
+  // owns the sources and the ASTs until the build finishes
+  ASTCache cache(astCacheDir);
+  ParallelFrontEnd frontEnd(jobs, astCacheDir.empty() ? nullptr : &cache);
+  try {
+    auto parsePhase = stats.phase("lex+parse");
+    Program *root = frontEnd.run(std::move(sources));
+    // one row per file under lex+parse, cpu is the time of the thread that
+    // parsed it
+    for (const auto &file: frontEnd.getFiles()) {
+      stats.nestedPhase(file.source->getName(), file.wallMs, file.cpuMs);
+    }
+    parsePhase.stop();
+    stats.count("files", frontEnd.getFiles().size());
+    if (!astCacheDir.empty()) {
+      stats.count("ast cache hits", frontEnd.cacheHits());
+    }
+    stats.count("tokens", frontEnd.tokenCount());
+    stats.count("ast nodes", frontEnd.nodeCount());
+    stats.count("ast bytes", frontEnd.bytesAllocated());
+    compile(*root, optLevel);
+  } catch (const std::runtime_error &e) {
+    Diag::getInstance()->printAll();
+    std::cerr << "Build failed: " << e.what() << std::endl;
+    printReport();
+    return;
+  }
+  printReport();
+}
+
+void Cat::compile(Program &root, llvm::OptimizationLevel optLevel) {
+  auto &stats = *Stats::getInstance();
+  if (dumpAST) {
+    root.print(std::cout);
+  }
+  // ---------------------------------------------------------------------------
+
+  // semantic analysis and intermediate representation generation using LLVM
+  // 知道变量类型，作用域，函数调用，重定义，未定义等行为
+  // each definition is checked and lowered before the next one is started;
+  // with -j function bodies are checked on worker threads first instead
+  auto symbolTable = SymbolTable();
+  auto semanticCtx = SemanticCtx(symbolTable);
+  Catime::declareBuiltins(semanticCtx);
+  auto passDriver = PassDriver(root);
+  if (jobs > 1) {
+    auto semaPhase = stats.phase("sema");
+    passDriver.runSemanticPass(semanticCtx, jobs);
+    semaPhase.stop();
+  } else {
+    passDriver.addPass(std::make_unique<SemanticDefinitionPass>(semanticCtx));
+  }
+  auto frontPhase = stats.phase(jobs > 1 ? "codegen" : "sema+codegen");
+  CodeGenCtx codeGenCtx("Cat_Module");
+  CodeGen codeGen(codeGenCtx);
+  Catime::genBuiltins(semanticCtx, codeGen);
+  ParallelCodeGen parallelCodeGen(codeGen, semanticCtx, jobs);
+  if (jobs > 1 && ParallelCodeGen::supports(root)) {
+    // top-level functions go to one module per worker
     passDriver.runControlFlowPass(semanticCtx);
-    // semanticCtx.dumpSymbolTable(std::cout);
-    // semanticCtx.dumpFuncFrames(std::cout);
-    // ---------------------------------------------------------------------------
+    parallelCodeGen.run(root);
+  } else {
+    passDriver.addPass(std::make_unique<ControlFlowDefinitionPass>(semanticCtx));
+    passDriver.addPass(std::make_unique<CodeGenDefinitionPass>(codeGen));
+    passDriver.run();
+  }
+  frontPhase.stop();
+  stats.count("symbols", symbolTable.symbolCount());
+  optimizeAndRun(codeGen, parallelCodeGen, optLevel);
+}
 
-    // intermediate representation generation using LLVM
-    CodeGenCtx codeGenCtx("Cat_Module");
-    CodeGen codeGen(codeGenCtx);
-    Catime::genBuiltins(semanticCtx, codeGen);
-    codeGen.compile(root);
-    // ---------------------------------------------------------------------------
-    // optimize the generated IR
-    Optimizier optimizer;
-    optimizer.optimize(codeGenCtx.getModule(), optLevel);
-    if (llvm::verifyModule(codeGenCtx.getModule(), &llvm::errs())) {
+void Cat::optimizeAndRun(CodeGen &codeGen, ParallelCodeGen &parallelCodeGen, llvm::OptimizationLevel optLevel) {
+  auto &stats = *Stats::getInstance();
+  CodeGenCtx &codeGenCtx = codeGen.getContext();
+  // the main module first, then the codegen workers' in order
+  vec<CodeGenCtx *> modules{&codeGenCtx};
+  for (auto *module: parallelCodeGen.modules()) {
+    modules.push_back(module);
+  }
+  auto countIR = [&](const char *functions, const char *instructions) {
+    std::size_t functionCount = 0, instructionCount = 0;
+    for (auto *module: modules) {
+      functionCount += module->getModule().size();
+      instructionCount += module->getModule().getInstructionCount();
+    }
+    stats.count(functions, functionCount);
+    stats.count(instructions, instructionCount);
+  };
+  stats.count("identifiers", Idents::getInstance()->size());
+  // semanticCtx.dumpSymbolTable(std::cout);
+  // semanticCtx.dumpFuncFrames(std::cout);
+  stats.count("ir modules", modules.size());
+  countIR("ir functions", "ir instructions");
+  if (emitLLVM) {
+    codeGen.save();
+    parallelCodeGen.save();
+  }
+  // ---------------------------------------------------------------------------
+  // optimize the generated IR
+  auto optimizePhase = stats.phase("optimize");
+  Optimizier optimizer(stats.timeReport());
+  for (auto *module: modules) {
+    optimizer.optimize(module->getModule(), optLevel);
+  }
+  optimizePhase.stop();
+  countIR("opt ir functions", "opt ir instructions");
+  stats.setPassTimings(optimizer.passReport(stats.format() == CompileStats::Format::Json));
+
+  auto verifyPhase = stats.phase("verify");
+  for (auto *module: modules) {
+    if (llvm::verifyModule(module->getModule(), &llvm::errs())) {
       std::cerr << "Error: Generated LLVM IR is invalid.\n";
       exit(1);
     }
-    optimizer.save(codeGenCtx.getModule());
-    // ---------------------------------------------------------------------------
+  }
+  verifyPhase.stop();
+  if (emitLLVM) {
+    for (std::size_t i = 0; i < modules.size(); ++i) {
+      optimizer.save(modules[i]->getModule(), i == 0 ? "./opt.ll" : "./opt." + std::to_string(i) + ".ll");
+    }
+  }
+  // ---------------------------------------------------------------------------
 
-    // JIT
-    JIT catJit{codeGen};
-    llvm::InitLLVM X(argc, argv);
-    LLVMInitializeNativeTarget();
-    LLVMInitializeNativeAsmPrinter();
-    LLVMInitializeNativeAsmParser();
-    uptr<llvm::Module> M = catJit.loadModule();
-    auto llvmctx = codeGen.getContext().releaseLLVMContext();
+  // JIT
+  JIT catJit{codeGen};
+  llvm::InitLLVM X(argc, argv);
+  LLVMInitializeNativeTarget();
+  LLVMInitializeNativeAsmPrinter();
+  LLVMInitializeNativeAsmParser();
+  std::vector<llvm::orc::ThreadSafeModule> jitModules;
+  jitModules.emplace_back(catJit.loadModule(), codeGen.getContext().releaseLLVMContext());
+  for (auto *module: parallelCodeGen.modules()) {
+    jitModules.emplace_back(module->releaseModule(), module->releaseLLVMContext());
+  }
 
-    llvm::ExitOnError ExitOnErr(std::string(argv[0]) + ": ");
-    ExitOnErr(catJit.run(std::move(M), std::move(llvmctx), argc, argv));
+  llvm::ExitOnError ExitOnErr(std::string(argv[0]) + ": ");
+  ExitOnErr(catJit.run(std::move(jitModules), argc, argv));
+}
 
-  } catch (const std::runtime_error &e) {
-    Diag::getInstance()->printAll();
-    std::cerr << "Build failed: " << e.what() << std::endl;
+void Cat::printReport() const {
+  auto &stats = *Stats::getInstance();
+  if (!stats.enabled()) {
+    return;
+  }
+  if (reportFile.empty()) {
+    std::cout.flush();
+    stats.print(std::cerr);
+    return;
+  }
+  std::ofstream out(reportFile);
+  if (!out) {
+    std::cerr << "Failed to open report file " << reportFile << '\n';
+    return;
+  }
+  stats.print(out);
+}
+
+void Cat::buildFile(string path, llvm::OptimizationLevel optLevel) {
+  // stdin and pipes are lowered as they arrive instead of being read up front
+  if (streamInput || path == "-" || !std::filesystem::is_regular_file(path)) {
+    buildStream(path, optLevel);
     return;
   }
+  if (jobs > 1) {
+    // large files are parsed in chunks
+    buildFiles({path}, optLevel);
+    return;
+  }
+  auto source = SourceBuffer::openFile(path);
+  if (!source) {
+    std::cerr << "Failed to open file " << path << '\n';
+    std::exit(74);// I/O error
+  }
+  build(source->text(), optLevel, path);
 }
 
-std::string Cat::readFile(std::string_view filename) {
-  std::ifstream file{filename.data(), std::ios::ate};
-  if (!file) {
-    std::cerr << "Failed to open file " << filename.data() << '\n';
+void Cat::buildStream(const string &path, llvm::OptimizationLevel optLevel) {
+  auto &stats = *Stats::getInstance();
+  auto stream = SourceStream::open(path);
+  if (!stream) {
+    std::cerr << "Failed to open file " << path << '\n';
     std::exit(74);// I/O error
   }
-  std::string buffer;
-  buffer.resize(file.tellg());
-  file.seekg(0, std::ios::beg);
-  file.read(buffer.data(), buffer.size());
-  file.close();
+  try {
+    auto *srcMgr = SrcMgr::getInstance();
+    auto fileId = srcMgr->addStream(stream->getName());
+    auto symbolTable = SymbolTable();
+    auto semanticCtx = SemanticCtx(symbolTable);
+    Catime::declareBuiltins(semanticCtx);
+    CodeGenCtx codeGenCtx("Cat_Module");
+    CodeGen codeGen(codeGenCtx);
+    Catime::genBuiltins(semanticCtx, codeGen);
+    // stands for the whole input, whose definitions are never parsed all at once
+    Program program(Location{0, fileId});
+    auto passDriver = PassDriver(program);
+    passDriver.addPass(std::make_unique<SemanticDefinitionPass>(semanticCtx));
+    passDriver.addPass(std::make_unique<ControlFlowDefinitionPass>(semanticCtx));
+    passDriver.addPass(std::make_unique<CodeGenDefinitionPass>(codeGen));
 
-  return buffer;
+    auto frontPhase = stats.phase("lex+parse+sema+codegen");
+    std::size_t tokenCount = 0, nodeCount = 0, peakBytes = 0;
+    for (auto text = stream->next(); !text.empty(); text = stream->next()) {
+      srcMgr->addLines(fileId, text, stream->offset());
+      auto scanner = Scanner(text, fileId, stream->offset());
+      auto tokens = scanner.scanTokens();
+      // these definitions are lowered and dropped before the next are read
+      ASTContext astCtx;
+      auto parser = Parser(tokens, astCtx);
+      Program *piece = parser.parse();
+      if (dumpAST) {
+        piece->print(std::cout);
+      }
+      passDriver.run(piece->getDefs());
+      tokenCount += tokens.size();
+      nodeCount += astCtx.nodeCount();
+      peakBytes = std::max(peakBytes, astCtx.bytesAllocated());
+    }
+    passDriver.finish();
+    frontPhase.stop();
+    stats.count("tokens", tokenCount);
+    stats.count("ast nodes", nodeCount);
+    stats.count("peak ast bytes", peakBytes);
+    stats.count("symbols", symbolTable.symbolCount());
+    ParallelCodeGen parallelCodeGen(codeGen, semanticCtx, 1);
+    optimizeAndRun(codeGen, parallelCodeGen, optLevel);
+  } catch (const std::runtime_error &e) {
+    Diag::getInstance()->printAll();
+    std::cerr << "Build failed: " << e.what() << std::endl;
+    printReport();
+    return;
+  }
+  printReport();
 }
 
-
-void Cat::buildFile(string path, llvm::OptimizationLevel optLevel) {
-  std::string source = readFile(path);
-  build(source, optLevel);
+void Cat::watchFile(string path, llvm::OptimizationLevel optLevel) {
+  WatchSession session(std::move(path), jobs, optLevel, argc, argv);
+  session.run();
 }
 
 // void Cat::runFile(string path) {
@@ -0,0 +1,299 @@
+#include "CompileStats.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <new>
+#include <sys/resource.h>
+
+// Every allocation in the compiler goes through here so phases can report how
+// many they made. Nothing is counted unless --mem-report is on, and then each
+// thread counts into a counter of its own, so workers do not share a cache
+// line; allocationCount() sums the counters.
+namespace {
+  std::atomic<bool> countAllocations{false};
+
+  // linked into a list while its thread runs, its count is kept when the
+  // thread ends
+  struct ThreadAllocations {
+    std::atomic<uint64_t> count{0};
+    ThreadAllocations *prev = nullptr;
+    ThreadAllocations *next = nullptr;
+
+    ThreadAllocations();
+    ~ThreadAllocations();
+  };
+
+  std::mutex threadsMutex;
+  ThreadAllocations *threads = nullptr;
+  uint64_t finishedThreads = 0;// allocations of threads that have ended
+  // set once the thread's counter is gone, destructors that run after it
+  // still allocate
+  thread_local bool counterDestroyed = false;
+
+  ThreadAllocations::ThreadAllocations() {
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    next = threads;
+    if (next) {
+      next->prev = this;
+    }
+    threads = this;
+  }
+
+  ThreadAllocations::~ThreadAllocations() {
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    counterDestroyed = true;
+    finishedThreads += count.load(std::memory_order_relaxed);
+    (prev ? prev->next : threads) = next;
+    if (next) {
+      next->prev = prev;
+    }
+  }
+
+  void countAllocation() {
+    if (!countAllocations.load(std::memory_order_relaxed) || counterDestroyed) {
+      return;
+    }
+    thread_local ThreadAllocations counter;
+    // only this thread writes it, no read-modify-write needed
+    counter.count.store(counter.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+}// namespace
+
+void *operator new(std::size_t size) {
+  countAllocation();
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  countAllocation();
+  return std::malloc(size ? size : 1);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+  return ::operator new(size, tag);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+void CompileStats::enableMemReport(bool on) {
+  memReport_ = on;
+  countAllocations.store(on, std::memory_order_relaxed);
+}
+
+uint64_t CompileStats::allocationCount() {
+  std::lock_guard<std::mutex> lock(threadsMutex);
+  uint64_t total = finishedThreads;
+  for (auto *thread = threads; thread; thread = thread->next) {
+    total += thread->count.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+long CompileStats::peakRssKB() {
+  struct rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;// KB on Linux
+}
+
+double CompileStats::cpuTimeMs() {
+  timespec ts{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+double CompileStats::threadCpuTimeMs() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+CompileStats::PhaseTimer::PhaseTimer(CompileStats &s, std::string n)
+    : stats(&s),
+      name(std::move(n)),
+      wallStart(std::chrono::steady_clock::now()),
+      cpuStart(cpuTimeMs()),
+      rssStart(peakRssKB()),
+      allocStart(allocationCount()) {}
+
+void CompileStats::PhaseTimer::stop() {
+  if (!stats) {
+    return;
+  }
+  Phase phase;
+  phase.name = std::move(name);
+  phase.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+  phase.cpuMs = cpuTimeMs() - cpuStart;
+  phase.peakRssDeltaKB = peakRssKB() - rssStart;
+  phase.allocations = allocationCount() - allocStart;
+  stats->phases_.push_back(std::move(phase));
+  for (auto &nested: stats->pendingNested_) {
+    stats->phases_.push_back(std::move(nested));
+  }
+  stats->pendingNested_.clear();
+  stats = nullptr;
+}
+
+void CompileStats::count(std::string name, uint64_t value) {
+  for (auto &entry: counts_) {
+    if (entry.first == name) {
+      entry.second = value;
+      return;
+    }
+  }
+  counts_.emplace_back(std::move(name), value);
+}
+
+void CompileStats::nestedPhase(std::string name, double wallMs, double cpuMs) {
+  Phase phase;
+  phase.name = std::move(name);
+  phase.wallMs = wallMs;
+  phase.cpuMs = cpuMs;
+  phase.nested = true;
+  pendingNested_.push_back(std::move(phase));
+}
+
+void CompileStats::print(std::ostream &out) const {
+  if (!enabled()) {
+    return;
+  }
+  if (format_ == Format::Json) {
+    printJson(out);
+  } else {
+    printText(out);
+  }
+}
+
+void CompileStats::printText(std::ostream &out) const {
+  char line[160];
+  out << "===== Cat compile report =====\n";
+  std::snprintf(line, sizeof line, "%-12s", "phase");
+  out << line;
+  if (timeReport_) {
+    std::snprintf(line, sizeof line, " %12s %12s", "wall ms", "cpu ms");
+    out << line;
+  }
+  if (memReport_) {
+    std::snprintf(line, sizeof line, " %14s %12s", "peak rss +KB", "allocs");
+    out << line;
+  }
+  out << '\n';
+
+  auto printRow = [&](const Phase &p) {
+    std::snprintf(line, sizeof line, "%-12s", ((p.nested ? "  " : "") + p.name).c_str());
+    out << line;
+    if (timeReport_) {
+      std::snprintf(line, sizeof line, " %12.2f %12.2f", p.wallMs, p.cpuMs);
+      out << line;
+    }
+    if (memReport_ && !p.nested) {
+      std::snprintf(line, sizeof line, " %14ld %12llu", p.peakRssDeltaKB, static_cast<unsigned long long>(p.allocations));
+      out << line;
+    }
+    out << '\n';
+  };
+  Phase total;
+  total.name = "total";
+  for (const Phase &p: phases_) {
+    printRow(p);
+    if (p.nested) {
+      continue;
+    }
+    total.wallMs += p.wallMs;
+    total.cpuMs += p.cpuMs;
+    total.peakRssDeltaKB += p.peakRssDeltaKB;
+    total.allocations += p.allocations;
+  }
+  printRow(total);
+  if (memReport_) {
+    out << "peak rss: " << peakRssKB() << " KB\n";
+  }
+
+  if (!counts_.empty()) {
+    out << "----- counts -----\n";
+    for (const auto &[name, value]: counts_) {
+      std::snprintf(line, sizeof line, "%-20s %12llu\n", name.c_str(), static_cast<unsigned long long>(value));
+      out << line;
+    }
+  }
+  if (timeReport_ && !passTimings_.empty()) {
+    out << "----- LLVM passes -----\n"
+        << passTimings_;
+  }
+}
+
+namespace {
+  // phase names include the input file paths, which may contain anything
+  void writeJsonString(std::ostream &out, const std::string &text) {
+    out << '"';
+    for (char c: text) {
+      switch (c) {
+        case '"':
+          out << "\\\"";
+          break;
+        case '\\':
+          out << "\\\\";
+          break;
+        case '\n':
+          out << "\\n";
+          break;
+        case '\t':
+          out << "\\t";
+          break;
+        case '\r':
+          out << "\\r";
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof escape, "\\u%04x", static_cast<unsigned>(c));
+            out << escape;
+          } else {
+            out << c;
+          }
+      }
+    }
+    out << '"';
+  }
+}// namespace
+
+void CompileStats::printJson(std::ostream &out) const {
+  out << "{\n  \"phases\": [";
+  for (std::size_t i = 0; i < phases_.size(); ++i) {
+    const Phase &p = phases_[i];
+    out << (i ? ",\n" : "\n") << "    {\"name\": ";
+    writeJsonString(out, p.name);
+    if (p.nested) {
+      out << ", \"nested\": true";
+    }
+    if (timeReport_) {
+      out << ", \"wall_ms\": " << p.wallMs << ", \"cpu_ms\": " << p.cpuMs;
+    }
+    if (memReport_ && !p.nested) {
+      out << ", \"peak_rss_delta_kb\": " << p.peakRssDeltaKB << ", \"allocations\": " << p.allocations;
+    }
+    out << '}';
+  }
+  out << "\n  ],\n  \"counts\": {";
+  for (std::size_t i = 0; i < counts_.size(); ++i) {
+    out << (i ? ",\n" : "\n") << "    ";
+    writeJsonString(out, counts_[i].first);
+    out << ": " << counts_[i].second;
+  }
+  out << "\n  }";
+  if (memReport_) {
+    out << ",\n  \"peak_rss_kb\": " << peakRssKB();
+  }
+  if (timeReport_ && !passTimings_.empty()) {
+    out << ",\n  \"passes\": {\n"
+        << passTimings_ << "\n  }";
+  }
+  out << "\n}\n";
+}
@@ -1,5 +1,6 @@
 #include "Diagnostics.hpp"
 #include "Location.hpp"
+#include "SourceManager.hpp"
 
 #include <cstdarg>
 #include <iostream>
@@ -31,7 +32,22 @@ namespace {
 
 }// namespace
 
+thread_local Diagnostics *Diagnostics::threadSink = nullptr;
+
+Diagnostics::Redirect::Redirect(Diagnostics &sink) : previous(threadSink) {
+  threadSink = &sink;
+}
+
+Diagnostics::Redirect::~Redirect() {
+  threadSink = previous;
+}
+
 void Diagnostics::report(Severity severity, Phase phase, const Location &loc, const std::string &message) {
+  if (threadSink && threadSink != this) {
+    threadSink->report(severity, phase, loc, message);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
   entries.push_back(Entry{severity, phase, loc, message});
   if (severity == Severity::Error) {
     ++error_count;
@@ -40,17 +56,21 @@ void Diagnostics::report(Severity severity, Phase phase, const Location &loc, co
   }
 }
 
-void Diagnostics::report(Severity severity, int line, int col, const char *fmt, ...) {
+void Diagnostics::report(Severity severity, const Location &loc, const char *fmt, ...) {
   char buffer[512];
   va_list args;
   va_start(args, fmt);
   vsnprintf(buffer, sizeof(buffer), fmt, args);
   va_end(args);
 
-  Location loc{line, col};
   report(severity, Phase::Lexing, loc, std::string(buffer));
 }
 
+void Diagnostics::reportRedefinition(const std::string &name, const Location &loc, const Location &previous) {
+  report(Severity::Error, Phase::SemanticAnalysis, loc, "redefinition of '" + name + "'");
+  report(Severity::Info, Phase::SemanticAnalysis, previous, "previous definition of '" + name + "' is here");
+}
+
 bool Diagnostics::hasErrors() const {
   return error_count > 0;
 }
@@ -68,16 +88,25 @@ const std::vector<Diagnostics::Entry> &Diagnostics::getEntries() const {
 }
 
 void Diagnostics::printAll() const {
+  auto srcMgr = SrcMgr::getInstance();
   for (const auto &entry: entries) {
 
-    std::cerr << entry.loc.line << ':' << entry.loc.column << ": "
+    std::cerr << srcMgr->format(entry.loc) << ": "
               << toString(entry.phase) << " "
               << toString(entry.severity) << ": "
               << entry.message << '\n';
   }
 }
 
+void Diagnostics::append(const Diagnostics &other) {
+  std::scoped_lock lock(mutex, other.mutex);
+  entries.insert(entries.end(), other.entries.begin(), other.entries.end());
+  error_count += other.error_count;
+  warning_count += other.warning_count;
+}
+
 void Diagnostics::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
   entries.clear();
   error_count = 0;
   warning_count = 0;
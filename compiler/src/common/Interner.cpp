@@ -0,0 +1,57 @@
+#include "Interner.hpp"
+#include <functional>
+
+Interner::Interner() {
+  // id 0 is the empty name
+  intern("");
+}
+
+Interner::~Interner() {
+  for (auto &chunk: chunks) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+Interner::Shard &Interner::shardFor(std::string_view text) const {
+  return shards[std::hash<std::string_view>()(text) % shardCount];
+}
+
+Ident Interner::intern(std::string_view text) {
+  const llvm::StringRef key(text.data(), text.size());
+  Shard &shard = shardFor(text);
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.ids.find(key);
+    if (it != shard.ids.end()) {
+      return Ident{it->second};
+    }
+  }
+  // another thread may have added it in between
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  auto [it, inserted] = shard.ids.try_emplace(key, 0);
+  if (inserted) {
+    it->second = append(text);
+  }
+  return Ident{it->second};
+}
+
+uint32_t Interner::append(std::string_view text) {
+  std::lock_guard<std::mutex> lock(appendMutex);
+  const uint32_t id = count.load(std::memory_order_relaxed);
+  auto [chunk, index] = locate(id);
+  std::string *storage = chunks[chunk].load(std::memory_order_relaxed);
+  if (!storage) {
+    storage = new std::string[std::size_t(1) << (chunk + firstChunkBits)];
+    chunks[chunk].store(storage, std::memory_order_release);
+  }
+  storage[index] = std::string(text);
+  count.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+Ident Interner::find(std::string_view text) const {
+  Shard &shard = shardFor(text);
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  auto it = shard.ids.find(llvm::StringRef(text.data(), text.size()));
+  return it == shard.ids.end() ? Ident{} : Ident{it->second};
+}
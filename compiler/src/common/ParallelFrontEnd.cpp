@@ -0,0 +1,275 @@
+#include "ParallelFrontEnd.hpp"
+#include "CompileStats.hpp"
+#include "Interner.hpp"
+#include "Parser.hpp"
+#include "Scanner.hpp"
+#include "SourceManager.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <llvm-20/llvm/ADT/DenseMap.h>
+#include <stdexcept>
+#include <thread>
+
+vec<std::string> ParallelFrontEnd::expandInputs(const vec<std::string> &inputs) {
+  namespace fs = std::filesystem;
+  vec<std::string> paths;
+  for (const auto &input: inputs) {
+    std::error_code ec;
+    if (!fs::is_directory(input, ec)) {
+      paths.push_back(input);
+      continue;
+    }
+    vec<std::string> found;
+    for (const auto &entry: fs::recursive_directory_iterator(input, ec)) {
+      if (entry.is_regular_file() && entry.path().extension() == ".cat") {
+        found.push_back(entry.path().string());
+      }
+    }
+    std::sort(found.begin(), found.end());
+    paths.insert(paths.end(), found.begin(), found.end());
+  }
+  return paths;
+}
+
+void ParallelFrontEnd::splitFile(File &file, bool split) const {
+  const std::size_t size = file.source->text().size();
+  vec<std::size_t> cuts{0};
+  // a few chunks per thread so the big files even out
+  if (split && jobs > 1 && size >= 2 * minChunkBytes) {
+    cuts = Scanner::splitDefinitions(file.source->text(), std::max(minChunkBytes, size / (jobs * 4)));
+  }
+  file.chunks.clear();
+  for (std::size_t i = 0; i < cuts.size(); ++i) {
+    Chunk chunk;
+    chunk.begin = cuts[i];
+    chunk.end = i + 1 < cuts.size() ? cuts[i + 1] : size;
+    chunk.diags = std::make_unique<Diagnostics>();
+    file.chunks.push_back(std::move(chunk));
+  }
+}
+
+void ParallelFrontEnd::parseChunk(const File &file, Chunk &chunk) {
+  chunk.started = std::chrono::steady_clock::now();
+  const double cpuStart = CompileStats::threadCpuTimeMs();
+  Diagnostics::Redirect redirect(*chunk.diags);
+  try {
+    Scanner scanner(file.source->text(), file.fileId, chunk.begin, chunk.end);
+    chunk.tokens = std::make_unique<TokenBuffer>(scanner.scanTokens());
+    chunk.astCtx = std::make_unique<ASTContext>();
+    Parser parser(*chunk.tokens, *chunk.astCtx);
+    chunk.root = parser.parse();
+    collectDefinitions(chunk);
+  } catch (const std::runtime_error &) {
+    // reported into the chunk's buffer already
+    chunk.root = nullptr;
+  }
+  chunk.finished = std::chrono::steady_clock::now();
+  chunk.cpuMs = CompileStats::threadCpuTimeMs() - cpuStart;
+}
+
+void ParallelFrontEnd::collectDefinitions(Chunk &chunk) {
+  for (auto *def: chunk.root->getDefs()) {
+    if (auto *func = llvm::dyn_cast<FuncDef>(def)) {
+      chunk.definitions.emplace_back(func->funcHeader()->ident(), func->funcHeader()->loc);
+    } else if (auto *cls = llvm::dyn_cast<ClassDecl>(def)) {
+      chunk.definitions.emplace_back(cls->ident(), cls->loc);
+    } else if (auto *var = llvm::dyn_cast<VarDef>(def)) {
+      for (Ident name: var->identifiers()) {
+        chunk.definitions.emplace_back(name, var->loc);
+      }
+    }
+  }
+}
+
+void ParallelFrontEnd::loadCached(File &file) const {
+  splitFile(file, false);
+  Chunk &chunk = file.chunks.front();
+  chunk.started = std::chrono::steady_clock::now();
+  const double cpuStart = CompileStats::threadCpuTimeMs();
+  chunk.astCtx = std::make_unique<ASTContext>();
+  chunk.root = cache->load(file.source->text(), file.fileId, *chunk.astCtx);
+  if (!chunk.root) {
+    file.chunks.clear();
+    return;
+  }
+  collectDefinitions(chunk);
+  chunk.cached = true;
+  chunk.finished = std::chrono::steady_clock::now();
+  chunk.cpuMs = CompileStats::threadCpuTimeMs() - cpuStart;
+}
+
+void ParallelFrontEnd::storeCached(const File &file) const {
+  if (file.chunks.front().cached) {
+    return;
+  }
+  for (const auto &chunk: file.chunks) {
+    if (failed(chunk) || !chunk.diags->getEntries().empty()) {
+      return;
+    }
+  }
+  if (file.chunks.size() == 1) {
+    cache->store(file.source->text(), *file.chunks.front().root);
+    return;
+  }
+  // a split file is stored as the one Program the serial parse builds
+  vec<ASTNode *> defs;
+  for (const auto &chunk: file.chunks) {
+    auto chunkDefs = chunk.root->getDefs();
+    defs.insert(defs.end(), chunkDefs.begin(), chunkDefs.end());
+  }
+  ASTContext ctx;
+  cache->store(file.source->text(), *ctx.create<Program>(file.chunks.front().root->loc, ctx.list<ASTNode *>(defs)));
+}
+
+bool ParallelFrontEnd::failed(const Chunk &chunk) {
+  return chunk.root == nullptr || chunk.diags->hasErrors();
+}
+
+void ParallelFrontEnd::checkDefinitions() const {
+  llvm::DenseMap<Ident, Location> seen;
+  for (const auto &file: files) {
+    for (const auto &chunk: file.chunks) {
+      for (const auto &[name, loc]: chunk.definitions) {
+        auto [it, inserted] = seen.try_emplace(name, loc);
+        if (inserted) {
+          continue;
+        }
+        Diag::getInstance()->reportRedefinition(spelling(name), loc, it->second);
+        throw std::runtime_error("semantic analysis failed");
+      }
+    }
+  }
+}
+
+Program *ParallelFrontEnd::run(vec<uptr<SourceBuffer>> sources) {
+  // file ids are handed out here so they follow the command line
+  for (auto &source: sources) {
+    File file;
+    file.fileId = SrcMgr::getInstance()->addFile(source->getName(), source->text());
+    file.source = std::move(source);
+    files.push_back(std::move(file));
+  }
+  if (cache) {
+    forEachOnPool(files.size(), [&](std::size_t f) { loadCached(files[f]); });
+  }
+  for (auto &file: files) {
+    if (file.chunks.empty()) {
+      splitFile(file, true);
+    }
+  }
+
+  // the largest chunks start first so one of them does not finish last alone
+  vec<std::pair<std::size_t, std::size_t>> order;
+  for (std::size_t f = 0; f < files.size(); ++f) {
+    for (std::size_t c = 0; c < files[f].chunks.size(); ++c) {
+      if (!files[f].chunks[c].cached) {
+        order.emplace_back(f, c);
+      }
+    }
+  }
+  auto bytes = [&](const std::pair<std::size_t, std::size_t> &item) {
+    const Chunk &chunk = files[item.first].chunks[item.second];
+    return chunk.end - chunk.begin;
+  };
+  std::stable_sort(order.begin(), order.end(), [&](const auto &a, const auto &b) { return bytes(a) > bytes(b); });
+  forEachOnPool(order.size(), [&](std::size_t k) {
+    File &file = files[order[k].first];
+    parseChunk(file, file.chunks[order[k].second]);
+  });
+
+  // every file that failed is reported, in command-line order
+  auto *diag = Diag::getInstance();
+  bool anyFailed = false;
+  for (auto &file: files) {
+    const bool split = file.chunks.size() > 1;
+    if (split && std::any_of(file.chunks.begin(), file.chunks.end(), failed)) {
+      // the serial parse stops at the first error and reports lexing errors
+      // of the whole file before it; only a parse in one piece says the same
+      splitFile(file, false);
+      parseChunk(file, file.chunks.front());
+    }
+    for (const auto &chunk: file.chunks) {
+      diag->append(*chunk.diags);
+      anyFailed |= failed(chunk);
+    }
+    auto started = file.chunks.front().started;
+    auto finished = file.chunks.front().finished;
+    for (const auto &chunk: file.chunks) {
+      started = std::min(started, chunk.started);
+      finished = std::max(finished, chunk.finished);
+      file.cpuMs += chunk.cpuMs;
+    }
+    file.wallMs = std::chrono::duration<double, std::milli>(finished - started).count();
+  }
+  if (cache) {
+    forEachOnPool(files.size(), [&](std::size_t f) { storeCached(files[f]); });
+  }
+  if (anyFailed) {
+    throw std::runtime_error("Parsing failed");
+  }
+  checkDefinitions();
+
+  vec<ASTNode *> defs;
+  for (const auto &file: files) {
+    for (const auto &chunk: file.chunks) {
+      auto chunkDefs = chunk.root->getDefs();
+      defs.insert(defs.end(), chunkDefs.begin(), chunkDefs.end());
+    }
+  }
+  Location loc = files.empty() ? Location{} : files.front().chunks.front().root->loc;
+  return programCtx.create<Program>(loc, programCtx.list<ASTNode *>(defs));
+}
+
+void ParallelFrontEnd::forEachOnPool(std::size_t count, const std::function<void(std::size_t)> &fn) const {
+  std::atomic<std::size_t> next{0};
+  auto work = [&] {
+    for (std::size_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+      fn(k);
+    }
+  };
+  const unsigned threads = std::max<std::size_t>(1, std::min<std::size_t>(jobs, count));
+  vec<std::thread> pool;
+  for (unsigned t = 1; t < threads; ++t) {
+    pool.emplace_back(work);
+  }
+  work();
+  for (auto &thread: pool) {
+    thread.join();
+  }
+}
+
+std::size_t ParallelFrontEnd::tokenCount() const {
+  std::size_t count = 0;
+  for (const auto &file: files) {
+    for (const auto &chunk: file.chunks) {
+      count += chunk.tokens ? chunk.tokens->size() : 0;
+    }
+  }
+  return count;
+}
+
+std::size_t ParallelFrontEnd::nodeCount() const {
+  std::size_t count = programCtx.nodeCount();
+  for (const auto &file: files) {
+    for (const auto &chunk: file.chunks) {
+      count += chunk.astCtx ? chunk.astCtx->nodeCount() : 0;
+    }
+  }
+  return count;
+}
+
+std::size_t ParallelFrontEnd::cacheHits() const {
+  return std::count_if(files.begin(), files.end(), [](const File &file) { return file.chunks.front().cached; });
+}
+
+std::size_t ParallelFrontEnd::bytesAllocated() const {
+  std::size_t bytes = programCtx.bytesAllocated();
+  for (const auto &file: files) {
+    for (const auto &chunk: file.chunks) {
+      bytes += chunk.astCtx ? chunk.astCtx->bytesAllocated() : 0;
+    }
+  }
+  return bytes;
+}
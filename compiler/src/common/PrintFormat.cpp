@@ -0,0 +1,76 @@
+#include "PrintFormat.hpp"
+#include <cstddef>
+#include <utility>
+
+namespace {
+  bool isDigit(char c) { return c >= '0' && c <= '9'; }
+}// namespace
+
+std::vector<FormatPiece> parseFormat(std::string_view format) {
+  std::vector<FormatPiece> pieces;
+  auto appendText = [&](std::string_view text) {
+    if (pieces.empty() || pieces.back().kind != FormatPiece::Kind::Text) {
+      pieces.push_back({FormatPiece::Kind::Text, std::string(), 0});
+    }
+    pieces.back().text.append(text);
+  };
+
+  std::size_t i = 0;
+  while (i < format.size()) {
+    const std::size_t percent = format.find('%', i);
+    if (percent == std::string_view::npos) {
+      appendText(format.substr(i));
+      break;
+    }
+    appendText(format.substr(i, percent - i));
+    if (percent + 1 < format.size() && format[percent + 1] == '%') {
+      appendText("%");
+      i = percent + 2;
+      continue;
+    }
+
+    // %[flags][width][.precision]conversion; '*' and length modifiers would
+    // need arguments Cat cannot express, they end up Invalid
+    std::size_t j = percent + 1;
+    while (j < format.size() && std::string_view("-+ #0").find(format[j]) != std::string_view::npos) {
+      ++j;
+    }
+    while (j < format.size() && isDigit(format[j])) {
+      ++j;
+    }
+    if (j < format.size() && format[j] == '.') {
+      ++j;
+      while (j < format.size() && isDigit(format[j])) {
+        ++j;
+      }
+    }
+    const bool plain = j == percent + 1;
+    const char conversion = j < format.size() ? format[j] : 0;
+    FormatPiece piece{FormatPiece::Kind::Invalid, std::string(format.substr(percent, j + 1 - percent)), conversion};
+    switch (conversion) {
+      case 'd':
+      case 'i':
+        piece.kind = plain ? FormatPiece::Kind::Int : FormatPiece::Kind::Spec;
+        break;
+      case 'u':
+        piece.kind = plain ? FormatPiece::Kind::Unsigned : FormatPiece::Kind::Spec;
+        break;
+      case 'c':
+        piece.kind = plain ? FormatPiece::Kind::Char : FormatPiece::Kind::Spec;
+        break;
+      case 's':
+        piece.kind = plain ? FormatPiece::Kind::Str : FormatPiece::Kind::Spec;
+        break;
+      case 'o':
+      case 'x':
+      case 'X':
+        piece.kind = FormatPiece::Kind::Spec;
+        break;
+      default:
+        break;
+    }
+    pieces.push_back(std::move(piece));
+    i = j + 1;
+  }
+  return pieces;
+}
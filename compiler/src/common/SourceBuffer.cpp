@@ -0,0 +1,59 @@
+#include "SourceBuffer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+std::unique_ptr<SourceBuffer> SourceBuffer::openFile(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  std::unique_ptr<SourceBuffer> buffer(new SourceBuffer());
+  buffer->name = path;
+
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      // the scanner walks the file front to back exactly once
+      ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      buffer->data = static_cast<const char *>(addr);
+      buffer->size = st.st_size;
+      buffer->mapped = true;
+      ::close(fd);
+      return buffer;
+    }
+  }
+
+  // fall back to reading the whole stream
+  char chunk[64 * 1024];
+  ssize_t n;
+  while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+    buffer->owned.append(chunk, n);
+  }
+  ::close(fd);
+  if (n < 0) {
+    return nullptr;
+  }
+  buffer->data = buffer->owned.data();
+  buffer->size = buffer->owned.size();
+  return buffer;
+}
+
+std::unique_ptr<SourceBuffer> SourceBuffer::fromString(std::string source, std::string name) {
+  std::unique_ptr<SourceBuffer> buffer(new SourceBuffer());
+  buffer->owned = std::move(source);
+  buffer->name = std::move(name);
+  buffer->data = buffer->owned.data();
+  buffer->size = buffer->owned.size();
+  return buffer;
+}
+
+SourceBuffer::~SourceBuffer() {
+  if (mapped) {
+    ::munmap(const_cast<char *>(data), size);
+  }
+}
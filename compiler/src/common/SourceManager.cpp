@@ -0,0 +1,81 @@
+#include "SourceManager.hpp"
+#include "SimdScan.hpp"
+
+#include <algorithm>
+#include <utility>
+
+uint32_t SourceManager::addFile(std::string name, std::string_view text) {
+  std::lock_guard<std::mutex> lock(mutex);
+  files.push_back(File{std::move(name), text, {}, false});
+  return static_cast<uint32_t>(files.size() - 1);
+}
+
+void SourceManager::setText(uint32_t fileId, std::string_view text) {
+  std::lock_guard<std::mutex> lock(mutex);
+  File &file = files[fileId];
+  file.text = text;
+  file.lineStarts.clear();
+  file.scanned = false;
+}
+
+uint32_t SourceManager::addStream(std::string name) {
+  std::lock_guard<std::mutex> lock(mutex);
+  files.push_back(File{std::move(name), {}, {0}, true});
+  return static_cast<uint32_t>(files.size() - 1);
+}
+
+void SourceManager::addLines(uint32_t fileId, std::string_view piece, uint32_t base) {
+  std::lock_guard<std::mutex> lock(mutex);
+  File &file = files[fileId];
+  const char *begin = piece.data();
+  const char *end = begin + piece.size();
+  for (const char *p = simd::findChar(begin, end, '\n'); p < end; p = simd::findChar(p + 1, end, '\n')) {
+    file.lineStarts.push_back(base + static_cast<uint32_t>(p + 1 - begin));
+  }
+}
+
+const SourceManager::File *SourceManager::lineTable(uint32_t fileId) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (fileId >= files.size()) {
+    return nullptr;
+  }
+  File &file = files[fileId];
+  if (!file.scanned) {
+    const char *begin = file.text.data();
+    const char *end = begin + file.text.size();
+    file.lineStarts.push_back(0);
+    for (const char *p = simd::findChar(begin, end, '\n'); p < end; p = simd::findChar(p + 1, end, '\n')) {
+      file.lineStarts.push_back(static_cast<uint32_t>(p + 1 - begin));
+    }
+    file.scanned = true;
+  }
+  return &file;
+}
+
+SourceManager::LineColumn SourceManager::resolve(const Location &loc) const {
+  const File *file = loc.isValid() ? lineTable(loc.fileId) : nullptr;
+  if (!file) {
+    return {-1, -1};
+  }
+  auto it = std::upper_bound(file->lineStarts.begin(), file->lineStarts.end(), loc.offset);
+  auto line = static_cast<int>(it - file->lineStarts.begin());
+  return {line, static_cast<int>(loc.offset - *(it - 1)) + 1};
+}
+
+const std::string &SourceManager::getFileName(uint32_t fileId) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return files[fileId].name;
+}
+
+std::string_view SourceManager::getText(uint32_t fileId) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return files[fileId].text;
+}
+
+std::string SourceManager::format(const Location &loc) const {
+  if (!loc.isValid()) {
+    return "<builtin>";
+  }
+  LineColumn lc = resolve(loc);
+  return getFileName(loc.fileId) + ':' + std::to_string(lc.line) + ':' + std::to_string(lc.column);
+}
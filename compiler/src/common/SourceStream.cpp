@@ -0,0 +1,68 @@
+#include "SourceStream.hpp"
+#include "Scanner.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <limits>
+#include <stdexcept>
+#include <unistd.h>
+
+std::unique_ptr<SourceStream> SourceStream::open(const std::string &path) {
+  int fd = path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  std::unique_ptr<SourceStream> stream(new SourceStream());
+  stream->fd = fd;
+  stream->name = path == "-" ? "<stdin>" : path;
+  return stream;
+}
+
+SourceStream::~SourceStream() {
+  if (fd != STDIN_FILENO) {
+    ::close(fd);
+  }
+}
+
+void SourceStream::refill() {
+  constexpr std::size_t blockBytes = 64 * 1024;
+  const std::size_t size = pending.size();
+  // locations are 32-bit offsets into the input
+  if (base + size + blockBytes > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error(name + " is larger than 4 GiB");
+  }
+  pending.resize(size + blockBytes);
+  ssize_t n;
+  while ((n = ::read(fd, pending.data() + size, blockBytes)) < 0 && errno == EINTR) {}
+  pending.resize(size + std::max<ssize_t>(n, 0));
+  if (n < 0) {
+    throw std::runtime_error("failed to read " + name);
+  }
+  eof = n == 0;
+}
+
+std::string_view SourceStream::next() {
+  pending.erase(0, handed);
+  base += handed;
+  handed = 0;
+  // a definition longer than what is buffered doubles what is read before
+  // the next try, so a long one is split over in linear time
+  for (std::size_t wanted = 2 * chunkBytes;; wanted = 2 * pending.size()) {
+    while (!eof && pending.size() < wanted) {
+      refill();
+    }
+    if (eof) {
+      handed = pending.size();
+      break;
+    }
+    // whatever follows the last cut may not be complete yet
+    auto cuts = Scanner::splitDefinitions(pending, chunkBytes);
+    if (cuts.size() > 1) {
+      handed = cuts.back();
+      break;
+    }
+  }
+  return {pending.data(), handed};
+}
@@ -0,0 +1,436 @@
+#include "WatchSession.hpp"
+#include "ASTWalker.hpp"
+#include "CodeGen.hpp"
+#include "CodeGenCtx.hpp"
+#include "ControlFlowPass.hpp"
+#include "Diagnostics.hpp"
+#include "OutputBuffer.hpp"
+#include "Optimizer.hpp"
+#include "ParallelCodeGen.hpp"
+#include "Parser.hpp"
+#include "PassDriver.hpp"
+#include "Scanner.hpp"
+#include "SemanticCtx.hpp"
+#include "SourceManager.hpp"
+#include "SymbolTable.hpp"
+#include "catlib.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <llvm-20/llvm/ADT/Hashing.h>
+#include <llvm-20/llvm/IR/Verifier.h>
+#include <llvm-20/llvm/Support/xxhash.h>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  // every name a definition refers to that could be a global: variables,
+  // functions and classes. Locals are included too, which only means a
+  // global of the same name being added or removed counts as a change.
+  class UsedNames : public AstWalker<UsedNames> {
+    public:
+    vec<Ident> names;
+
+    template<typename T>
+    void each(ASTList<T> nodes) {
+      for (auto *node: nodes) {
+        walk(node);
+      }
+    }
+    void child(ASTNode *node) {
+      if (node) {
+        walk(node);
+      }
+    }
+
+    void visit(Program &node) { each(node.getDefs()); }
+    void visit(Block &node) { each(node.statementsList()); }
+    void visit(Header &node) { each(node.parameters()); }
+    void visit(FuncParameterDecl &node) { walk(node.parameterType()); }
+    void visit(FuncDecl &node) { walk(node.funcHeader()); }
+    void visit(ClassDecl &node) {
+      each(node.fieldList());
+      each(node.methodList());
+    }
+    void visit(Type &node) {
+      if (node.typeName()) {
+        names.push_back(node.typeName());
+      }
+    }
+    void visit(FuncParameterType &node) { visit(static_cast<Type &>(node)); }
+    void visit(VarDef &node) {
+      walk(node.declaredType());
+      child(node.initExpr());
+    }
+    void visit(FuncDef &node) {
+      walk(node.funcHeader());
+      walk(node.funcBody());
+    }
+    void visit(SkipStmt &) {}
+    void visit(ExitStmt &) {}
+    void visit(AssignStmt &node) {
+      walk(node.left());
+      walk(node.right());
+    }
+    void visit(ReturnStmt &node) { child(node.returnValue()); }
+    void visit(ProcCall &node) {
+      names.push_back(node.ident());
+      each(node.arguments());
+    }
+    void visit(BreakStmt &) {}
+    void visit(ContinueStmt &) {}
+    void visit(IfStmt &node) {
+      walk(node.conditionExpr());
+      walk(node.thenBlock());
+      for (const auto &[cond, block]: node.elifs()) {
+        walk(cond);
+        walk(block);
+      }
+      child(node.elseBlock());
+    }
+    void visit(LoopStmt &node) {
+      walk(node.conditionExpr());
+      walk(node.loopBody());
+    }
+    void visit(IdLVal &node) { names.push_back(node.ident()); }
+    void visit(StringLiteralLVal &) {}
+    void visit(IndexLVal &node) {
+      walk(node.baseExpr());
+      walk(node.indexExpr());
+    }
+    void visit(MemberAccessLVal &node) { walk(node.object()); }
+    void visit(LValueExpr &node) { walk(node.lvalue()); }
+    void visit(ParenExpr &node) { walk(node.innerExpr()); }
+    void visit(FuncCall &node) {
+      names.push_back(node.ident());
+      each(node.arguments());
+    }
+    void visit(MemberAccessExpr &node) { walk(node.object()); }
+    void visit(MethodCall &node) {
+      walk(node.object());
+      each(node.arguments());
+    }
+    void visit(NewExpr &node) {
+      names.push_back(node.classIdent());
+      each(node.getArgs());
+    }
+    void visit(UnaryExpr &node) { walk(node.operandExpr()); }
+    void visit(BinaryExpr &node) {
+      walk(node.leftExpr());
+      walk(node.rightExpr());
+    }
+    void visit(ArrayExpr &node) { each(node.getElements()); }
+    void visit(IntConst &) {}
+    void visit(CharConst &) {}
+    void visit(TrueConst &) {}
+    void visit(FalseConst &) {}
+    void visit(ExprCond &node) { walk(node.expression()); }
+  };
+
+  vec<Ident> usedNames(ASTNode *def) {
+    UsedNames collector;
+    collector.walk(def);
+    auto &names = collector.names;
+    std::sort(names.begin(), names.end(), [](Ident a, Ident b) { return a.id < b.id; });
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return std::move(names);
+  }
+
+  // what callers are checked against: the name, parameters and return type
+  uint64_t interfaceHash(const Header &header) {
+    const auto returnType = header.returnType();
+    llvm::hash_code hash = llvm::hash_combine(header.ident().id, returnType.has_value(),
+                                              returnType ? static_cast<int>(*returnType) : 0);
+    for (const auto *param: header.parameters()) {
+      const auto *type = param->parameterType();
+      hash = llvm::hash_combine(hash, param->names().size(), type->isByRef(), static_cast<int>(type->data_type()),
+                                type->typeName().id);
+      for (const auto &dim: type->dimensions()) {
+        hash = llvm::hash_combine(hash, dim.has_value(), dim.value_or(0));
+      }
+    }
+    return hash;
+  }
+
+  // the llvm name CodeGen gives a top-level function
+  std::string functionName(FuncDef &def) {
+    return def.isEntrypoint() ? "main" : def.funcHeader()->symbol()->getName();
+  }
+}// namespace
+
+WatchSession::WatchSession(std::string path, unsigned jobs, llvm::OptimizationLevel optLevel, int argc, char **argv)
+    : path(std::move(path)), jobs(jobs), optLevel(optLevel), argc(argc), argv(argv) {}
+
+void WatchSession::run() {
+  llvm::InitLLVM X(argc, argv);
+  LLVMInitializeNativeTarget();
+  LLVMInitializeNativeAsmPrinter();
+  LLVMInitializeNativeAsmParser();
+
+  fileId = SrcMgr::getInstance()->addFile(path, {});
+  namespace fs = std::filesystem;
+  fs::file_time_type lastWrite;
+  std::uintmax_t lastSize = 0;
+  bool first = true;
+  for (;; std::this_thread::sleep_for(std::chrono::milliseconds(100))) {
+    std::error_code writeError, sizeError;
+    const auto write = fs::last_write_time(path, writeError);
+    const auto size = fs::file_size(path, sizeError);
+    if (writeError || sizeError) {
+      if (first) {
+        std::cerr << "Failed to open file " << path << '\n';
+        std::exit(74);// I/O error
+      }
+      continue;// replaced by an editor, back soon
+    }
+    if (!first && write == lastWrite && size == lastSize) {
+      continue;
+    }
+    first = false;
+    lastWrite = write;
+    lastSize = size;
+    // read rather than mapped: an editor may truncate the file while the
+    // diagnostics still point into it
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream text;
+    text << in.rdbuf();
+    source = SourceBuffer::fromString(text.str(), path);
+    if (rebuild(source->text())) {
+      runMain();
+    }
+  }
+}
+
+bool WatchSession::rebuild(std::string_view text) {
+  auto *diag = Diag::getInstance();
+  diag->clear();
+  const auto started = Clock::now();
+  ++generation;
+  try {
+    SrcMgr::getInstance()->setText(fileId, text);
+    auto scanner = Scanner(text, fileId);
+    auto tokens = scanner.scanTokens();
+    ASTContext astCtx;
+    auto parser = Parser(tokens, astCtx);
+    Program *root = parser.parse();
+    const auto defs = root->getDefs();
+
+    // a definition's text runs up to the next one, so every edit lands in one
+    vec<uint64_t> textHash(defs.size());
+    uint64_t shapeHash = 0;
+    // first declaration of each global, and what users of it are checked against
+    llvm::DenseMap<Ident, std::pair<std::size_t, uint64_t>> globals;
+    for (std::size_t i = 0; i < defs.size(); ++i) {
+      const std::size_t begin = defs[i]->loc.offset;
+      const std::size_t end = i + 1 < defs.size() ? defs[i + 1]->loc.offset : text.size();
+      textHash[i] = llvm::xxh3_64bits(llvm::StringRef(text.data() + begin, end - begin));
+      if (auto *func = llvm::dyn_cast<FuncDef>(defs[i])) {
+        globals.try_emplace(func->funcHeader()->ident(), i, interfaceHash(*func->funcHeader()));
+        continue;
+      }
+      shapeHash = llvm::hash_combine(shapeHash, textHash[i]);
+      if (auto *decl = llvm::dyn_cast<FuncDecl>(defs[i])) {
+        globals.try_emplace(decl->funcHeader()->ident(), i, interfaceHash(*decl->funcHeader()));
+      } else if (auto *cls = llvm::dyn_cast<ClassDecl>(defs[i])) {
+        globals.try_emplace(cls->ident(), i, textHash[i]);
+      } else if (auto *var = llvm::dyn_cast<VarDef>(defs[i])) {
+        for (Ident name: var->identifiers()) {
+          globals.try_emplace(name, i, textHash[i]);
+        }
+      }
+    }
+    const bool full = !patchable || shapeHash != shape || !ParallelCodeGen::supports(*root);
+
+    // a function is checked and lowered again if its text changed, or the
+    // interface or visibility of any global it uses
+    vec<bool> unchanged(defs.size());
+    vec<uint64_t> depsHash(defs.size());
+    vec<vec<Ident>> uses(defs.size());
+    vec<ASTNode *> changed;
+    for (std::size_t i = 0; i < defs.size(); ++i) {
+      auto *func = llvm::dyn_cast<FuncDef>(defs[i]);
+      if (!func) {
+        continue;
+      }
+      auto previous = functions.find(func->funcHeader()->ident());
+      const bool sameText = previous != functions.end() && previous->second.text == textHash[i];
+      uses[i] = sameText ? previous->second.uses : usedNames(func);
+      llvm::hash_code deps = 0;
+      for (Ident name: uses[i]) {
+        auto global = globals.find(name);
+        const bool visible = global != globals.end() && global->second.first <= i;
+        deps = llvm::hash_combine(deps, name.id, visible ? global->second.second : 0);
+      }
+      depsHash[i] = deps;
+      unchanged[i] = !full && sameText && previous->second.deps == depsHash[i];
+      if (!unchanged[i]) {
+        changed.push_back(func);
+      }
+    }
+
+    auto symbolTable = SymbolTable();
+    auto semanticCtx = SemanticCtx(symbolTable);
+    Catime::declareBuiltins(semanticCtx);
+    auto passDriver = PassDriver(*root);
+    passDriver.runSemanticPass(semanticCtx, jobs, unchanged);
+    if (full) {
+      passDriver.runControlFlowPass(semanticCtx);
+    } else {
+      auto controlFlow = ControlFlowPass(semanticCtx);
+      for (auto *def: changed) {
+        controlFlow.walk(def);
+      }
+    }
+
+    // an incremental build lowers the classes and declarations again only
+    // for the changed functions to refer to; the JIT keeps the full build's
+    CodeGenCtx codeGenCtx("Cat_Module");
+    CodeGen codeGen(codeGenCtx);
+    Catime::genBuiltins(semanticCtx, codeGen);
+    ParallelCodeGen parallelCodeGen(codeGen, semanticCtx, jobs);
+    if (!full) {
+      parallelCodeGen.run(*root, changed);
+    } else if (ParallelCodeGen::supports(*root)) {
+      parallelCodeGen.run(*root);
+    } else {
+      codeGen.compile(root);
+    }
+    vec<CodeGenCtx *> modules = parallelCodeGen.modules();
+    if (full) {
+      modules.insert(modules.begin(), &codeGenCtx);
+    }
+
+    // every top-level function is defined under a name of this build and
+    // called through the stub of its own name
+    llvm::StringSet<> topLevel;
+    for (auto *def: defs) {
+      if (auto *func = llvm::dyn_cast<FuncDef>(def)) {
+        topLevel.insert(functionName(*func));
+      }
+    }
+    vec<std::string> newStubs, bodies, bodyNames;
+    Optimizier optimizer;
+    for (auto *module: modules) {
+      vec<llvm::Function *> defined;
+      for (auto &fn: module->getModule()) {
+        if (!fn.isDeclaration() && topLevel.contains(fn.getName())) {
+          defined.push_back(&fn);
+        }
+      }
+      for (auto *fn: defined) {
+        std::string name = fn->getName().str();
+        fn->setName(name + "$" + std::to_string(generation));
+        auto *stub = llvm::Function::Create(fn->getFunctionType(), llvm::GlobalValue::ExternalLinkage, name, module->getModule());
+        fn->replaceAllUsesWith(stub);
+        bodies.push_back(fn->getName().str());
+        bodyNames.push_back(name);
+        if (full || !stubs.contains(name)) {
+          newStubs.push_back(name);
+        }
+      }
+      optimizer.optimize(module->getModule(), optLevel);
+      if (llvm::verifyModule(module->getModule(), &llvm::errs())) {
+        std::cerr << "Error: Generated LLVM IR is invalid.\n";
+        exit(1);
+      }
+    }
+
+    // nothing is handed to the JIT before the program checked and lowered
+    // fine; from here a failure leaves it in no state to patch
+    patchable = false;
+    if (full) {
+      jit.reset();
+      stubs.clear();
+      auto created = CatJIT::Create();
+      if (!created) {
+        throw std::runtime_error(llvm::toString(created.takeError()));
+      }
+      jit = std::move(*created);
+      llvm::cantFail(defineRuntime(*jit));
+    }
+    auto check = [](llvm::Error err) {
+      if (err) {
+        throw std::runtime_error(llvm::toString(std::move(err)));
+      }
+    };
+    check(jit->defineStubs(newStubs));
+    for (const auto &name: newStubs) {
+      stubs.insert(name);
+    }
+    vec<ResourceTrackerSP> trackers;
+    for (auto *module: modules) {
+      // a full build is only ever replaced as a whole
+      trackers.push_back(full ? nullptr : jit->createResourceTracker());
+      check(jit->addIRModule(llvm::orc::ThreadSafeModule(module->releaseModule(), module->releaseLLVMContext()), trackers.back()));
+    }
+    auto addresses = jit->lookup(bodies);
+    if (!addresses) {
+      throw std::runtime_error(llvm::toString(addresses.takeError()));
+    }
+    for (std::size_t i = 0; i < bodies.size(); ++i) {
+      check(jit->updateStub(bodyNames[i], (*addresses)[jit->mangle(bodies[i])].getAddress()));
+    }
+
+    // the replaced bodies are no longer reachable through any stub
+    llvm::DenseMap<Ident, Function> built;
+    std::size_t lowered = 0;
+    for (std::size_t i = 0; i < defs.size(); ++i) {
+      auto *func = llvm::dyn_cast<FuncDef>(defs[i]);
+      if (!func) {
+        continue;
+      }
+      Ident name = func->funcHeader()->ident();
+      auto previous = functions.find(name);
+      Function state{textHash[i], depsHash[i], std::move(uses[i]), nullptr};
+      if (unchanged[i]) {
+        state.tracker = previous->second.tracker;
+      } else {
+        if (!full) {
+          state.tracker = trackers[lowered];
+        }
+        ++lowered;
+        if (!full && previous != functions.end() && previous->second.tracker) {
+          check(previous->second.tracker->remove());
+        }
+      }
+      built[name] = std::move(state);
+    }
+    for (auto &[name, removed]: functions) {
+      if (!full && !built.count(name) && removed.tracker) {
+        check(removed.tracker->remove());
+      }
+    }
+    functions = std::move(built);
+    shape = shapeHash;
+    patchable = true;
+
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    std::cerr << "[watch] " << path << ": " << (full ? "built " : "rebuilt ") << changed.size() << " of "
+              << functions.size() << " functions in " << ms << " ms\n";
+    return true;
+  } catch (const std::runtime_error &e) {
+    diag->printAll();
+    std::cerr << "Build failed: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+void WatchSession::runMain() {
+  auto mainSym = jit->lookup("main");
+  if (!mainSym) {
+    llvm::logAllUnhandledErrors(mainSym.takeError(), llvm::errs(), "[watch] ");
+    return;
+  }
+  auto main = mainSym->getAddress().toPtr<int (*)(int, char **)>();
+  (void) main(argc, argv);
+  // the program writes through the runtime's buffer, not stdio
+  Catime::flushOutput();
+  std::cout.flush();
+  std::fflush(stdout);
+}
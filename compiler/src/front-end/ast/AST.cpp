@@ -1,25 +1,21 @@
 #include "AST.hpp"
-#include "ASTVisitor.hpp"
 #include "Location.hpp"
 #include "Types.hpp"
+
 // ===== Base nodes =====
 
-ASTNode::ASTNode(Location loc) : loc(loc) {}
-ASTNode::~ASTNode() = default;
+ASTNode::ASTNode(NodeKind kind, Location loc) : loc(loc), kind_(kind) {}
 
-Expr::Expr(Location loc) : ASTNode(loc) {
+Expr::Expr(NodeKind kind, Location loc) : ASTNode(kind, loc) {
 }
-Expr::~Expr() = default;
 
-Stmt::Stmt(Location loc) : ASTNode(loc) {
+Stmt::Stmt(NodeKind kind, Location loc) : ASTNode(kind, loc) {
 }
-Stmt::~Stmt() = default;
 
-Lval::Lval(Location loc) : ASTNode(loc) {
+Lval::Lval(NodeKind kind, Location loc) : ASTNode(kind, loc) {
 }
-Lval::~Lval() = default;
 
-Rval::Rval(Location loc) : Expr(loc) {
+Rval::Rval(NodeKind kind, Location loc) : Expr(kind, loc) {
 }
 
 // ===== Helpers on Expr/Lval =====
@@ -29,7 +25,7 @@ SemaTypePtr Expr::type() const {
 }
 
 void Expr::setType(SemaTypePtr type) {
-  resolvedType_ = std::move(type);
+  resolvedType_ = type;
 }
 
 bool Expr::isLValue() const {
@@ -60,7 +56,7 @@ SemaTypePtr Lval::type() const {
 }
 
 void Lval::setType(SemaTypePtr type) {
-  resolvedType_ = std::move(type);
+  resolvedType_ = type;
 }
 
 bool Lval::isAssignable() const {
@@ -74,11 +70,11 @@ void Lval::setAssignable(bool v) {
 // ===== Types =====
 
 Type::Type(Location l, DataType::DataType b, vec<std::optional<int>> d)
-    : ASTNode(l), base(b), dims(std::move(d)) {
+    : Type(NodeKind::Type, l, b, std::move(d)) {
 }
 
-void Type::accept(AstVisitor &v) {
-  v.visit(*this);
+Type::Type(NodeKind kind, Location l, DataType::DataType b, vec<std::optional<int>> d)
+    : ASTNode(kind, l), base(b), dims(std::move(d)) {
 }
 
 DataType::DataType Type::data_type() const {
@@ -89,24 +85,20 @@ const vec<std::optional<int>> &Type::dimensions() const {
   return dims;
 }
 
-void Type::setTypeName(const string &name) {
+void Type::setTypeName(Ident name) {
   type_name = name;
 }
 
-const optional<string> &Type::getName() const {
+Ident Type::typeName() const {
   return type_name;
 }
 
 FuncParameterType::FuncParameterType(Location l, bool ref, DataType::DataType type)
-    : Type(l, type), by_ref(ref) {
+    : Type(NodeKind::FuncParameterType, l, type), by_ref(ref) {
 }
 
 FuncParameterType::FuncParameterType(Location l, bool ref, DataType::DataType type, vec<std::optional<int>> d)
-    : Type(l, type, std::move(d)), by_ref(ref) {
-}
-
-void FuncParameterType::accept(AstVisitor &v) {
-  v.visit(*this);
+    : Type(NodeKind::FuncParameterType, l, type, std::move(d)), by_ref(ref) {
 }
 
 bool FuncParameterType::isByRef() const {
@@ -115,56 +107,40 @@ bool FuncParameterType::isByRef() const {
 
 // ===== Blocks =====
 
-Block::Block(Location l, vec<uptr<Stmt>> stmts)
-    : ASTNode(l), statements(std::move(stmts)) {
-}
-
-void Block::accept(AstVisitor &v) {
-  v.visit(*this);
+Block::Block(Location l, ASTList<Stmt> stmts)
+    : ASTNode(NodeKind::Block, l), statements(std::move(stmts)) {
 }
 
 // ===== Definitions =====
 
-Decl::Decl(Location l) : ASTNode(l) {
-}
-
-Program::Program(Location l, vec<uptr<ASTNode>> ds)
-    : ASTNode(l), defs(std::move(ds)) {
-}
-
-void Program::accept(AstVisitor &v) {
-  v.visit(*this);
+Decl::Decl(NodeKind kind, Location l) : ASTNode(kind, l) {
 }
 
-FuncParameterDecl::FuncParameterDecl(Location l, vec<string> names, uptr<FuncParameterType> t)
-    : Decl(l), identifiers(std::move(names)), type(std::move(t)) {
+Program::Program(Location l, ASTList<ASTNode> ds)
+    : ASTNode(NodeKind::Program, l), defs(std::move(ds)) {
 }
 
-void FuncParameterDecl::accept(AstVisitor &v) {
-  v.visit(*this);
+FuncParameterDecl::FuncParameterDecl(Location l, vec<Ident> names, FuncParameterType *t)
+    : Decl(NodeKind::FuncParameterDecl, l), identifiers(std::move(names)), type(std::move(t)) {
 }
 
-const vec<string> &FuncParameterDecl::names() const {
+const vec<Ident> &FuncParameterDecl::names() const {
   return identifiers;
 }
 
 const FuncParameterType *FuncParameterDecl::parameterType() const {
-  return type.get();
+  return type;
 }
 
-Header::Header(Location l, string n, optional<DataType::DataType> r, vec<uptr<FuncParameterDecl>> p)
-    : Decl(l), name(std::move(n)), return_type(std::move(r)), params(std::move(p)) {
-}
-
-void Header::accept(AstVisitor &v) {
-  v.visit(*this);
+Header::Header(Location l, Ident n, optional<DataType::DataType> r, ASTList<FuncParameterDecl> p)
+    : Decl(NodeKind::Header, l), name(std::move(n)), return_type(std::move(r)), params(std::move(p)) {
 }
 
 const string &Header::identifier() const {
-  return name;
+  return spelling(name);
 }
 
-const vec<uptr<FuncParameterDecl>> &Header::parameters() const {
+ASTList<FuncParameterDecl> Header::parameters() const {
   return params;
 }
 
@@ -172,28 +148,16 @@ optional<DataType::DataType> Header::returnType() const {
   return return_type;
 }
 
-VarDef::VarDef(Location l, vec<string> ids, uptr<Type> t, optional<uptr<Expr>> init)
-    : Stmt(l), names(std::move(ids)), declared_type(std::move(t)), init_expr_(std::move(init)) {
+VarDef::VarDef(Location l, vec<Ident> ids, Type *t, Expr *init)
+    : Stmt(NodeKind::VarDef, l), names(std::move(ids)), declared_type(std::move(t)), init_expr_(std::move(init)) {
 }
 
-void VarDef::accept(AstVisitor &v) {
-  v.visit(*this);
+FuncDecl::FuncDecl(Location l, Header *h)
+    : Decl(NodeKind::FuncDecl, l), header(std::move(h)) {
 }
 
-FuncDecl::FuncDecl(Location l, uptr<Header> h)
-    : Decl(l), header(std::move(h)) {
-}
-
-void FuncDecl::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-FuncDef::FuncDef(Location l, uptr<Header> h, uptr<Block> b)
-    : Stmt(l), header(std::move(h)), body(std::move(b)) {
-}
-
-void FuncDef::accept(AstVisitor &v) {
-  v.visit(*this);
+FuncDef::FuncDef(Location l, Header *h, Block *b)
+    : Stmt(NodeKind::FuncDef, l), header(std::move(h)), body(std::move(b)) {
 }
 
 bool FuncDef::isEntrypoint() {
@@ -212,186 +176,81 @@ void FuncDef::setEntrypoint(bool cond) {
   isEntrypoint_ = cond;
 }
 
-ClassDecl::ClassDecl(Location l, string n, vec<uptr<VarDef>> f, vec<uptr<FuncDef>> m)
-    : Decl(l), name(std::move(n)), fields(std::move(f)), methods(std::move(m)) {
-}
-void ClassDecl::accept(AstVisitor &v) {
-  v.visit(*this);
+ClassDecl::ClassDecl(Location l, Ident n, ASTList<VarDef> f, ASTList<FuncDef> m)
+    : Decl(NodeKind::ClassDecl, l), name(std::move(n)), fields(std::move(f)), methods(std::move(m)) {
 }
 
-
 // ===== Statements =====
 
-SkipStmt::SkipStmt(Location l) : Stmt(l) {
-}
-void SkipStmt::accept(AstVisitor &v) {
-  v.visit(*this);
+SkipStmt::SkipStmt(Location l) : Stmt(NodeKind::SkipStmt, l) {
 }
-
-ExitStmt::ExitStmt(Location l) : Stmt(l) {
+ExitStmt::ExitStmt(Location l) : Stmt(NodeKind::ExitStmt, l) {
 }
-void ExitStmt::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-AssignStmt::AssignStmt(Location l, uptr<Lval> left, uptr<Expr> right)
-    : Stmt(l), lhs(std::move(left)), rhs(std::move(right)) {
+AssignStmt::AssignStmt(Location l, Lval *left, Expr *right)
+    : Stmt(NodeKind::AssignStmt, l), lhs(std::move(left)), rhs(std::move(right)) {
 }
-void AssignStmt::accept(AstVisitor &v) {
-  v.visit(*this);
+ReturnStmt::ReturnStmt(Location l, Expr *expr)
+    : Stmt(NodeKind::ReturnStmt, l), value(std::move(expr)) {
 }
-
-ReturnStmt::ReturnStmt(Location l, uptr<Expr> expr)
-    : Stmt(l), value(std::move(expr)) {
-}
-void ReturnStmt::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
 // ProcCall
-ProcCall::ProcCall(Location l, string id, vec<uptr<Expr>> a) : Stmt(l), name(std::move(id)), args(std::move(a)) {}
-
-void ProcCall::accept(AstVisitor &v) {
-  v.visit(*this);
-}
+ProcCall::ProcCall(Location l, Ident id, ASTList<Expr> a) : Stmt(NodeKind::ProcCall, l), name(std::move(id)), args(std::move(a)) {}
 
 BreakStmt::BreakStmt(Location l, optional<string> lbl)
-    : Stmt(l), label(std::move(lbl)) {
-}
-void BreakStmt::accept(AstVisitor &v) {
-  v.visit(*this);
+    : Stmt(NodeKind::BreakStmt, l), label(std::move(lbl)) {
 }
-
 ContinueStmt::ContinueStmt(Location l, optional<string> lbl)
-    : Stmt(l), label(std::move(lbl)) {
-}
-void ContinueStmt::accept(AstVisitor &v) {
-  v.visit(*this);
+    : Stmt(NodeKind::ContinueStmt, l), label(std::move(lbl)) {
 }
-
-IfStmt::IfStmt(Location l, uptr<Cond> cond, uptr<Block> then_block, vec<std::pair<uptr<Cond>, uptr<Block>>> elifs, std::optional<uptr<Block>> else_block)
-    : Stmt(l),
+IfStmt::IfStmt(Location l, Cond *cond, Block *then_block, llvm::ArrayRef<std::pair<Cond *, Block *>> elifs, Block *else_block)
+    : Stmt(NodeKind::IfStmt, l),
       condition(std::move(cond)),
       then_branch(std::move(then_block)),
       elif_branches(std::move(elifs)),
       else_branch(std::move(else_block)) {
 }
-void IfStmt::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-LoopStmt::LoopStmt(Location l, uptr<Cond> cond, uptr<Block> blk)
-    : Stmt(l), condition(std::move(cond)), body(std::move(blk)) {
-}
-void LoopStmt::accept(AstVisitor &v) {
-  v.visit(*this);
+LoopStmt::LoopStmt(Location l, Cond *cond, Block *blk)
+    : Stmt(NodeKind::LoopStmt, l), condition(std::move(cond)), body(std::move(blk)) {
 }
 
 // ===== L-values =====
 
-IdLVal::IdLVal(Location l, string id)
-    : Lval(l), name(std::move(id)) {}
-void IdLVal::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
+IdLVal::IdLVal(Location l, Ident id)
+    : Lval(NodeKind::IdLVal, l), name(std::move(id)) {}
 StringLiteralLVal::StringLiteralLVal(Location l, string v)
-    : Lval(l), value(std::move(v)) {}
-void StringLiteralLVal::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-IndexLVal::IndexLVal(Location l, uptr<Lval> b, uptr<Expr> idx)
-    : Lval(l), base(std::move(b)), index(std::move(idx)) {}
-void IndexLVal::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-MemberAccessLVal::MemberAccessLVal(Location l, uptr<Expr> obj, string member)
-    : Lval(l), object_(std::move(obj)), member_(member) {}
-void MemberAccessLVal::accept(AstVisitor &v) {
-  v.visit(*this);
-}
+    : Lval(NodeKind::StringLiteralLVal, l), value(std::move(v)) {}
+IndexLVal::IndexLVal(Location l, Lval *b, Expr *idx)
+    : Lval(NodeKind::IndexLVal, l), base(std::move(b)), index(std::move(idx)) {}
+MemberAccessLVal::MemberAccessLVal(Location l, Expr *obj, Ident member)
+    : Lval(NodeKind::MemberAccessLVal, l), object_(std::move(obj)), member_(member) {}
 
 // ===== R-values / expressions =====
 
 IntConst::IntConst(Location l, int v)
-    : Rval(l), value(v) {}
-void IntConst::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
+    : Rval(NodeKind::IntConst, l), value(v) {}
 CharConst::CharConst(Location l, unsigned char v)
-    : Rval(l), value(v) {}
-void CharConst::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
+    : Rval(NodeKind::CharConst, l), value(v) {}
 TrueConst::TrueConst(Location l)
-    : Rval(l) {}
-void TrueConst::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
+    : Rval(NodeKind::TrueConst, l) {}
 FalseConst::FalseConst(Location l)
-    : Rval(l) {}
-void FalseConst::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-LValueExpr::LValueExpr(Location l, uptr<Lval> val)
-    : Expr(l), value(std::move(val)) {}
-void LValueExpr::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-ParenExpr::ParenExpr(Location l, uptr<Expr> expr)
-    : Expr(l), inner(std::move(expr)) {}
-void ParenExpr::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-FuncCall::FuncCall(Location l, string id, vec<uptr<Expr>> a)
-    : Expr(l), name(std::move(id)), args(std::move(a)) {}
-void FuncCall::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-MemberAccessExpr::MemberAccessExpr(Location l, uptr<Expr> obj, string member)
-    : Expr(l), object_(std::move(obj)), member_(member) {}
-void MemberAccessExpr::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-MethodCall::MethodCall(Location l, uptr<Expr> obj, string method, vec<uptr<Expr>> args)
-    : Expr(l), object_(std::move(obj)), method_(method), args(std::move(args)) {}
-void MethodCall::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-NewExpr::NewExpr(Location l, string clsName, vec<uptr<Expr>> args)
-    : Expr(l), clsName(std::move(clsName)), args(std::move(args)) {}
-void NewExpr::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-UnaryExpr::UnaryExpr(Location l, UnOp operation, uptr<Expr> expr)
-    : Expr(l), op(operation), operand(std::move(expr)) {}
-void UnaryExpr::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-BinaryExpr::BinaryExpr(Location l, BinOp operation, uptr<Expr> left, uptr<Expr> right)
-    : Expr(l), op(operation), lhs(std::move(left)), rhs(std::move(right)) {}
-void BinaryExpr::accept(AstVisitor &v) {
-  v.visit(*this);
-}
-
-
-ArrayExpr::ArrayExpr(Location loc, vec<uptr<Expr>> elems) : Expr(loc), elements(std::move(elems)) {}
-void ArrayExpr::accept(AstVisitor &v) {
-  v.visit(*this);
-}
+    : Rval(NodeKind::FalseConst, l) {}
+LValueExpr::LValueExpr(Location l, Lval *val)
+    : Expr(NodeKind::LValueExpr, l), value(std::move(val)) {}
+ParenExpr::ParenExpr(Location l, Expr *expr)
+    : Expr(NodeKind::ParenExpr, l), inner(std::move(expr)) {}
+FuncCall::FuncCall(Location l, Ident id, ASTList<Expr> a)
+    : Expr(NodeKind::FuncCall, l), name(std::move(id)), args(std::move(a)) {}
+MemberAccessExpr::MemberAccessExpr(Location l, Expr *obj, Ident member)
+    : Expr(NodeKind::MemberAccessExpr, l), object_(std::move(obj)), member_(member) {}
+MethodCall::MethodCall(Location l, Expr *obj, Ident method, ASTList<Expr> args)
+    : Expr(NodeKind::MethodCall, l), object_(std::move(obj)), method_(method), args(std::move(args)) {}
+NewExpr::NewExpr(Location l, Ident clsName, ASTList<Expr> args)
+    : Expr(NodeKind::NewExpr, l), clsName(std::move(clsName)), args(std::move(args)) {}
+UnaryExpr::UnaryExpr(Location l, UnOp operation, Expr *expr)
+    : Expr(NodeKind::UnaryExpr, l), op(operation), operand(std::move(expr)) {}
+BinaryExpr::BinaryExpr(Location l, BinOp operation, Expr *left, Expr *right)
+    : Expr(NodeKind::BinaryExpr, l), op(operation), lhs(std::move(left)), rhs(std::move(right)) {}
+
+ArrayExpr::ArrayExpr(Location loc, ASTList<Expr> elems) : Expr(NodeKind::ArrayExpr, loc), elements(std::move(elems)) {}
 
 // SelfExpr::SelfExpr(Location loc) : Expr(loc) {}
 // void SelfExpr::accept(AstVisitor &v) {
@@ -402,16 +261,14 @@ void ArrayExpr::accept(AstVisitor &v) {
 // void SuperExpr::accept(AstVisitor &v) {
 //     v.visit(*this);
 // }
+
 // ===== Conditions =====
 
-Cond::Cond(Location l)
-    : Expr(l) {}
+Cond::Cond(NodeKind kind, Location l)
+    : Expr(kind, l) {}
 
-ExprCond::ExprCond(Location l, uptr<Expr> e)
-    : Cond(l), expr(std::move(e)) {}
-void ExprCond::accept(AstVisitor &v) {
-  v.visit(*this);
-}
+ExprCond::ExprCond(Location l, Expr *e)
+    : Cond(NodeKind::ExprCond, l), expr(std::move(e)) {}
 
 // ParenCond::ParenCond(Location l, uptr<Cond> c)
 //     : Cond(l), condition(std::move(c)) {}
@@ -0,0 +1,16 @@
+#include "ASTContext.hpp"
+#include "AST.hpp"
+
+ASTContext::~ASTContext() {
+  // nodes still own strings and symbol vectors; the memory itself goes
+  // away with the allocator
+  for (auto it = needsDestroy.rbegin(); it != needsDestroy.rend(); ++it) {
+    switch ((*it)->getKind()) {
+#define AST_NODE(Class)                  \
+  case NodeKind::Class:                  \
+    static_cast<Class *>(*it)->~Class(); \
+    break;
+#include "ASTNodes.def"
+    }
+  }
+}
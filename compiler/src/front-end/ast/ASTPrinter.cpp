@@ -1,5 +1,6 @@
 #include "AST.hpp"
 #include "Location.hpp"
+#include "SourceManager.hpp"
 #include <cstddef>
 #include <cstdio>
 #include <iostream>
@@ -67,16 +68,16 @@ namespace tree {
 
   // Child helpers
   template<class T>
-  inline void child(std::ostream &out, const uptr<T> &ptr, bool is_last) {
+  inline void child(std::ostream &out, const T *ptr, bool is_last) {
     last.push_back(is_last);
-    if (ptr) ptr->print(out);
+    if (ptr) static_cast<const ASTNode *>(ptr)->print(out);
     else
       line(out, "null");
     last.pop_back();
   }
 
   template<class T>
-  inline void children(std::ostream &out, const vec<uptr<T>> &xs) {
+  inline void children(std::ostream &out, ASTList<T> xs) {
     for (std::size_t i = 0; i < xs.size(); ++i) {
       child(out, xs[i], i + 1 == xs.size());
     }
@@ -85,15 +86,16 @@ namespace tree {
   // Small format helpers
   inline std::string tag(const char *name, const Location &loc) {
     std::ostringstream oss;
-    oss << name << '[' << loc.line << ':' << loc.column << ']';
+    auto lc = SrcMgr::getInstance()->resolve(loc);
+    oss << name << '[' << lc.line << ':' << lc.column << ']';
     return oss.str();
   }
 
-  inline std::string join(const vec<string> &xs, const char *sep = ", ") {
+  inline std::string join(const vec<Ident> &xs, const char *sep = ", ") {
     std::string r;
     for (std::size_t i = 0; i < xs.size(); ++i) {
       if (i) r += sep;
-      r += xs[i];
+      r += spelling(xs[i]);
     }
     return r;
   }
@@ -114,6 +116,15 @@ namespace tree {
 
 // ---- Printing implementations ----
 
+void ASTNode::print(std::ostream &out) const {
+  switch (getKind()) {
+#define AST_NODE(Class) \
+  case NodeKind::Class: \
+    return static_cast<const Class *>(this)->print(out);
+#include "ASTNodes.def"
+  }
+}
+
 void Type::print(std::ostream &out) const {
   tree::line(out, tree::tag("Type", loc) + " base=" + DataType::toString(base) + " dims=" + tree::dims_str(dims));
 }
@@ -136,10 +147,6 @@ void Block::print(std::ostream &out) const {
   tree::children(out, statements);
 }
 
-void Decl::print(std::ostream &out) const {
-  (void) out;// Base never printed directly; derived classes override
-}
-
 void Program::print(std::ostream &out) const {
   tree::line(out, tree::tag("Program", loc));
   // if (top) tree::child(out, top, true);
@@ -158,7 +165,7 @@ void FuncParameterDecl::print(std::ostream &out) const {
 }
 
 void Header::print(std::ostream &out) const {
-  tree::line(out, tree::tag("Header", loc) + " name=" + name + " return=" + (return_type ? DataType::toString(*return_type) : std::string("null")));
+  tree::line(out, tree::tag("Header", loc) + " name=" + spelling(name) + " return=" + (return_type ? DataType::toString(*return_type) : std::string("null")));
   tree::children(out, params);
 }
 
@@ -181,7 +188,7 @@ void FuncDef::print(std::ostream &out) const {
 }
 
 void ClassDecl::print(std::ostream &out) const {
-  tree::line(out, tree::tag("ClassDef", loc) + " name=" + name);
+  tree::line(out, tree::tag("ClassDef", loc) + " name=" + spelling(name));
 
   int n = static_cast<int>(fields.size()) + static_cast<int>(methods.size());
   int k = 0;
@@ -210,7 +217,7 @@ void ReturnStmt::print(std::ostream &out) const {
 }
 
 void ProcCall::print(std::ostream &out) const {
-  tree::line(out, tree::tag("ProcCall", loc) + " name=" + name);
+  tree::line(out, tree::tag("ProcCall", loc) + " name=" + spelling(name));
   tree::children(out, args);
 }
 
@@ -224,7 +231,7 @@ void ContinueStmt::print(std::ostream &out) const {
 
 void IfStmt::print(std::ostream &out) const {
   tree::line(out, tree::tag("IfStmt", loc));
-  int n = (condition ? 1 : 0) + (then_branch ? 1 : 0) + static_cast<int>(elif_branches.size()) + ((else_branch && *else_branch) ? 1 : 0);
+  int n = (condition ? 1 : 0) + (then_branch ? 1 : 0) + static_cast<int>(elif_branches.size()) + (else_branch ? 1 : 0);
   int k = 0;
   if (condition) tree::child(out, condition, ++k == n);
   if (then_branch) tree::child(out, then_branch, ++k == n);
@@ -245,12 +252,12 @@ void IfStmt::print(std::ostream &out) const {
     tree::last.pop_back();
     tree::last.pop_back();
   }
-  if (else_branch && *else_branch) {
+  if (else_branch) {
     bool last_else = (++k == n);
     tree::last.push_back(last_else);
     tree::line(out, "Else");
     tree::last.push_back(true);
-    (**else_branch).print(out);
+    else_branch->print(out);
     tree::last.pop_back();
     tree::last.pop_back();
   }
@@ -263,7 +270,7 @@ void LoopStmt::print(std::ostream &out) const {
 }
 
 void IdLVal::print(std::ostream &out) const {
-  tree::line(out, tree::tag("IdLVal", loc) + " name=" + name);
+  tree::line(out, tree::tag("IdLVal", loc) + " name=" + spelling(name));
 }
 
 void StringLiteralLVal::print(std::ostream &out) const {
@@ -278,7 +285,7 @@ void IndexLVal::print(std::ostream &out) const {
 }
 
 void MemberAccessLVal::print(std::ostream &out) const {
-  tree::line(out, tree::tag("MemberAccessLVal", loc) + " member=" + member_);
+  tree::line(out, tree::tag("MemberAccessLVal", loc) + " member=" + spelling(member_));
   if (object_) tree::child(out, object_, true);
 }
 
@@ -305,22 +312,22 @@ void ParenExpr::print(std::ostream &out) const {
 }
 
 void MemberAccessExpr::print(std::ostream &out) const {
-  tree::line(out, tree::tag("MemberAccessExpr", loc) + " member=" + member_);
+  tree::line(out, tree::tag("MemberAccessExpr", loc) + " member=" + spelling(member_));
   if (object_) tree::child(out, object_, true);
 }
 
 void MethodCall::print(std::ostream &out) const {
-  tree::line(out, tree::tag("MethodCall", loc) + " method=" + method_);
+  tree::line(out, tree::tag("MethodCall", loc) + " method=" + spelling(method_));
   if (object_) tree::child(out, object_, true);
   tree::children(out, args);
 }
 
 void NewExpr::print(std::ostream &out) const {
-  tree::line(out, tree::tag("NewExpr", loc) + " constructor=" + clsName);
+  tree::line(out, tree::tag("NewExpr", loc) + " constructor=" + spelling(clsName));
 }
 
 void FuncCall::print(std::ostream &out) const {
-  tree::line(out, tree::tag("FuncCall", loc) + " name=" + name);
+  tree::line(out, tree::tag("FuncCall", loc) + " name=" + spelling(name));
   tree::children(out, args);
 }
 
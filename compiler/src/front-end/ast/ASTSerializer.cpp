@@ -0,0 +1,622 @@
+#include "ASTSerializer.h"
+#include "ASTWalker.hpp"
+#include "Interner.hpp"
+#include <cstring>
+#include <llvm-20/llvm/ADT/SmallVector.h>
+#include <llvm-20/llvm/ADT/StringMap.h>
+#include <llvm-20/llvm/Support/xxhash.h>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+  constexpr char magic[4] = {'C', 'A', 'S', 'T'};
+
+  class Writer : public AstWalker<Writer> {
+public:
+    std::vector<uint32_t> words;
+    std::vector<std::string_view> strings;
+
+    void node(const ASTNode *node) {
+      if (!node) {
+        words.push_back(ASTSerializer::nullNode);
+        return;
+      }
+      walk(const_cast<ASTNode *>(node));
+    }
+    template<typename T>
+    void list(llvm::ArrayRef<T *> nodes) {
+      words.push_back(nodes.size());
+      for (const T *child: nodes) {
+        node(child);
+      }
+    }
+    void str(std::string_view text) {
+      auto [it, inserted] = stringIndex.try_emplace(text, strings.size());
+      if (inserted) {
+        strings.push_back(it->first());
+      }
+      words.push_back(it->second);
+    }
+    void ident(Ident id) { str(spelling(id)); }
+    void begin(const ASTNode &node, uint32_t payload = 0) {
+      words.push_back(static_cast<uint32_t>(node.getKind()) | payload << 8);
+      words.push_back(node.loc.offset);
+    }
+
+    void visit(Program &node) {
+      begin(node);
+      list(node.getDefs());
+    }
+    void visit(Block &node) {
+      begin(node);
+      list(node.statementsList());
+    }
+    void visit(Header &node) {
+      auto returnType = node.returnType();
+      begin(node, returnType.has_value());
+      ident(node.ident());
+      if (returnType) {
+        words.push_back(static_cast<uint32_t>(*returnType));
+      }
+      list(node.parameters());
+    }
+    void visit(FuncParameterDecl &node) {
+      begin(node);
+      words.push_back(node.names().size());
+      for (Ident name: node.names()) {
+        ident(name);
+      }
+      this->node(node.parameterType());
+    }
+    void visit(FuncDecl &node) {
+      begin(node);
+      this->node(node.funcHeader());
+    }
+    void visit(ClassDecl &node) {
+      begin(node);
+      ident(node.ident());
+      list(node.fieldList());
+      list(node.methodList());
+    }
+    void type(const Type &node, uint32_t payload) {
+      begin(node, payload);
+      words.push_back(static_cast<uint32_t>(node.data_type()));
+      ident(node.typeName());
+      words.push_back(node.dimensions().size());
+      for (const auto &dim: node.dimensions()) {
+        words.push_back(dim.has_value());
+        words.push_back(static_cast<uint32_t>(dim.value_or(0)));
+      }
+    }
+    void visit(Type &node) { type(node, 0); }
+    void visit(FuncParameterType &node) { type(node, node.isByRef()); }
+    void visit(VarDef &node) {
+      begin(node);
+      words.push_back(node.identifiers().size());
+      for (Ident name: node.identifiers()) {
+        ident(name);
+      }
+      this->node(node.declaredType());
+      this->node(node.initExpr());
+    }
+    void visit(FuncDef &node) {
+      begin(node);
+      this->node(node.funcHeader());
+      this->node(node.funcBody());
+    }
+    void visit(SkipStmt &node) { begin(node); }
+    void visit(ExitStmt &node) { begin(node); }
+    void visit(AssignStmt &node) {
+      begin(node);
+      this->node(node.left());
+      this->node(node.right());
+    }
+    void visit(ReturnStmt &node) {
+      begin(node);
+      this->node(node.returnValue());
+    }
+    void visit(ProcCall &node) {
+      begin(node);
+      ident(node.ident());
+      list(node.arguments());
+    }
+    void label(const ASTNode &node, const std::optional<string> &label) {
+      begin(node, label.has_value());
+      if (label) {
+        str(*label);
+      }
+    }
+    void visit(BreakStmt &node) { label(node, node.loopLabel()); }
+    void visit(ContinueStmt &node) { label(node, node.loopLabel()); }
+    void visit(IfStmt &node) {
+      begin(node);
+      this->node(node.conditionExpr());
+      this->node(node.thenBlock());
+      words.push_back(node.elifs().size());
+      for (const auto &[cond, block]: node.elifs()) {
+        this->node(cond);
+        this->node(block);
+      }
+      this->node(node.elseBlock());
+    }
+    void visit(LoopStmt &node) {
+      begin(node);
+      this->node(node.conditionExpr());
+      this->node(node.loopBody());
+    }
+    void visit(IdLVal &node) {
+      begin(node);
+      ident(node.ident());
+    }
+    void visit(StringLiteralLVal &node) {
+      begin(node);
+      str(node.literal());
+    }
+    void visit(IndexLVal &node) {
+      begin(node);
+      this->node(node.baseExpr());
+      this->node(node.indexExpr());
+    }
+    void visit(MemberAccessLVal &node) {
+      begin(node);
+      this->node(node.object());
+      ident(node.memberIdent());
+    }
+    void visit(LValueExpr &node) {
+      begin(node);
+      this->node(node.lvalue());
+    }
+    void visit(ParenExpr &node) {
+      begin(node);
+      this->node(node.innerExpr());
+    }
+    void visit(FuncCall &node) {
+      begin(node);
+      ident(node.ident());
+      list(node.arguments());
+    }
+    void visit(MemberAccessExpr &node) {
+      begin(node);
+      this->node(node.object());
+      ident(node.memberIdent());
+    }
+    void visit(MethodCall &node) {
+      begin(node);
+      this->node(node.object());
+      ident(node.methodIdent());
+      list(node.arguments());
+    }
+    void visit(NewExpr &node) {
+      begin(node);
+      ident(node.classIdent());
+      list(node.getArgs());
+    }
+    void visit(UnaryExpr &node) {
+      begin(node, static_cast<uint32_t>(node.opKind()));
+      this->node(node.operandExpr());
+    }
+    void visit(BinaryExpr &node) {
+      begin(node, static_cast<uint32_t>(node.opKind()));
+      this->node(node.leftExpr());
+      this->node(node.rightExpr());
+    }
+    void visit(ArrayExpr &node) {
+      begin(node);
+      list(node.getElements());
+    }
+    void visit(IntConst &node) {
+      begin(node);
+      words.push_back(static_cast<uint32_t>(node.getValue()));
+    }
+    void visit(CharConst &node) { begin(node, node.getValue()); }
+    void visit(TrueConst &node) { begin(node); }
+    void visit(FalseConst &node) { begin(node); }
+    void visit(ExprCond &node) {
+      begin(node);
+      this->node(node.expression());
+    }
+
+private:
+    llvm::StringMap<uint32_t> stringIndex;
+  };
+
+  // Rebuilds nodes from the word stream. Every read is bounds checked and
+  // every child is checked to be of the class its parent expects; anything
+  // off marks the file as bad and the caller parses the source instead.
+  class Reader {
+public:
+    Reader(llvm::ArrayRef<uint32_t> words, std::vector<std::string_view> strings, std::size_t sourceBytes, uint32_t fileId, ASTContext &ctx)
+        : words(words), strings(std::move(strings)), idents(this->strings.size()), sourceBytes(sourceBytes), fileId(fileId), ctx(ctx) {}
+
+    bool bad = false;
+
+    bool atEnd() const { return pos == words.size(); }
+
+    template<typename T>
+    T *child() {
+      ASTNode *node = this->node();
+      if (!node || !llvm::isa<T>(node)) {
+        bad = true;
+        return nullptr;
+      }
+      return llvm::cast<T>(node);
+    }
+    template<typename T>
+    T *optionalChild() {
+      if (!bad && pos < words.size() && words[pos] == ASTSerializer::nullNode) {
+        ++pos;
+        return nullptr;
+      }
+      return child<T>();
+    }
+
+private:
+    uint32_t word() {
+      if (pos >= words.size()) {
+        bad = true;
+        return 0;
+      }
+      return words[pos++];
+    }
+    // a count of things that take at least one word each
+    uint32_t count() {
+      uint32_t n = word();
+      if (n > words.size() - pos) {
+        bad = true;
+        return 0;
+      }
+      return n;
+    }
+    std::string_view str() {
+      uint32_t index = word();
+      if (index >= strings.size()) {
+        bad = true;
+        return {};
+      }
+      return strings[index];
+    }
+    Ident ident() {
+      uint32_t index = word();
+      if (index >= strings.size()) {
+        bad = true;
+        return Ident{};
+      }
+      if (!idents[index]) {
+        idents[index] = intern(strings[index]);
+      }
+      return *idents[index];
+    }
+    template<typename T>
+    ASTList<T> list() {
+      llvm::SmallVector<T *, 8> items;
+      for (uint32_t n = count(); n > 0 && !bad; --n) {
+        items.push_back(child<T>());
+      }
+      return ctx.list<T *>(items);
+    }
+    vec<Ident> names() {
+      vec<Ident> result;
+      for (uint32_t n = count(); n > 0 && !bad; --n) {
+        result.push_back(ident());
+      }
+      return result;
+    }
+    template<typename E>
+    std::optional<E> enumValue(uint32_t value, E last) {
+      if (value > static_cast<uint32_t>(last)) {
+        bad = true;
+        return std::nullopt;
+      }
+      return static_cast<E>(value);
+    }
+    Type *type(NodeKind kind, Location loc, uint32_t payload) {
+      auto base = enumValue(word(), DataType::DataType::UNKOWN);
+      Ident typeName = ident();
+      vec<std::optional<int>> dims;
+      for (uint32_t n = count(); n > 0 && !bad; --n) {
+        bool known = word();
+        int size = static_cast<int>(word());
+        dims.push_back(known ? std::optional<int>(size) : std::nullopt);
+      }
+      if (bad || !base) {
+        bad = true;
+        return nullptr;
+      }
+      Type *type = kind == NodeKind::Type ? ctx.create<Type>(loc, *base, std::move(dims))
+                                          : ctx.create<FuncParameterType>(loc, payload != 0, *base, std::move(dims));
+      type->setTypeName(typeName);
+      return type;
+    }
+
+    ASTNode *node();
+
+    llvm::ArrayRef<uint32_t> words;
+    std::size_t pos = 0;
+    std::vector<std::string_view> strings;
+    std::vector<std::optional<Ident>> idents;// interned on first use
+    std::size_t sourceBytes;
+    uint32_t fileId;
+    ASTContext &ctx;
+  };
+
+  ASTNode *Reader::node() {
+    const uint32_t head = word();
+    const uint32_t offset = word();
+    if (bad || head == ASTSerializer::nullNode || offset > sourceBytes) {
+      bad = true;
+      return nullptr;
+    }
+    const uint32_t payload = head >> 8;
+    const Location loc{offset, fileId};
+    ASTNode *result = nullptr;
+    switch (static_cast<NodeKind>(head & 0xFF)) {
+      case NodeKind::Program:
+        result = ctx.create<Program>(loc, list<ASTNode>());
+        break;
+      case NodeKind::Block:
+        result = ctx.create<Block>(loc, list<Stmt>());
+        break;
+      case NodeKind::Header: {
+        Ident name = ident();
+        std::optional<DataType::DataType> returnType;
+        if (payload) {
+          returnType = enumValue(word(), DataType::DataType::UNKOWN);
+          bad |= !returnType;
+        }
+        auto params = list<FuncParameterDecl>();
+        result = ctx.create<Header>(loc, name, returnType, params);
+        break;
+      }
+      case NodeKind::FuncParameterDecl: {
+        auto ids = names();
+        auto *type = child<FuncParameterType>();
+        result = ctx.create<FuncParameterDecl>(loc, std::move(ids), type);
+        break;
+      }
+      case NodeKind::FuncDecl:
+        result = ctx.create<FuncDecl>(loc, child<Header>());
+        break;
+      case NodeKind::ClassDecl: {
+        Ident name = ident();
+        auto fields = list<VarDef>();
+        auto methods = list<FuncDef>();
+        result = ctx.create<ClassDecl>(loc, name, fields, methods);
+        break;
+      }
+      case NodeKind::Type:
+      case NodeKind::FuncParameterType:
+        result = type(static_cast<NodeKind>(head & 0xFF), loc, payload);
+        break;
+      case NodeKind::VarDef: {
+        auto ids = names();
+        auto *type = child<Type>();
+        auto *init = optionalChild<Expr>();
+        result = ctx.create<VarDef>(loc, std::move(ids), type, init);
+        break;
+      }
+      case NodeKind::FuncDef: {
+        auto *header = child<Header>();
+        auto *body = child<Block>();
+        result = ctx.create<FuncDef>(loc, header, body);
+        break;
+      }
+      case NodeKind::SkipStmt:
+        result = ctx.create<SkipStmt>(loc);
+        break;
+      case NodeKind::ExitStmt:
+        result = ctx.create<ExitStmt>(loc);
+        break;
+      case NodeKind::AssignStmt: {
+        auto *lhs = child<Lval>();
+        auto *rhs = child<Expr>();
+        result = ctx.create<AssignStmt>(loc, lhs, rhs);
+        break;
+      }
+      case NodeKind::ReturnStmt:
+        result = ctx.create<ReturnStmt>(loc, optionalChild<Expr>());
+        break;
+      case NodeKind::ProcCall: {
+        Ident name = ident();
+        result = ctx.create<ProcCall>(loc, name, list<Expr>());
+        break;
+      }
+      case NodeKind::BreakStmt:
+      case NodeKind::ContinueStmt: {
+        std::optional<string> label;
+        if (payload) {
+          label = string(str());
+        }
+        if ((head & 0xFF) == static_cast<uint32_t>(NodeKind::BreakStmt)) {
+          result = ctx.create<BreakStmt>(loc, std::move(label));
+        } else {
+          result = ctx.create<ContinueStmt>(loc, std::move(label));
+        }
+        break;
+      }
+      case NodeKind::IfStmt: {
+        auto *cond = child<Cond>();
+        auto *then = child<Block>();
+        llvm::SmallVector<std::pair<Cond *, Block *>, 4> elifs;
+        for (uint32_t n = count(); n > 0 && !bad; --n) {
+          auto *elifCond = child<Cond>();
+          auto *elifBlock = child<Block>();
+          elifs.push_back({elifCond, elifBlock});
+        }
+        auto *otherwise = optionalChild<Block>();
+        result = ctx.create<IfStmt>(loc, cond, then, ctx.list<std::pair<Cond *, Block *>>(elifs), otherwise);
+        break;
+      }
+      case NodeKind::LoopStmt: {
+        auto *cond = child<Cond>();
+        auto *body = child<Block>();
+        result = ctx.create<LoopStmt>(loc, cond, body);
+        break;
+      }
+      case NodeKind::IdLVal:
+        result = ctx.create<IdLVal>(loc, ident());
+        break;
+      case NodeKind::StringLiteralLVal:
+        result = ctx.create<StringLiteralLVal>(loc, string(str()));
+        break;
+      case NodeKind::IndexLVal: {
+        auto *base = child<Lval>();
+        auto *index = child<Expr>();
+        result = ctx.create<IndexLVal>(loc, base, index);
+        break;
+      }
+      case NodeKind::MemberAccessLVal: {
+        auto *object = child<Expr>();
+        result = ctx.create<MemberAccessLVal>(loc, object, ident());
+        break;
+      }
+      case NodeKind::LValueExpr:
+        result = ctx.create<LValueExpr>(loc, child<Lval>());
+        break;
+      case NodeKind::ParenExpr:
+        result = ctx.create<ParenExpr>(loc, child<Expr>());
+        break;
+      case NodeKind::FuncCall: {
+        Ident name = ident();
+        result = ctx.create<FuncCall>(loc, name, list<Expr>());
+        break;
+      }
+      case NodeKind::MemberAccessExpr: {
+        auto *object = child<Expr>();
+        result = ctx.create<MemberAccessExpr>(loc, object, ident());
+        break;
+      }
+      case NodeKind::MethodCall: {
+        auto *object = child<Expr>();
+        Ident method = ident();
+        result = ctx.create<MethodCall>(loc, object, method, list<Expr>());
+        break;
+      }
+      case NodeKind::NewExpr: {
+        Ident cls = ident();
+        result = ctx.create<NewExpr>(loc, cls, list<Expr>());
+        break;
+      }
+      case NodeKind::UnaryExpr: {
+        auto op = enumValue(payload, UnOp::Not);
+        auto *operand = child<Expr>();
+        if (op) {
+          result = ctx.create<UnaryExpr>(loc, *op, operand);
+        }
+        break;
+      }
+      case NodeKind::BinaryExpr: {
+        auto op = enumValue(payload, BinOp::Or);
+        auto *lhs = child<Expr>();
+        auto *rhs = child<Expr>();
+        if (op) {
+          result = ctx.create<BinaryExpr>(loc, *op, lhs, rhs);
+        }
+        break;
+      }
+      case NodeKind::ArrayExpr:
+        result = ctx.create<ArrayExpr>(loc, list<Expr>());
+        break;
+      case NodeKind::IntConst:
+        result = ctx.create<IntConst>(loc, static_cast<int>(word()));
+        break;
+      case NodeKind::CharConst:
+        result = ctx.create<CharConst>(loc, static_cast<unsigned char>(payload));
+        break;
+      case NodeKind::TrueConst:
+        result = ctx.create<TrueConst>(loc);
+        break;
+      case NodeKind::FalseConst:
+        result = ctx.create<FalseConst>(loc);
+        break;
+      case NodeKind::ExprCond:
+        result = ctx.create<ExprCond>(loc, child<Expr>());
+        break;
+      default:
+        bad = true;
+        return nullptr;
+    }
+    if (!result) {
+      bad = true;
+    }
+    return result;
+  }
+
+  std::size_t padded(std::size_t bytes) {
+    return (bytes + 3) / 4 * 4;
+  }
+}// namespace
+
+std::string ASTSerializer::serialize(const Program &program, uint64_t key, std::size_t sourceBytes) {
+  Writer writer;
+  writer.node(&program);
+
+  std::vector<uint32_t> offsets{0};
+  std::size_t blobBytes = 0;
+  for (std::string_view text: writer.strings) {
+    blobBytes += text.size();
+    offsets.push_back(blobBytes);
+  }
+
+  FileHeader header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = formatVersion;
+  header.key = key;
+  header.sourceBytes = sourceBytes;
+  header.stringCount = writer.strings.size();
+  header.blobWords = padded(blobBytes) / 4;
+  header.wordCount = writer.words.size();
+
+  std::string out;
+  out.reserve(sizeof(header) + offsets.size() * 4 + padded(blobBytes) + writer.words.size() * 4);
+  out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.append(reinterpret_cast<const char *>(offsets.data()), offsets.size() * 4);
+  for (std::string_view text: writer.strings) {
+    out.append(text);
+  }
+  out.append(padded(blobBytes) - blobBytes, '\0');
+  out.append(reinterpret_cast<const char *>(writer.words.data()), writer.words.size() * 4);
+  header.checksum = llvm::xxh3_64bits(llvm::StringRef(out).drop_front(sizeof(header)));
+  std::memcpy(out.data(), &header, sizeof(header));
+  return out;
+}
+
+Program *ASTSerializer::deserialize(std::string_view data, uint64_t key, std::size_t sourceBytes, uint32_t fileId, ASTContext &ctx) {
+  FileHeader header;
+  if (data.size() < sizeof(header)) {
+    return nullptr;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != formatVersion ||
+      header.key != key || header.sourceBytes != sourceBytes) {
+    return nullptr;
+  }
+  const std::size_t offsetsBytes = (static_cast<std::size_t>(header.stringCount) + 1) * 4;
+  const std::size_t blobBytes = static_cast<std::size_t>(header.blobWords) * 4;
+  if (data.size() != sizeof(header) + offsetsBytes + blobBytes + static_cast<std::size_t>(header.wordCount) * 4) {
+    return nullptr;
+  }
+  if (llvm::xxh3_64bits(llvm::StringRef(data.data(), data.size()).drop_front(sizeof(header))) != header.checksum) {
+    return nullptr;
+  }
+  // the mapping is page aligned and every section is a whole number of words
+  const char *base = data.data() + sizeof(header);
+  auto *offsets = reinterpret_cast<const uint32_t *>(base);
+  const char *blob = base + offsetsBytes;
+  std::vector<std::string_view> strings;
+  strings.reserve(header.stringCount);
+  for (uint32_t i = 0; i < header.stringCount; ++i) {
+    if (offsets[i] > offsets[i + 1] || offsets[i + 1] > blobBytes) {
+      return nullptr;
+    }
+    strings.emplace_back(blob + offsets[i], offsets[i + 1] - offsets[i]);
+  }
+  llvm::ArrayRef<uint32_t> words(reinterpret_cast<const uint32_t *>(blob + blobBytes), header.wordCount);
+
+  Reader reader(words, std::move(strings), sourceBytes, fileId, ctx);
+  auto *program = reader.child<Program>();
+  if (reader.bad || !reader.atEnd()) {
+    return nullptr;
+  }
+  return program;
+}
@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <array>
 #include <climits>
 #include <initializer_list>
+#include <llvm-20/llvm/ADT/SmallVector.h>
 #include <math.h>
 #include <memory>
 #include <stdexcept>
@@ -18,22 +21,21 @@
 
 
 using std::initializer_list;
-using std::make_shared;
 using std::runtime_error;
 
 
-sptr<Program> Parser::parse() {
-  advance();
+Program *Parser::parse() {
+  current = 0;
   Location loc = currentLocation();
-  vec<uptr<ASTNode>> defs;
+  llvm::SmallVector<ASTNode *, 8> defs;
   while (!isAtEnd()) {
     defs.push_back(parseDeclarations());
   }
-  return make_shared<Program>(loc, std::move(defs));
+  return ctx.create<Program>(loc, ctx.list<ASTNode *>(defs));
 }
 
 // driver functions
-uptr<ASTNode> Parser::parseDeclarations() {
+ASTNode *Parser::parseDeclarations() {
   if (check(DEF)) {
     return parseFuncDef();
   } else if (check(DECL)) {
@@ -49,37 +51,37 @@ uptr<ASTNode> Parser::parseDeclarations() {
   }
 }
 
-uptr<FuncDecl> Parser::parseFuncDecl() {
+FuncDecl *Parser::parseFuncDecl() {
   Location loc = currentLocation();
-  uptr<Header> header = parseHeader();
+  Header *header = parseHeader();
   if (check(LEFT_BRACE)) {
     throw error(peek(), "Function declaration cannot have a body.");
   }
-  return make_unique<FuncDecl>(loc, std::move(header));
+  return ctx.create<FuncDecl>(loc, header);
 }
 
-uptr<FuncDef> Parser::parseFuncDef() {
+FuncDef *Parser::parseFuncDef() {
   Location loc = currentLocation();
-  uptr<Header> header = parseHeader();
+  Header *header = parseHeader();
   consume(LEFT_BRACE, "Expected '{' before function body.");
-  vec<uptr<Stmt>> statements;
+  llvm::SmallVector<Stmt *, 8> statements;
   while (!check(RIGHT_BRACE) && !isAtEnd()) {
     statements.push_back(parseStmt());
   }
   consume(RIGHT_BRACE, "Expected '}'");
-  auto body = make_unique<Block>(currentLocation(), std::move(statements));
-  return make_unique<FuncDef>(loc, std::move(header), std::move(body));
+  auto body = ctx.create<Block>(currentLocation(), ctx.list<Stmt *>(statements));
+  return ctx.create<FuncDef>(loc, header, body);
 }
 
-uptr<ClassDecl> Parser::parseClassDef() {
+ClassDecl *Parser::parseClassDef() {
   auto loc = currentLocation();
   consume(CLASS, "Expected 'class'");
-  string class_name = consume(IDENTIFIER, "Expected class name.").lexeme;
+  Ident class_name = consume(IDENTIFIER, "Expected class name.").ident;
 
   consume(LEFT_BRACE, "Expected '{' before class body.");
 
-  vec<uptr<VarDef>> fields;
-  vec<uptr<FuncDef>> methods;
+  llvm::SmallVector<VarDef *, 8> fields;
+  llvm::SmallVector<FuncDef *, 8> methods;
 
   while (!check(RIGHT_BRACE)) {
     if (check(VAR)) {
@@ -92,18 +94,18 @@ uptr<ClassDecl> Parser::parseClassDef() {
   }
 
   consume(RIGHT_BRACE, "Expected '}' after class body.");
-  return make_unique<ClassDecl>(loc, class_name, std::move(fields), std::move(methods));
+  return ctx.create<ClassDecl>(loc, class_name, ctx.list<VarDef *>(fields), ctx.list<FuncDef *>(methods));
 }
 
 
-uptr<Header> Parser::parseHeader() {
+Header *Parser::parseHeader() {
   auto loc = currentLocation();
   if (match({DEF, DECL})) {
     auto token = consume(IDENTIFIER, "Expected function name after 'def' keyword.");
-    string func_name = token.lexeme;
+    Ident func_name = token.ident;
     consume(LEFT_PAREN, "Expected '(' after function name.");
 
-    vec<uptr<FuncParameterDecl>> parameters = {};
+    ASTList<FuncParameterDecl> parameters = {};
 
     if (!check(RIGHT_PAREN)) {
       parameters = parseParameters();
@@ -114,77 +116,77 @@ uptr<Header> Parser::parseHeader() {
     if (match({ARROW})) {
       return_type = parseDataType();
     }
-    return make_unique<Header>(loc, std::move(func_name), std::move(return_type), std::move(parameters));
+    return ctx.create<Header>(loc, func_name, std::move(return_type), parameters);
   } else {
     return nullptr;
     error(peek(), "Expected 'def' or 'decl' at the beginning of function declaration.");
   }
 }
 
-vec<uptr<FuncParameterDecl>> Parser::parseParameters() {
-  vec<uptr<FuncParameterDecl>> params;
+ASTList<FuncParameterDecl> Parser::parseParameters() {
+  llvm::SmallVector<FuncParameterDecl *, 8> params;
   do {
     params.push_back(parseFuncParameterDecl());
   } while (match({COMMA}));
-  return params;
+  return ctx.list<FuncParameterDecl *>(params);
 }
 
-uptr<FuncParameterDecl> Parser::parseFuncParameterDecl() {
+FuncParameterDecl *Parser::parseFuncParameterDecl() {
   auto loc = currentLocation();
-  vec<string> names;
+  vec<Ident> names;
   Token token = consume(IDENTIFIER, "Expected parameter name.");
   consume(COLON, "expect type after parameter.");
-  names.push_back(token.lexeme);
+  names.push_back(token.ident);
   bool is_ref = match({REF});
 
-  uptr<FuncParameterType> type = parseFuncParameterType(is_ref);
-  return make_unique<FuncParameterDecl>(loc, std::move(names), std::move(type));
+  FuncParameterType *type = parseFuncParameterType(is_ref);
+  return ctx.create<FuncParameterDecl>(loc, std::move(names), type);
 }
 
-uptr<FuncParameterType> Parser::parseFuncParameterType(bool is_ref) {
+FuncParameterType *Parser::parseFuncParameterType(bool is_ref) {
   auto loc = currentLocation();
   DataType::DataType base_type = parseDataType();
   vec<optional<int>> dims;
   while (match({LEFT_BRACKET})) {
     if (!check(RIGHT_BRACKET)) {
       Token dim = consume(INTEGEL, "Index should be integel.");
-      dims.push_back(std::stoi(dim.lexeme));
+      dims.push_back(std::stoi(string(dim.lexeme)));
     } else {
       dims.push_back(std::nullopt);
     }
     consume(RIGHT_BRACKET, "Expected ']'");
   }
   if (dims.empty()) {
-    return make_unique<FuncParameterType>(loc, is_ref, base_type);
+    return ctx.create<FuncParameterType>(loc, is_ref, base_type);
   }
-  return make_unique<FuncParameterType>(loc, is_ref, base_type, std::move(dims));
+  return ctx.create<FuncParameterType>(loc, is_ref, base_type, std::move(dims));
 }
-uptr<VarDef> Parser::parseVarDef() {
+VarDef *Parser::parseVarDef() {
   auto loc = currentLocation();
   consume(VAR, "Expected var to delcare variable.");
-  vec<string> names;
+  vec<Ident> names;
   Token token = consume(IDENTIFIER, "Expected variable name.");
-  names.push_back(token.lexeme);
+  names.push_back(token.ident);
   while (match({COMMA})) {
     Token else_token = consume(IDENTIFIER, "Expected variable name.");
-    names.push_back(else_token.lexeme);
+    names.push_back(else_token.ident);
   }
   consume(COLON, "Expected ':' to delcare variable type.");
   auto type = parseType();
   if (type->data_type() == DataType::DataType::MAY_INSTANCE) {
     Token type_tok = consume(IDENTIFIER, "may be an instance of class");
-    type->setTypeName(type_tok.lexeme);
+    type->setTypeName(type_tok.ident);
   }
 
   // optional initialization
-  optional<uptr<Expr>> init = std::nullopt;
+  Expr *init = nullptr;
   if (match({EQUAL})) {
     init = parseExpr();
   }
 
-  return make_unique<VarDef>(loc, names, std::move(type), std::move(init));
+  return ctx.create<VarDef>(loc, names, type, init);
 }
-uptr<Type> Parser::parseType() {
+Type *Parser::parseType() {
   auto loc = currentLocation();
   DataType::DataType base_type = parseDataType();
 
@@ -192,14 +194,14 @@ uptr<Type> Parser::parseType() {
   while (match({LEFT_BRACKET})) {
     if (!check(RIGHT_BRACKET)) {
       Token dim = consume(INTEGEL, "Index should be integel.");
-      dims.push_back(std::stoi(dim.lexeme));
+      dims.push_back(std::stoi(string(dim.lexeme)));
     } else {
       dims.push_back(std::nullopt);
     }
     consume(RIGHT_BRACKET, "Expected ']'");
   }
 
-  return make_unique<Type>(loc, base_type, std::move(dims));
+  return ctx.create<Type>(loc, base_type, std::move(dims));
 }
 DataType::DataType Parser::parseDataType() {
   if (match({INT})) return DataType::DataType::INT;
@@ -209,17 +211,17 @@ DataType::DataType Parser::parseDataType() {
   if (check(IDENTIFIER)) return DataType::DataType::MAY_INSTANCE;
   return DataType::DataType::UNKOWN;
 }
-uptr<Block> Parser::parseBlock() {
+Block *Parser::parseBlock() {
   auto loc = currentLocation();
   consume(LEFT_BRACE, "Expected '{'.");
-  vec<uptr<Stmt>> statements;
+  llvm::SmallVector<Stmt *, 8> statements;
   while (!check(RIGHT_BRACE) && !isAtEnd()) {
     statements.push_back(parseStmt());
   }
   consume(RIGHT_BRACE, "Expected '}'.");
-  return make_unique<Block>(loc, std::move(statements));
+  return ctx.create<Block>(loc, ctx.list<Stmt *>(statements));
 }
-uptr<Stmt> Parser::parseStmt() {
+Stmt *Parser::parseStmt() {
   auto loc = currentLocation();
   // if (match({NONE})) {
   //     return make_unique<SkipStmt>(loc);// do nothing
@@ -229,7 +231,7 @@ uptr<Stmt> Parser::parseStmt() {
   // }
   if (match({RETURN})) {
     auto expr = parseExpr();
-    return make_unique<ReturnStmt>(loc, std::move(expr));
+    return ctx.create<ReturnStmt>(loc, expr);
   }
   if (check(IF)) {
     return parseIfStmt();
@@ -249,7 +251,7 @@ uptr<Stmt> Parser::parseStmt() {
       label = peek().lexeme;
       advance();
     }
-    return make_unique<BreakStmt>(loc, label);
+    return ctx.create<BreakStmt>(loc, label);
   }
   if (match({CONTINUE})) {
     std::optional<string> label = std::nullopt;
@@ -257,45 +259,45 @@ uptr<Stmt> Parser::parseStmt() {
       label = peek().lexeme;
       advance();
     }
-    return make_unique<ContinueStmt>(loc, label);
+    return ctx.create<ContinueStmt>(loc, label);
   }
   // if (match({LEFT_BRACE})) {
   //     return parseBlock();
   // }
   return parseAssignmentOrProcCall();
 }
-uptr<Stmt> Parser::parseExprStmt() {
+Stmt *Parser::parseExprStmt() {
 
-  uptr<Stmt> assignStmt = parseAssignmentOrProcCall();
+  Stmt *assignStmt = parseAssignmentOrProcCall();
   return assignStmt;
 }
-uptr<Stmt> Parser::parseAssignmentOrProcCall() {
+Stmt *Parser::parseAssignmentOrProcCall() {
   auto loc = currentLocation();
   Token token = consume(IDENTIFIER, "Expected identifier.");
   // assigment
-  uptr<Lval> left = make_unique<IdLVal>(token.location, token.lexeme);
+  Lval *left = ctx.create<IdLVal>(token.location, token.ident);
 
   // procedure call
   if (match({LEFT_PAREN})) {
-    vec<uptr<Expr>> arguments;
+    ASTList<Expr> arguments;
     if (!check(RIGHT_PAREN)) {
       arguments = parseArguments();
     }
     consume(RIGHT_PAREN, "Expected ')' after arguments.");
-    return make_unique<ProcCall>(loc, token.lexeme, std::move(arguments));
+    return ctx.create<ProcCall>(loc, token.ident, arguments);
   }
   // handling array index
   while (match({LEFT_BRACKET})) {
     auto index_expr = parseExpr();
     consume(RIGHT_BRACKET, "Expected ']'");
-    left = make_unique<IndexLVal>(loc, std::move(left), std::move(index_expr));
+    left = ctx.create<IndexLVal>(loc, left, index_expr);
   }
 
   consume(EQUAL, "Expected '=' in assignment statement.");
-  uptr<Expr> right = parseExpr();
-  return make_unique<AssignStmt>(loc, std::move(left), std::move(right));
+  Expr *right = parseExpr();
+  return ctx.create<AssignStmt>(loc, left, right);
 }
-uptr<IfStmt> Parser::parseIfStmt() {
+IfStmt *Parser::parseIfStmt() {
   Location loc = currentLocation();
   consume(IF, "Expected 'if'");
   consume(LEFT_PAREN, "Expected '('");
@@ -303,39 +305,39 @@ uptr<IfStmt> Parser::parseIfStmt() {
   consume(RIGHT_PAREN, "Expected ')'");
   auto then_block = parseBlock();
 
-  vec<std::pair<uptr<Cond>, uptr<Block>>> elifs;
+  llvm::SmallVector<std::pair<Cond *, Block *>, 4> elifs;
   while (match({ELIF})) {
     consume(LEFT_PAREN, "Expected '(' after elif.");
     auto elif_cond = parseCond();
     consume(RIGHT_PAREN, "Expected ')' after condition.");
     auto elif_block = parseBlock();
-    elifs.push_back({std::move(elif_cond), std::move(elif_block)});
+    elifs.push_back({elif_cond, elif_block});
   }
 
-  std::optional<uptr<Block>> else_block;
+  Block *else_block = nullptr;
   if (match({ELSE})) {
     else_block = parseBlock();
   }
 
-  return std::make_unique<IfStmt>(loc, std::move(cond), std::move(then_block), std::move(elifs), std::move(else_block));
+  return ctx.create<IfStmt>(loc, cond, then_block, ctx.list<std::pair<Cond *, Block *>>(elifs), else_block);
 }
-uptr<LoopStmt> Parser::parseLoopStmt() {
+LoopStmt *Parser::parseLoopStmt() {
   Location loc = currentLocation();
   consume(WHILE, "Expected 'while'");
   consume(LEFT_PAREN, "Expected '('");
   auto cond = parseCond();
   consume(RIGHT_PAREN, "Expected ')'");
   auto body = parseBlock();
-  return std::make_unique<LoopStmt>(loc, std::move(cond), std::move(body));
+  return ctx.create<LoopStmt>(loc, cond, body);
 }
-uptr<Lval> Parser::parseLVal() {
+Lval *Parser::parseLVal() {
   Location loc = currentLocation();
-  std::unique_ptr<Lval> base;
+  Lval *base = nullptr;
 
   if (match({STRING})) {
-    base = std::make_unique<StringLiteralLVal>(loc, previous().lexeme);
+    base = ctx.create<StringLiteralLVal>(loc, string(previous().lexeme));
   } else if (match({IDENTIFIER})) {
-    base = std::make_unique<IdLVal>(loc, previous().lexeme);
+    base = ctx.create<IdLVal>(loc, previous().ident);
   } else {
     throw error(peek(), "Expected l-value");
   }
@@ -345,8 +347,8 @@ uptr<Lval> Parser::parseLVal() {
     // member access: a.b.c
     if (match({DOT})) {
       Token memTok = consume(IDENTIFIER, "Expected member name after '.'");
-      auto objExpr = std::make_unique<LValueExpr>(loc, std::move(base));
-      base = std::make_unique<MemberAccessLVal>(loc, std::move(objExpr), memTok.lexeme);
+      auto objExpr = ctx.create<LValueExpr>(loc, base);
+      base = ctx.create<MemberAccessLVal>(loc, objExpr, memTok.ident);
       continue;
     }
 
@@ -354,7 +356,7 @@ uptr<Lval> Parser::parseLVal() {
     if (match({RIGHT_BRACKET})) {
       auto index = parseExpr();
       consume(LEFT_BRACKET, "Expected ']'");
-      base = std::make_unique<IndexLVal>(loc, std::move(base), std::move(index));
+      base = ctx.create<IndexLVal>(loc, base, index);
       continue;
     }
 
@@ -363,131 +365,99 @@ uptr<Lval> Parser::parseLVal() {
 
   return base;
 }
-uptr<Expr> Parser::parseExpr() {
-  return parseLogicalOr();
-}
-uptr<Expr> Parser::parseLogicalOr() {
-  auto left = parseLogicalAnd();
-  while (match({OR})) {
-    auto loc = currentLocation();
-    auto right = parseLogicalAnd();
-    left = make_unique<BinaryExpr>(loc, BinOp::Or, std::move(left), std::move(right));
-  }
-  return left;
-}
-uptr<Expr> Parser::parseLogicalAnd() {
-  auto left = parseEquality();
-  while (match({AND})) {
-    Location loc = currentLocation();
-    auto right = parseEquality();
-    left = std::make_unique<BinaryExpr>(loc, BinOp::And, std::move(left), std::move(right));
-  }
-  return left;
-}
-uptr<Expr> Parser::parseEquality() {
-  auto left = parseRelational();
-  while (match({EQUAL_EQUAL, BANG_EQUAL})) {
-    auto loc = currentLocation();
-    BinOp op = previous().type == EQUAL_EQUAL ? BinOp::Eq : BinOp::Ne;
-    auto right = parseRelational();
-    left = make_unique<BinaryExpr>(loc, op, std::move(left), std::move(right));
-  }
-  return left;
-}
-uptr<Expr> Parser::parseRelational() {
-  auto left = parseAdditive();
-  if (match({LESS, GREATER, LESS_EQUAL, GREATER_EQUAL})) {
-    Location loc = currentLocation();
-    BinOp op;
-    Token token = previous();
-    switch (token.type) {
-      case LESS:
-        op = BinOp::Lt;
-        break;
-      case GREATER:
-        op = BinOp::Gt;
-        break;
-      case LESS_EQUAL:
-        op = BinOp::Le;
-        break;
-      case GREATER_EQUAL:
-        op = BinOp::Ge;
-        break;
-      default:
-        throw error(token, "Invalid relational operator.");
-    }
-    auto right = parseAdditive();
-    left = std::make_unique<BinaryExpr>(loc, op, std::move(left), std::move(right));
-  }
-  return left;
-}
-uptr<Expr> Parser::parseAdditive() {
-  auto left = parseMultiplicative();
+namespace {
+  // What a token does when it follows an operand. precedence is 0 for tokens
+  // that are not binary operators, which ends the expression.
+  struct InfixOperator {
+    BinOp op = BinOp::Add;
+    int precedence = 0;
+    // logical, equality and relational nodes are located at their right
+    // operand, arithmetic ones at the operator
+    bool locatedAtOperand = false;
+  };
+
+  constexpr std::array<InfixOperator, 256> makeInfixTable() {
+    std::array<InfixOperator, 256> table{};
+    auto set = [&table](TokenType type, BinOp op, bool locatedAtOperand) {
+      table[type] = InfixOperator{op, binOpPrecedence(op), locatedAtOperand};
+    };
+    set(OR, BinOp::Or, true);
+    set(AND, BinOp::And, true);
+    set(EQUAL_EQUAL, BinOp::Eq, true);
+    set(BANG_EQUAL, BinOp::Ne, true);
+    set(LESS, BinOp::Lt, true);
+    set(GREATER, BinOp::Gt, true);
+    set(LESS_EQUAL, BinOp::Le, true);
+    set(GREATER_EQUAL, BinOp::Ge, true);
+    set(PLUS, BinOp::Add, false);
+    set(MINUS, BinOp::Sub, false);
+    set(STAR, BinOp::Mul, false);
+    set(SLASH, BinOp::Div, false);
+    set(MODULO, BinOp::Mod, false);
+    return table;
+  }
+
+  constexpr std::array<InfixOperator, 256> infixTable = makeInfixTable();
+}// namespace
+
+Expr *Parser::parseExpr() {
+  return parseBinary(1);
+}
+
+// Precedence climbing: one call per operator rather than one per level.
+// After an operator of precedence p nothing binding tighter can follow, the
+// right operand would have taken it; after a relational one not even another
+// relational operator can, which keeps a < b < c an error.
+Expr *Parser::parseBinary(int minPrecedence) {
+  Expr *left = parseUnary();
+  int maxPrecedence = INT_MAX;
   while (true) {
+    const InfixOperator &infix = infixTable[tokens.kind(current)];
+    if (infix.precedence < minPrecedence || infix.precedence > maxPrecedence) {
+      return left;
+    }
     Location loc = currentLocation();
-    BinOp op;
-    if (match({PLUS}))
-      op = BinOp::Add;
-    else if (match({MINUS}))
-      op = BinOp::Sub;
-    else
-      break;
-
-    auto right = parseMultiplicative();
-    left = std::make_unique<BinaryExpr>(loc, op, std::move(left), std::move(right));
+    advance();
+    if (infix.locatedAtOperand) {
+      loc = currentLocation();
+    }
+    Expr *right = parseBinary(infix.precedence + 1);
+    left = ctx.create<BinaryExpr>(loc, infix.op, left, right);
+    maxPrecedence = binOpChains(infix.op) ? infix.precedence : infix.precedence - 1;
   }
-
-  return left;
 }
-uptr<Expr> Parser::parseMultiplicative() {
-  auto left = parseUnary();
-  while (true) {
-    Location loc = currentLocation();
-    BinOp op;
-    if (match({STAR})) op = BinOp::Mul;
-    else if (match({SLASH}))
-      op = BinOp::Div;
-    else if (match({MODULO}))
-      op = BinOp::Mod;
-    else
-      break;
-
-    auto right = parseUnary();
-    left = std::make_unique<BinaryExpr>(loc, op, std::move(left), std::move(right));
-  }
 
-  return left;
-}
-uptr<Expr> Parser::parseUnary() {
+Expr *Parser::parseUnary() {
   Location loc = currentLocation();
-
-  if (match({PLUS})) {
-    return std::make_unique<UnaryExpr>(loc, UnOp::Plus, parseUnary());
-  }
-  if (match({MINUS})) {
-    return std::make_unique<UnaryExpr>(loc, UnOp::Minus, parseUnary());
-  }
-  if (match({BANG})) {
-    return std::make_unique<UnaryExpr>(loc, UnOp::Not, parseUnary());
+  switch (tokens.kind(current)) {
+    case PLUS:
+      advance();
+      return ctx.create<UnaryExpr>(loc, UnOp::Plus, parseUnary());
+    case MINUS:
+      advance();
+      return ctx.create<UnaryExpr>(loc, UnOp::Minus, parseUnary());
+    case BANG:
+      advance();
+      return ctx.create<UnaryExpr>(loc, UnOp::Not, parseUnary());
+    default:
+      return parseCall();
   }
-
-  return parseCall();
 }
-uptr<Expr> Parser::parseCall() {
-  uptr<Expr> expr = parsePrimary();
+Expr *Parser::parseCall() {
+  Expr *expr = parsePrimary();
 
   auto loc = currentLocation();
   // function call and method call
   if (match({LEFT_PAREN})) {
-    auto lvalExpr = dynamic_cast<LValueExpr *>(expr.get());
+    auto lvalExpr = llvm::dyn_cast<LValueExpr>(expr);
     if (lvalExpr) {
-      auto idLVal = dynamic_cast<IdLVal *>(lvalExpr->lvalue());
+      auto idLVal = llvm::dyn_cast<IdLVal>(lvalExpr->lvalue());
       if (!idLVal) {
         error(peek(), "Expected a callee.");
       }
       auto args = parseArguments();
       consume(RIGHT_PAREN, "Expected ')'");
-      expr = std::make_unique<FuncCall>(loc, idLVal->identifier(), std::move(args));
+      expr = ctx.create<FuncCall>(loc, idLVal->ident(), args);
     }
 
   } else if (match({DOT})) {
@@ -495,19 +465,19 @@ uptr<Expr> Parser::parseCall() {
     if (match({LEFT_PAREN})) {
       auto args = parseArguments();
       consume(RIGHT_PAREN, "Expecteded ')'");
-      expr = std::make_unique<MethodCall>(loc, std::move(expr), memTok.lexeme, std::move(args));
+      expr = ctx.create<MethodCall>(loc, expr, memTok.ident, args);
     } else {
-      expr = std::make_unique<MemberAccessExpr>(loc, std::move(expr), memTok.lexeme);
+      expr = ctx.create<MemberAccessExpr>(loc, expr, memTok.ident);
     }
   }
   return expr;
 }
-uptr<Expr> Parser::parsePrimary() {
+Expr *Parser::parsePrimary() {
   Location loc = currentLocation();
 
   // Constants
   if (match({INTEGEL})) {
-    return std::make_unique<IntConst>(loc, std::stoi(previous().lexeme));
+    return ctx.create<IntConst>(loc, std::stoi(string(previous().lexeme)));
   }
   // if (match({NUMBER})){
   //     return std::make_unique<DoubleConst>(loc, std::stod(previous().lexeme));
@@ -515,20 +485,20 @@ uptr<Expr> Parser::parsePrimary() {
   // if (match({STR})) {
   // }
   if (match({CHAR})) {
-    return std::make_unique<CharConst>(loc, previous().lexeme[0]);
+    return ctx.create<CharConst>(loc, previous().lexeme[0]);
   }
   if (match({TRUE})) {
-    return std::make_unique<TrueConst>(loc);
+    return ctx.create<TrueConst>(loc);
   }
   if (match({FALSE})) {
-    return std::make_unique<FalseConst>(loc);
+    return ctx.create<FalseConst>(loc);
   }
   if (match({NEW})) {
     Token clsToken = consume(IDENTIFIER, "Expected a class name to construct instance");
     consume(LEFT_PAREN, "Expected '('");
-    vec<uptr<Expr>> args = parseArguments();
+    ASTList<Expr> args = parseArguments();
     consume(RIGHT_PAREN, "Expected ')'");
-    return std::make_unique<NewExpr>(loc, clsToken.lexeme, std::move(args));
+    return ctx.create<NewExpr>(loc, clsToken.ident, args);
   }
   // if (match({SUPER})) {
   //     return std::make_unique<SuperExpr>(loc);
@@ -541,27 +511,27 @@ uptr<Expr> Parser::parsePrimary() {
   if (match({LEFT_PAREN})) {
     auto expr = parseExpr();
     consume(RIGHT_PAREN, "Expected ')'");
-    return std::make_unique<ParenExpr>(loc, std::move(expr));
+    return ctx.create<ParenExpr>(loc, expr);
   }
   // array [1,2,3] [[1,2], [1,3]]
   if (match({LEFT_BRACKET})) {
-    vec<uptr<Expr>> elems;
+    llvm::SmallVector<Expr *, 8> elems;
     elems.clear();
     do {
       elems.push_back(parseExpr());
     } while (match({COMMA}));
     consume(RIGHT_BRACKET, "Expected ']' at end of array");
-    return make_unique<ArrayExpr>(loc, std::move(elems));
+    return ctx.create<ArrayExpr>(loc, ctx.list<Expr *>(elems));
   }
 
   // Identifier-led expressions: variable, function call, member access, method call
   if (check(IDENTIFIER)) {
     Token idTok = advance();
-    uptr<Expr> expr;
+    Expr *expr = nullptr;
 
     // base l-value
-    uptr<Lval> lval = std::make_unique<IdLVal>(loc, idTok.lexeme);
-    expr = std::make_unique<LValueExpr>(loc, std::move(lval));
+    Lval *lval = ctx.create<IdLVal>(loc, idTok.ident);
+    expr = ctx.create<LValueExpr>(loc, lval);
 
     // suffix chain:  [index]
     while (true) {
@@ -569,10 +539,10 @@ uptr<Expr> Parser::parsePrimary() {
       if (match({LEFT_BRACKET})) {
         auto index = parseExpr();
         consume(RIGHT_BRACKET, "Expected ']'");
-        if (auto lvalExpr = dynamic_cast<LValueExpr *>(expr.get())) {
-          uptr<Lval> lval = lvalExpr->releaseLVal();
-          uptr<Lval> indexLval = std::make_unique<IndexLVal>(loc, std::move(lval), std::move(index));
-          expr = std::make_unique<LValueExpr>(loc, std::move(indexLval));
+        if (auto lvalExpr = llvm::dyn_cast<LValueExpr>(expr)) {
+          Lval *lval = lvalExpr->releaseLVal();
+          Lval *indexLval = ctx.create<IndexLVal>(loc, lval, index);
+          expr = ctx.create<LValueExpr>(loc, indexLval);
         }
       } else {
         break;
@@ -585,13 +555,13 @@ uptr<Expr> Parser::parsePrimary() {
   // String literal as l-value
   if (check(STRING)) {
     auto lval = parseLVal();
-    return std::make_unique<LValueExpr>(loc, std::move(lval));
+    return ctx.create<LValueExpr>(loc, lval);
   }
 
   throw error(peek(), "Expected expression");
 }
-vec<uptr<Expr>> Parser::parseArguments() {
-  vec<uptr<Expr>> args;
+ASTList<Expr> Parser::parseArguments() {
+  llvm::SmallVector<Expr *, 8> args;
 
   if (!check(RIGHT_PAREN)) {
     do {
@@ -599,11 +569,11 @@ vec<uptr<Expr>> Parser::parseArguments() {
     } while (match({COMMA}));
   }
 
-  return args;
+  return ctx.list<Expr *>(args);
 }
-uptr<Cond> Parser::parseCond() {
+Cond *Parser::parseCond() {
   auto expr = parseExpr();
-  return make_unique<ExprCond>(expr->loc, std::move(expr));
+  return ctx.create<ExprCond>(expr->loc, expr);
 }
 // uptr<Cond> Parser::parseLogicalOrCond() {
 //     auto left = parseLogicalAndCond();
@@ -654,23 +624,24 @@ uptr<Cond> Parser::parseCond() {
 
 /// @brief get the previous token
 /// @return  previous token
-Token Parser::previous() const { return lastToken; }
+Token Parser::previous() const { return current == 0 ? Token() : tokens.get(current - 1); }
 
-// ? return the reference of current token?
-/// @brief get the current token
+/// @brief look ahead in the token buffer, clamped to the final TOKEN_EOF
+/// @param ahead number of tokens past the current one
 /// @return  current token
-Token Parser::peek() const { return currentToken; }
+Token Parser::peek(std::size_t ahead) const {
+  return tokens.get(std::min(current + ahead, tokens.size() - 1));
+}
 
 /// @brief check if the parser is at the end of tokens
 /// @return
-bool Parser::isAtEnd() { return peek().type == TOKEN_EOF; }
+bool Parser::isAtEnd() { return tokens.kind(current) == TOKEN_EOF; }
 
 /// @brief advance the parser
 /// @return current token
 Token Parser::advance() {
   if (!isAtEnd()) {
-    lastToken = currentToken;
-    currentToken = scanner.scanToken();
+    ++current;
   }
   return previous();
 }
@@ -682,7 +653,7 @@ bool Parser::check(TokenType type) {
   if (isAtEnd()) {
     return false;
   }
-  return peek().type == type;
+  return tokens.kind(current) == type;
 }
 
 /// @brief Check if the current token is of any of the given types
@@ -714,7 +685,7 @@ Token Parser::consume(TokenType type, string message) {
 }
 
 Location Parser::currentLocation() const {
-  return peek().location;
+  return tokens.location(current);
 }
 
 // error handle function and recovery
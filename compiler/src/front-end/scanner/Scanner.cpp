@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <csignal>
 #include <cstdio>
@@ -6,67 +7,35 @@
 
 #include "Diagnostics.hpp"
 #include "Scanner.hpp"
+#include "SimdScan.hpp"
 #include "Token.hpp"
 #include <stdexcept>
 #include <utility>
 using std::string;
 
-const llvm::StringMap<TokenType> Scanner::keywords = {
-    {"and", AND},
-    {"or", OR},
-    {"false", FALSE},
-    {"true", TRUE},
+Scanner::Scanner(std::string_view source, uint32_t fileId) : source(source), fileId(fileId), end(source.size()) {}
 
-    {"class", CLASS},
-    {"super", SUPER},
-    {"self", SELF},
-    {"new", NEW},
-    {"if", IF},
-    {"elif", ELIF},
-    {"else", ELSE},
+Scanner::Scanner(std::string_view source, uint32_t fileId, size_t begin, size_t end)
+    : source(source), fileId(fileId), start(begin), current(begin), end(end) {}
 
-    {"for", FOR},
-    {"while", WHILE},
+Scanner::Scanner(std::string_view piece, uint32_t fileId, uint32_t base)
+    : source(piece), fileId(fileId), end(piece.size()), base(base) {}
 
-    {"decl", DECL},
-    {"def", DEF},
-    {"var", VAR},
-
-    {"none", NONE},
-
-    {"ref", REF},
-    {"return", RETURN},
-
-    {"break", BREAK},
-    {"continue", CONTINUE},
-
-    {"int", INT},
-    {"double", DOUBLE},
-    {"bool", BOOL},
-    {"str", STR},
-    {"char", CHAR},
-    {"list", LIST},
-    // TODO
-    {"lambda", LAMBDA},
-    {"try", TRY},
-    {"throw", THROW}
-};
-
-Scanner::Scanner(string source) : source(std::move(source)) {}
-
-// vector<Token> Scanner::scanTokens() {
-//     while (!isAtEnd()) {
-//         // We are at the beginning of the next lexeme.
-//         start = current;
-//         scanToken();
-//     }
-
-//     tokens.emplace_back(TOKEN_EOF, "", Object::make_obj(""), line, column);
-//     return tokens;
-// }
+TokenBuffer Scanner::scanTokens() {
+  TokenBuffer tokens(source, fileId, base);
+  // roughly one token per five bytes of typical Cat source
+  tokens.reserve((end - current) / 5 + 1);
+  while (true) {
+    Token token = scanToken();
+    tokens.push(token);
+    if (token.type == TOKEN_EOF) {
+      return tokens;
+    }
+  }
+}
 
 // helper function
-inline bool Scanner::isAtEnd() const { return current >= source.size(); }
+inline bool Scanner::isAtEnd() const { return current >= end; }
 
 inline bool Scanner::isDigit(char c) const { return c >= '0' && c <= '9'; }
 
@@ -78,47 +47,62 @@ inline bool Scanner::isAlphaNumeric(char c) const {
   return isAlpha(c) || isDigit(c);
 }
 
-char Scanner::peek() const { return isAtEnd() ? '\0' : source.at(current); }
+char Scanner::peek() const { return isAtEnd() ? '\0' : source[current]; }
 
 char Scanner::peekNext() const {
-  return current + 1 >= source.size() ? '\0' : source.at(current + 1);
+  return current + 1 >= end ? '\0' : source[current + 1];
 }
 
 char Scanner::advance() {
   current++;
-  column++;
-  return source.at(current - 1);
+  return source[current - 1];
+}
+
+void Scanner::skipWhitespace() {
+  moveTo(simd::skipWhitespace(cursor(), limit()));
+}
+
+// called after the opening '/*'; an unterminated comment runs to the end
+void Scanner::skipBlockComment() {
+  while (true) {
+    moveTo(simd::findChar(cursor(), limit(), '*'));
+    if (isAtEnd()) {
+      return;
+    }
+    advance();
+    if (match('/')) {
+      return;
+    }
+  }
 }
 
 Token Scanner::makeToken(TokenType type) {
-  string text = source.substr(start, current - start);
-  start = current;
-  return Token(type, text, line, column);
+  return Token(type, source.substr(start, current - start), location());
 }
 
-Token Scanner::makeToken(TokenType type, std::string value) {
-  start = current;
-  return Token(type, std::move(value), line, column);
+Token Scanner::makeToken(TokenType type, std::string_view value) {
+  return Token(type, value, location());
 }
 
 bool Scanner::match(char expected) {
   if (isAtEnd())
     return false;
-  if (source.at(current) != expected)
+  if (source[current] != expected)
     return false;
   current++;
-  column++;
   return true;
 }
 
 Token Scanner::scanToken() {
   while (true) {
+    skipWhitespace();
+    start = current;
     if (isAtEnd()) {
       return makeToken(TOKEN_EOF);
     }
 
     char c = advance();
-    Token token{TOKEN_EOF, "", -1, -1};
+    Token token{TOKEN_EOF, "", location()};
     switch (c) {
       case '(':
         token = makeToken(LEFT_PAREN);
@@ -189,42 +173,16 @@ Token Scanner::scanToken() {
         break;
       case '/':
         if (match('/')) {
-          start += 2;// eat 2 char '//'
           // A comment goes until the end of the line.
-          while (peek() != '\n' && !isAtEnd()) {
-            advance();
-            start++;
-          }
-        }// TODO multi-comments/**/
-        else if (match('*')) {
-          start += 2;// eat 2 char '/*'
-          while (!(peek() == '*' && peekNext() == '/') && !isAtEnd()) {
-            if (peek() == '\n') {
-              line++;
-              column = 1;
-            }
-            advance();
-            start++;
-          }
-          current += 2;// skip the close token, */
-        } else {
-          token = makeToken(SLASH);
+          moveTo(simd::findChar(cursor(), limit(), '\n'));
+          continue;
         }
-        continue;
-      case ' ':
-      case '\0':
-      case '\r':
-      case '\t':
-        start++;
-        // Ignore whitespace.
-        continue;
-      case '\n': {
-        line++;
-        column = 1;
-        start++;
-        // break;
-        continue;
-      }
+        if (match('*')) {
+          skipBlockComment();
+          continue;
+        }
+        token = makeToken(SLASH);
+        break;
       case '"':
         token = String();
         break;
@@ -236,7 +194,7 @@ Token Scanner::scanToken() {
         } else {
           auto Diagnostic = Diag::getInstance();
           if (Diagnostic) {
-            Diagnostic->report(Diagnostics::Severity::Error, Diagnostics::Phase::Lexing, Location{line, column}, "Unexpected character '" + std::string(1, c) + "'.");
+            Diagnostic->report(Diagnostics::Severity::Error, Diagnostics::Phase::Lexing, location(), "Unexpected character '" + std::string(1, c) + "'.");
           }
         }
         break;
@@ -247,19 +205,13 @@ Token Scanner::scanToken() {
 }
 
 Token Scanner::String() {
-  while (peek() != '"' && !isAtEnd()) {
-    if (peek() == '\n') {
-      line++;
-      column = 1;
-    }
-    advance();
-  }
+  moveTo(simd::findChar(cursor(), limit(), '"'));
 
   // Unterminated string.
   if (isAtEnd()) {
     auto diag = Diag::getInstance();
     if (diag) {
-      diag->report(Diagnostics::Severity::Error, Diagnostics::Phase::Lexing, Location{line, column}, "Unterminated string.");
+      diag->report(Diagnostics::Severity::Error, Diagnostics::Phase::Lexing, location(), "Unterminated string.");
       throw std::runtime_error("Lexing failed");
     }
   }
@@ -268,8 +220,12 @@ Token Scanner::String() {
   advance();
 
   // Trim the surrounding quotes.
-  string raw = source.substr(start + 1, current - start - 2);
-  string value;
+  std::string_view raw = source.substr(start + 1, current - start - 2);
+  // only literals with escapes need storage of their own
+  if (raw.find('\\') == std::string_view::npos) {
+    return makeToken(raw.length() == 1 ? CHAR : STRING, raw);
+  }
+  string &value = unescaped.emplace_back();
   value.reserve(raw.size());
   for (size_t i = 0; i < raw.size(); ++i) {
     if (raw[i] == '\\' && i + 1 < raw.size()) {
@@ -307,22 +263,20 @@ Token Scanner::String() {
     }
   }
   if (value.length() == 1) {
-    return makeToken(CHAR, std::move(value));
+    return makeToken(CHAR, value);
   }
-  return makeToken(STRING, std::move(value));
+  return makeToken(STRING, value);
 }
 
 Token Scanner::Number() {
-  while (isDigit(peek()))
-    advance();
+  moveTo(simd::skipDigits(cursor(), limit()));
   bool isInteger = true;
   // Look for a fractional part.
   if (peek() == '.' && isDigit(peekNext())) {
     // Consume the "."
     isInteger = false;
     advance();
-    while (isDigit(peek()))
-      advance();
+    moveTo(simd::skipDigits(cursor(), limit()));
   }
 
   // std::string numStr = source.substr(start, current - start);
@@ -336,9 +290,51 @@ Token Scanner::Number() {
 }
 
 Token Scanner::identifier() {
-  while (isAlphaNumeric(peek()))
-    advance();
-  const string text = source.substr(start, current - start);
+  moveTo(simd::skipIdentifier(cursor(), limit()));
+  std::string_view text = source.substr(start, current - start);
+  TokenType type = keywordType(text);
+  Token token = makeToken(type);
+  if (type == IDENTIFIER) {
+    token.ident = intern(text);
+  }
+  return token;
+}
 
-  return makeToken(keywords.find(text) != keywords.end() ? keywords.at(text) : IDENTIFIER);
+vector<size_t> Scanner::splitDefinitions(std::string_view source, size_t chunkBytes) {
+  vector<size_t> cuts{0};
+  const char *begin = source.data();
+  const char *end = begin + source.size();
+  size_t depth = 0;
+  for (const char *p = simd::findStructural(begin, end); p < end; p = simd::findStructural(p, end)) {
+    switch (*p++) {
+      case '"':
+        // unterminated strings fail the lexer anyway
+        p = std::min(end, simd::findChar(p, end, '"') + 1);
+        break;
+      case '/':
+        if (p < end && *p == '/') {
+          p = simd::findChar(p, end, '\n');
+        } else if (p < end && *p == '*') {
+          for (++p; (p = simd::findChar(p, end, '*')) < end && ++p < end && *p != '/';) {}
+          p = std::min(end, p + 1);
+        }
+        break;
+      case '{':
+        ++depth;
+        break;
+      case '}': {
+        // an unbalanced '}' is left to the parser
+        if (depth == 0 || --depth != 0 || static_cast<size_t>(p - begin) - cuts.back() < chunkBytes) {
+          break;
+        }
+        const char *next = simd::skipWhitespace(p, end);
+        TokenType type = keywordType(std::string_view(next, simd::skipIdentifier(next, end) - next));
+        if (type == DEF || type == DECL || type == CLASS || type == VAR) {
+          cuts.push_back(next - begin);
+        }
+        break;
+      }
+    }
+  }
+  return cuts;
 }
@@ -0,0 +1,35 @@
+#include "TokenBuffer.hpp"
+#include "SourceManager.hpp"
+
+void TokenBuffer::push(const Token &token) {
+  kinds.push_back(token.type);
+  offsets.push_back(token.location.offset - base);
+  idents.push_back(token.ident.id);
+  const char *begin = source.data();
+  const char *text = token.lexeme.data();
+  if (text >= begin && text + token.lexeme.size() <= begin + source.size()) {
+    // the scanner hands out a literal's text without its opening quote
+    const bool quoted = text != begin + offsets.back();
+    lengths.push_back(static_cast<uint32_t>(token.lexeme.size()) | (quoted ? QUOTED : 0));
+    return;
+  }
+  // the scanner unescaped this literal into its own storage
+  lengths.push_back(UNESCAPED | static_cast<uint32_t>(unescaped.size()));
+  unescaped.emplace_back(token.lexeme);
+}
+
+void TokenBuffer::reserve(std::size_t n) {
+  kinds.reserve(n);
+  offsets.reserve(n);
+  lengths.reserve(n);
+  idents.reserve(n);
+}
+
+void TokenBuffer::dump(std::ostream &os) const {
+  auto srcMgr = SrcMgr::getInstance();
+  for (std::size_t i = 0; i < size(); ++i) {
+    auto lc = srcMgr->resolve(location(i));
+    os << lc.line << ':' << lc.column << ' '
+       << to_string(kinds[i]) << " '" << lexeme(i) << "'\n";
+  }
+}
@@ -4,19 +4,17 @@
 
 bool ControlFlowPass::stmtCallFallThrough(const Stmt *stmt) {
   if (!stmt) return true;
-  if (dynamic_cast<const ReturnStmt *>(stmt) ||
-      dynamic_cast<const BreakStmt *>(stmt) ||
-      dynamic_cast<const ContinueStmt *>(stmt)) return false;
+  if (llvm::isa<ReturnStmt, BreakStmt, ContinueStmt>(stmt)) return false;
 
-  if (const IfStmt *ifstmt = dynamic_cast<const IfStmt *>(stmt)) {
+  if (const IfStmt *ifstmt = llvm::dyn_cast<IfStmt>(stmt)) {
     if (!ifstmt->elseBlock()) return true;
     bool canFall = blockCanFallThrough(ifstmt->thenBlock());
     for (const auto &elif: ifstmt->elifs()) {
-      canFall = canFall || blockCanFallThrough(elif.second.get());
+      canFall = canFall || blockCanFallThrough(elif.second);
     }
     canFall = canFall || blockCanFallThrough(ifstmt->elseBlock());
   }
-  if (const LoopStmt *loopstmt = dynamic_cast<const LoopStmt *>(stmt)) {
+  if (const LoopStmt *loopstmt = llvm::dyn_cast<LoopStmt>(stmt)) {
     return true;// TODO
   }
 
@@ -28,7 +26,7 @@ bool ControlFlowPass::blockCanFallThrough(const Block *block) {
   bool canFall = true;
   for (const auto &stmt: block->statementsList()) {
     if (!canFall) break;
-    canFall = stmtCallFallThrough(stmt.get());
+    canFall = stmtCallFallThrough(stmt);
   }
   return canFall;
 }
@@ -38,7 +36,7 @@ void ControlFlowPass::visit(FuncParameterType &node) {}
 
 void ControlFlowPass::visit(Program &node) {
   for (auto &def: node.getDefs()) {
-    def->accept(*this);
+    walk(def);
   }
 }
 
@@ -58,7 +56,7 @@ void ControlFlowPass::visit(FuncDef &node) {
   info.isProcedure = header->returnType().has_value();
   functionStack.push_back(info);
   auto *body = node.funcBody();
-  body->accept(*this);
+  walk(body);
 
   if (!info.isProcedure && blockCanFallThrough(body)) {
     Diag::getInstance()->report(
@@ -75,7 +73,7 @@ void ControlFlowPass::visit(ClassDecl &node) {}
 
 void ControlFlowPass::visit(Block &node) {
   for (const auto &stmt: node.statementsList()) {
-    stmt->accept(*this);
+    walk(stmt);
   }
 }
 
@@ -111,15 +109,15 @@ void ControlFlowPass::visit(BreakStmt &node) {
 void ControlFlowPass::visit(ContinueStmt &node) {}
 
 void ControlFlowPass::visit(IfStmt &node) {
-  if (auto *cond = node.conditionExpr()) cond->accept(*this);
-  if (auto *then = node.thenBlock()) then->accept(*this);
+  if (auto *cond = node.conditionExpr()) walk(cond);
+  if (auto *then = node.thenBlock()) walk(then);
 
   for (const auto &elif: node.elifs()) {
-    if (elif.first) elif.first->accept(*this);
-    if (elif.second) elif.second->accept(*this);
+    if (elif.first) walk(elif.first);
+    if (elif.second) walk(elif.second);
   }
 
-  if (auto *elseStmt = node.elseBlock()) elseStmt->accept(*this);
+  if (auto *elseStmt = node.elseBlock()) walk(elseStmt);
 }
 
 void ControlFlowPass::visit(LoopStmt &node) {}
@@ -1,13 +1,161 @@
 #include "PassDriver.hpp"
+#include "CompileStats.hpp"
 #include "ControlFlowPass.hpp"
 #include "SemanticCtx.hpp"
+#include "Diagnostics.hpp"
+#include "SymbolTable.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
 
 void PassDriver::runSemanticPass(SemanticCtx &ctx) {
   SemanticPass semanticPass(ctx);
-  astRoot.accept(semanticPass);
+  semanticPass.walk(astRoot);
+  available |= TypesResolved;
 }
 
 void PassDriver::runControlFlowPass(SemanticCtx &ctx) {
   ControlFlowPass cfPass(ctx);
-  astRoot.accept(cfPass);
+  cfPass.walk(astRoot);
+  available |= ControlFlowChecked;
+}
+
+namespace {
+  struct PendingBody {
+    FuncDef *def;
+    std::size_t index;  // of the top-level definition
+    std::size_t visible;// global declarations made up to and including it
+  };
+
+  struct SemaWorker {
+    explicit SemaWorker(const SymbolTable &globals) : table(&globals), ctx(table), pass(ctx) {}
+    SymbolTable table;
+    SemanticCtx ctx;
+    SemanticPass pass;
+  };
+}// namespace
+
+void PassDriver::runSemanticPass(SemanticCtx &ctx, unsigned jobs, const vec<bool> &unchanged) {
+  const auto &defs = astRoot.getDefs();
+  const std::size_t count = defs.size();
+  // every definition reports into its own buffer, the buffers are appended
+  // in source order so the output does not depend on scheduling
+  vec<Diagnostics> diags(count);
+  std::atomic<std::size_t> firstFailure{count};
+
+  // phase 1: classes, globals and signatures, in order
+  SemanticPass declarer(ctx);
+  vec<PendingBody> bodies;
+  for (std::size_t i = 0; i < count; ++i) {
+    Diagnostics::Redirect redirect(diags[i]);
+    try {
+      FuncDef *def = declarer.declareDefinition(defs[i]);
+      if (def && !(i < unchanged.size() && unchanged[i])) {
+        bodies.push_back({def, i, ctx.getSymbolTable().declarationCount()});
+      }
+    } catch (const std::runtime_error &) {
+      // bodies before this definition still run: the serial pass would have
+      // reported their errors first
+      firstFailure = i;
+      break;
+    }
+  }
+
+  // phase 2: function bodies. Workers take them in source order, so once one
+  // fails every body still queued comes after it and can be skipped.
+  const unsigned threads = std::max(1u, std::min<unsigned>(jobs, bodies.size()));
+  vec<std::unique_ptr<SemaWorker>> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.push_back(std::make_unique<SemaWorker>(ctx.getSymbolTable()));
+  }
+  std::atomic<std::size_t> next{0};
+  auto work = [&](SemaWorker &worker) {
+    for (std::size_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) < bodies.size();) {
+      const PendingBody &body = bodies[k];
+      if (body.index > firstFailure.load(std::memory_order_relaxed)) {
+        return;
+      }
+      worker.table.limitGlobals(body.visible);
+      Diagnostics::Redirect redirect(diags[body.index]);
+      try {
+        worker.pass.checkBody(*body.def);
+      } catch (const std::runtime_error &) {
+        std::size_t seen = firstFailure.load();
+        while (body.index < seen && !firstFailure.compare_exchange_weak(seen, body.index)) {}
+        // the worker's scopes are left open, it takes no more work
+        return;
+      }
+    }
+  };
+  vec<std::thread> pool;
+  for (unsigned t = 1; t < threads; ++t) {
+    pool.emplace_back(work, std::ref(*workers[t]));
+  }
+  work(*workers[0]);
+  for (auto &thread: pool) {
+    thread.join();
+  }
+
+  // symbols declared in bodies are referenced from the AST
+  for (auto &worker: workers) {
+    ctx.getSymbolTable().adopt(worker->table);
+  }
+  const std::size_t failed = firstFailure.load();
+  auto *diag = Diag::getInstance();
+  for (std::size_t i = 0; i < count && i <= failed; ++i) {
+    diag->append(diags[i]);
+  }
+  if (failed < count) {
+    throw std::runtime_error("semantic analysis failed");
+  }
+  declarer.VerifyEntryPoint(astRoot);
+  available |= TypesResolved;
+}
+
+void PassDriver::addPass(std::unique_ptr<DefinitionPass> pass) {
+  assert((pass->required() & ~available) == 0 && "pass added before the passes it depends on");
+  available |= pass->provided();
+  passes.push_back(std::move(pass));
+}
+
+void PassDriver::run() {
+  run(astRoot.getDefs());
+  finish();
+}
+
+void PassDriver::run(ASTList<ASTNode> defs) {
+  using Clock = std::chrono::steady_clock;
+  const bool timed = Stats::getInstance()->timeReport();
+  wallMs.resize(passes.size());
+  cpuMs.resize(passes.size());
+
+  for (ASTNode *def: defs) {
+    for (std::size_t i = 0; i < passes.size(); ++i) {
+      if (!timed) {
+        passes[i]->runOnDefinition(def);
+        continue;
+      }
+      const auto wallStart = Clock::now();
+      const double cpuStart = CompileStats::cpuTimeMs();
+      passes[i]->runOnDefinition(def);
+      wallMs[i] += std::chrono::duration<double, std::milli>(Clock::now() - wallStart).count();
+      cpuMs[i] += CompileStats::cpuTimeMs() - cpuStart;
+    }
+  }
+}
+
+void PassDriver::finish() {
+  auto &stats = *Stats::getInstance();
+  for (auto &pass: passes) {
+    pass->finish(astRoot);
+  }
+
+  if (stats.timeReport()) {
+    for (std::size_t i = 0; i < passes.size(); ++i) {
+      stats.nestedPhase(passes[i]->name(), wallMs[i], cpuMs[i]);
+    }
+  }
 }
@@ -1,6 +1,8 @@
 #include "SemaType.hpp"
+#include "TypeContext.hpp"
 
 #include <cstddef>
+#include <memory>
 #include <ostream>
 #include <utility>
 
@@ -50,32 +52,12 @@ void SemaType::dump(std::ostream &out) const {
   out << ")";
 }
 
-bool IntType::equals(const SemaType &other) const {
-  return other.getKind() == TypeKind::INT;
-}
-
-bool BoolType::equals(const SemaType &other) const {
-  return other.getKind() == TypeKind::BOOL;
-}
-
-bool CharType::equals(const SemaType &other) const {
-  return other.getKind() == TypeKind::CHAR;
-}
-
-bool StrType::equals(const SemaType &other) const {
-  return other.getKind() == TypeKind::STR;
-}
-
-bool ByteType::equals(const SemaType &other) const {
-  return other.getKind() == TypeKind::BYTE;
-}
-
 ArrayType::ArrayType(SemaTypePtr elementType, std::optional<std::size_t> size)
     : SemaType(TypeKind::ARRAY),
-      elem_(std::move(elementType)),
+      elem_(elementType),
       size_(size) {}
 
-const SemaTypePtr &ArrayType::elementType() const {
+SemaTypePtr ArrayType::elementType() const {
   return elem_;
 }
 
@@ -83,33 +65,12 @@ std::optional<std::size_t> ArrayType::size() const {
   return size_;
 }
 
-bool ArrayType::equals(const SemaType &other) const {
-  if (other.getKind() != TypeKind::ARRAY) {
-    return false;
-  }
-
-  const auto &rhs = static_cast<const ArrayType &>(other);
-  if (size_ != rhs.size_) {
-    return false;
-  }
-
-  if (elem_ == rhs.elem_) {
-    return true;
-  }
-
-  if (!elem_ || !rhs.elem_) {
-    return false;
-  }
-
-  return elem_->equals(*rhs.elem_);
-}
-
 FuncType::FuncType(SemaTypePtr returnType, std::vector<SemaTypePtr> params)
     : SemaType(TypeKind::FUNC),
-      ret_(std::move(returnType)),
+      ret_(returnType),
       params_(std::move(params)) {}
 
-const SemaTypePtr &FuncType::returnType() const {
+SemaTypePtr FuncType::returnType() const {
   return ret_;
 }
 
@@ -117,142 +78,120 @@ const std::vector<SemaTypePtr> &FuncType::params() const {
   return params_;
 }
 
-bool FuncType::equals(const SemaType &other) const {
-  if (other.getKind() != TypeKind::FUNC) {
-    return false;
-  }
-
-  const auto &rhs = static_cast<const FuncType &>(other);
-
-  if (ret_ != rhs.ret_) {
-    if (!ret_ || !rhs.ret_) {
-      return false;
-    }
-    if (!ret_->equals(*rhs.ret_)) {
-      return false;
-    }
-  }
-
-  if (params_.size() != rhs.params_.size()) {
-    return false;
-  }
-
-  for (std::size_t i = 0; i < params_.size(); ++i) {
-    const auto &lhsParam = params_[i];
-    const auto &rhsParam = rhs.params_[i];
-
-    if (lhsParam != rhsParam) {
-      if (!lhsParam || !rhsParam) {
-        return false;
-      }
-      if (!lhsParam->equals(*rhsParam)) {
-        return false;
-      }
-    }
-  }
-
-  return true;
-}
-
-ClassType::ClassType(const std::string &className)
+ClassType::ClassType(Ident className)
     : SemaType(TypeKind::CLS),
       className_(className) {}
 
 const std::string &ClassType::className() const {
-  return className_;
+  return spelling(className_);
 }
 
-bool ClassType::equals(const SemaType &other) const {
-  if (other.getKind() != TypeKind::CLS) {
-    return false;
-  }
-  const auto &rhs = static_cast<const ClassType &>(other);
-  return className_ == rhs.className_;
-}
-
-InstanceType::InstanceType(const std::string &className)
+InstanceType::InstanceType(Ident className)
     : SemaType(TypeKind::INST),
       className_(className) {}
 
 const std::string &InstanceType::className() const {
-  return className_;
+  return spelling(className_);
 }
 
-void InstanceType::setClassName(const std::string &name) {
-  className_ = name;
+void ArrayType::Profile(llvm::FoldingSetNodeID &id, SemaTypePtr elem, std::optional<std::size_t> size) {
+  id.AddPointer(elem);
+  id.AddBoolean(size.has_value());
+  id.AddInteger(size.value_or(0));
 }
 
-bool InstanceType::equals(const SemaType &other) const {
-  if (other.getKind() != TypeKind::INST) {
-    return false;
+void FuncType::Profile(llvm::FoldingSetNodeID &id, SemaTypePtr ret, const std::vector<SemaTypePtr> &params) {
+  id.AddPointer(ret);
+  id.AddInteger(params.size());
+  for (auto param: params) {
+    id.AddPointer(param);
   }
-  const auto &rhs = static_cast<const InstanceType &>(other);
-  return className_ == rhs.className_;
 }
 
-bool VoidType::equals(const SemaType &other) const {
-  return other.getKind() == TypeKind::VOID;
-}
+// ---------- TypeContext ----------
 
-bool typesEqual(const SemaTypePtr &a, const SemaTypePtr &b) {
-  if (a == b) {
-    return true;
+SemaTypePtr TypeContext::arrayType(SemaTypePtr elementType, std::optional<std::size_t> size) {
+  std::lock_guard<std::mutex> lock(mutex);
+  llvm::FoldingSetNodeID id;
+  ArrayType::Profile(id, elementType, size);
+  void *insertPos = nullptr;
+  if (auto *existing = arrays.FindNodeOrInsertPos(id, insertPos)) {
+    return existing;
   }
-  if (!a || !b) {
-    return false;
+  auto *type = own(std::make_unique<ArrayType>(elementType, size));
+  arrays.InsertNode(type, insertPos);
+  return type;
+}
+
+SemaTypePtr TypeContext::funcType(SemaTypePtr returnType, std::vector<SemaTypePtr> params) {
+  std::lock_guard<std::mutex> lock(mutex);
+  llvm::FoldingSetNodeID id;
+  FuncType::Profile(id, returnType, params);
+  void *insertPos = nullptr;
+  if (auto *existing = funcs.FindNodeOrInsertPos(id, insertPos)) {
+    return existing;
   }
-  return a->equals(*b);
+  auto *type = own(std::make_unique<FuncType>(returnType, std::move(params)));
+  funcs.InsertNode(type, insertPos);
+  return type;
 }
 
-namespace {
-  template<class T, class... Args>
-  SemaTypePtr makeType(Args &&...args) {
-    return std::make_shared<T>(std::forward<Args>(args)...);
+SemaTypePtr TypeContext::classType(Ident className) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &slot = classes[className];
+  if (!slot) {
+    slot = own(std::make_unique<ClassType>(className));
   }
-}// namespace
+  return slot;
+}
+
+SemaTypePtr TypeContext::instanceType(Ident className) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &slot = instances[className];
+  if (!slot) {
+    slot = own(std::make_unique<InstanceType>(className));
+  }
+  return slot;
+}
+
+// ---------- factories ----------
 
 SemaTypePtr makeIntType() {
-  static SemaTypePtr instance = makeType<IntType>();
-  return instance;
+  return TypeCtx::getInstance()->intType();
 }
 
 SemaTypePtr makeBoolType() {
-  static SemaTypePtr instance = makeType<BoolType>();
-  return instance;
+  return TypeCtx::getInstance()->boolType();
 }
 
 SemaTypePtr makeCharType() {
-  static SemaTypePtr instance = makeType<CharType>();
-  return instance;
+  return TypeCtx::getInstance()->charType();
 }
 
-SemaTypePtr makeStrType(std::size_t length) {
-  static SemaTypePtr instance = makeType<StrType>(length);
-  return instance;
+SemaTypePtr makeStrType() {
+  return TypeCtx::getInstance()->strType();
 }
 
 SemaTypePtr makeByteType() {
-  static SemaTypePtr instance = makeType<ByteType>();
-  return instance;
+  return TypeCtx::getInstance()->byteType();
 }
 
 SemaTypePtr makeVoidType() {
-  static SemaTypePtr instance = makeType<VoidType>();
-  return instance;
+  return TypeCtx::getInstance()->voidType();
 }
 
 SemaTypePtr makeArrayType(SemaTypePtr elementType, std::optional<std::size_t> size) {
-  return makeType<ArrayType>(std::move(elementType), size);
+  return TypeCtx::getInstance()->arrayType(elementType, size);
 }
 
 SemaTypePtr makeFuncType(SemaTypePtr returnType, std::vector<SemaTypePtr> params) {
-  return makeType<FuncType>(std::move(returnType), std::move(params));
+  return TypeCtx::getInstance()->funcType(returnType, std::move(params));
 }
 
-SemaTypePtr makeClassType(const std::string &className) {
-  return makeType<ClassType>(className);
+SemaTypePtr makeClassType(Ident className) {
+  return TypeCtx::getInstance()->classType(className);
 }
 
-SemaTypePtr makeInstanceType(const std::string &className) {
-  return makeType<InstanceType>(className);
+SemaTypePtr makeInstanceType(Ident className) {
+  return TypeCtx::getInstance()->instanceType(className);
 }
@@ -21,15 +21,19 @@ InsertResult SemanticCtx::declareSymbol(uptr<Symbol> sym, bool isRedeclared) {
   return result;
 }
 
+LookupResult SemanticCtx::lookup(Ident name) const {
+  return symbol_table.lookup(name);
+}
+
 LookupResult SemanticCtx::lookup(const llvm::StringRef name) const {
   return symbol_table.lookup(name);
 }
 
-LookupResult SemanticCtx::lookupLocalSymbol(const llvm::StringRef name) const {
-  return symbol_table.currentScope().lookupLocal(name);
+LookupResult SemanticCtx::lookupLocalSymbol(Ident name) const {
+  return symbol_table.lookupLocal(name);
 }
 
-bool SemanticCtx::replaceSymbol(const llvm::StringRef name, uptr<Symbol> newSymbol) {
+bool SemanticCtx::replaceSymbol(Ident name, uptr<Symbol> newSymbol) {
   return symbol_table.replaceSymbol(name, std::move(newSymbol));
 }
 
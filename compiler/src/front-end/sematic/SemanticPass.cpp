@@ -2,17 +2,18 @@
 #include "AST.hpp"
 #include "Diagnostics.hpp"
 #include "Operator.hpp"
+#include "PrintFormat.hpp"
 #include "SemaType.hpp"
 #include "SemanticCtx.hpp"
 #include "Symbol.hpp"
 #include "Types.hpp"
 #include <cstddef>
+#include <llvm-20/llvm/ADT/DenseSet.h>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
-#include <unordered_set>
 #include <utility>
 void SemanticPass::visit(Type &node) {
   resolveType(node);
@@ -25,37 +26,31 @@ void SemanticPass::visit(FuncParameterType &node) {
 
 void SemanticPass::visit(Program &node) {
   // program entry point
-  auto &defs = node.getDefs();
   //  pass 1: visit all definitions
-  for (const auto &d: defs) {
-    d->accept(*this);
+  for (const auto &d: node.getDefs()) {
+    analyzeDefinition(d);
   }
   // locate main function
-  VerifyEntryPoint(defs);
+  VerifyEntryPoint(node);
 }
 void SemanticPass::visit(Header &node) {}
 void SemanticPass::visit(ClassDecl &node) {
-  auto cls_name = node.identifier();
-  auto &fields = node.fieldList();
-  auto &methods = node.methodList();
-  const SemaTypePtr class_type = makeClassType(cls_name);
+  const string &cls_name = node.identifier();
+  auto fields = node.fieldList();
+  auto methods = node.methodList();
+  const SemaTypePtr class_type = makeClassType(node.ident());
 
-  LookupResult existing = semanticCtx.lookup(cls_name);
+  LookupResult existing = semanticCtx.lookup(node.ident());
   Symbol *symbol = existing.symbol;
   if (existing.found()) {
     if (symbol->isDefined()) {
-      Diag::getInstance()->report(
-          Diagnostics::Severity::Error,
-          Diagnostics::Phase::SemanticAnalysis,
-          node.loc,
-          "class '" + cls_name + "' already defined"
-      );
+      Diag::getInstance()->reportRedefinition(cls_name, node.loc, symbol->getLocation());
       throw std::runtime_error("semantic analysis failed");
     }
   }
 
   // create class symbol
-  auto class_sym = std::make_unique<ClassSymbol>(cls_name, class_type, node.loc);
+  auto class_sym = std::make_unique<ClassSymbol>(node.ident(), class_type, node.loc);
 
 
   // create Class
@@ -63,7 +58,7 @@ void SemanticPass::visit(ClassDecl &node) {
   for (auto &member: fields) {
     if (member) {
       member->setIsField(true);
-      member->accept(*this);
+      walk(member);
     }
     auto &varSyms = member->symbols();
     // Convert VarSymbols to FieldSymbols for claHHss members
@@ -72,7 +67,7 @@ void SemanticPass::visit(ClassDecl &node) {
       if (var_sym) {
         // Create a FieldSymbol with the same properties
         auto field_sym = std::make_unique<FieldSymbol>(
-            var_sym->getName(),
+            var_sym->getIdent(),
             var_sym->getType(),
             var_sym->getLocation()
         );
@@ -80,7 +75,7 @@ void SemanticPass::visit(ClassDecl &node) {
         FieldSymbol *raw_field = field_sym.get();
         member->setSymbol(it - varSyms.begin(), raw_field);
         // Replace the VarSymbol with FieldSymbol in symbol table
-        semanticCtx.replaceSymbol(var_sym->getName(), std::move(field_sym));
+        semanticCtx.replaceSymbol(var_sym->getIdent(), std::move(field_sym));
         class_sym->addField(raw_field);
       }
     }
@@ -89,17 +84,17 @@ void SemanticPass::visit(ClassDecl &node) {
   for (auto &method: methods) {
     if (method) {
       method->setIsMethod(true);
-      method->accept(*this);
+      walk(method);
     }
     auto *func_header = method->funcHeader();
     if (func_header && func_header->symbol()) {
       auto *func_sym = func_header->symbol();
-      if (func_sym->getName() == "constructor") {
+      if (func_sym->getIdent() == ctorIdent) {
         hasConstructor = true;
       }
       // Create a MethodSymbol with the same properties
       auto method_sym = std::make_unique<MethodSymbol>(
-          func_sym->getName(),
+          func_sym->getIdent(),
           func_sym->getType(),
           func_sym->isProcedure(),
           func_sym->getLocation()
@@ -110,6 +105,8 @@ void SemanticPass::visit(ClassDecl &node) {
         method_sym->addParam(param);
       }
 
+      method_sym->setSlotCount(func_sym->slotCount());
+      method_sym->setFrameOwner(func_sym->frameOwner());
       method_sym->setDefiningClass(class_sym.get());
       if (func_sym->isDefined()) {
         method_sym->markDefined();
@@ -117,7 +114,7 @@ void SemanticPass::visit(ClassDecl &node) {
 
       MethodSymbol *raw_method = method_sym.get();
       // Replace the FuncSymbol with MethodSymbol in symbol table
-      semanticCtx.replaceSymbol(func_sym->getName(), std::move(method_sym));
+      semanticCtx.replaceSymbol(func_sym->getIdent(), std::move(method_sym));
       // Update the AST node to point to the new MethodSymbol
       func_header->setSymbol(raw_method);
       class_sym->addMethod(raw_method);
@@ -155,7 +152,7 @@ void SemanticPass::visit(FuncDecl &node) {
   }
 
   // Check for existing declaration
-  auto existing = semanticCtx.lookupLocalSymbol(name);
+  auto existing = semanticCtx.lookupLocalSymbol(header->ident());
   Symbol *symbol = existing.symbol;
   if (existing.found()) {
     if (!signaturesMatch(isProcedure, returnType, params, symbol)) {
@@ -194,7 +191,7 @@ void SemanticPass::visit(FuncDecl &node) {
   }
   auto sig = makeFuncType(returnType, std::move(paramTypes));
   // TODO: now isVariadic is false by default
-  auto func = std::make_unique<FuncSymbol>(name, std::move(sig), isProcedure, false, header->loc);
+  auto func = std::make_unique<FuncSymbol>(header->ident(), std::move(sig), isProcedure, false, header->loc);
 
   // Create temporary scope for parameters (orphaned after FuncDecl)
   semanticCtx.beginScope();
@@ -217,9 +214,14 @@ void SemanticPass::visit(FuncDecl &node) {
   header->setSymbol(raw);
 }
 void SemanticPass::visit(FuncDef &node) {
+  if (FuncSymbol *fsym = declareFunction(node)) {
+    checkFunctionBody(node, fsym);
+  }
+}
+FuncSymbol *SemanticPass::declareFunction(FuncDef &node) {
   auto *header = node.funcHeader();
   if (!header) {
-    return;
+    return nullptr;
   }
 
   // Collect header info directly from AST
@@ -231,11 +233,11 @@ void SemanticPass::visit(FuncDef &node) {
   // Collect parameters
   std::vector<ParamInfo> params;
   if (!collectParams(*header, params)) {
-    return;// errors already reported
+    return nullptr;// errors already reported
   }
 
   // Check for existing declaration
-  auto existing = semanticCtx.lookupLocalSymbol(name);
+  auto existing = semanticCtx.lookupLocalSymbol(header->ident());
   Symbol *symbol = existing.symbol;
   bool wasForwardDeclared = false;
 
@@ -250,12 +252,7 @@ void SemanticPass::visit(FuncDef &node) {
       throw std::runtime_error("semantic analysis failed");
     }
     if (symbol->isDefined()) {
-      Diag::getInstance()->report(
-          Diagnostics::Severity::Error,
-          Diagnostics::Phase::SemanticAnalysis,
-          node.loc,
-          "redefinition of '" + name + "'"
-      );
+      Diag::getInstance()->reportRedefinition(name, header->loc, symbol->getLocation());
       throw std::runtime_error("semantic analysis failed");
     }
     wasForwardDeclared = true;
@@ -266,6 +263,8 @@ void SemanticPass::visit(FuncDef &node) {
   if (wasForwardDeclared) {
     // Use existing symbol from forward declaration
     fsym = static_cast<FuncSymbol *>(symbol);
+    // a later redefinition is pointed at this body, not at the declaration
+    fsym->setLocation(header->loc);
     // Clear old params - they were orphaned when the FuncDecl's scope closed
     fsym->clearParams();
   } else {
@@ -277,7 +276,7 @@ void SemanticPass::visit(FuncDef &node) {
     }
     auto sig = makeFuncType(returnType, std::move(paramTypes));
     // TODO: now isVariadic is false by default
-    auto func = std::make_unique<FuncSymbol>(name, std::move(sig), isProcedure, false, header->loc);
+    auto func = std::make_unique<FuncSymbol>(header->ident(), std::move(sig), isProcedure, false, header->loc);
     fsym = func.get();
     semanticCtx.declareSymbol(std::move(func));
   }
@@ -285,16 +284,9 @@ void SemanticPass::visit(FuncDef &node) {
   fsym->setDefiningFunc(semanticCtx.currentFunction() ? semanticCtx.currentFunction()->symbol : nullptr);
   header->setSymbol(fsym);
 
+  // Parameters are declared in a scope of their own here, checkFunctionBody
+  // binds the same symbols again around the body
   semanticCtx.beginScope();
-
-  // Create function frame
-  sptr<SemanticCtx::FunctionFrame> frame = std::make_shared<SemanticCtx::FunctionFrame>();
-  frame->symbol = fsym;
-  frame->is_procedure = isProcedure;
-  frame->return_type = returnType;
-  semanticCtx.enterFunction(frame);
-
-  // Declare parameters in the new scope
   for (const auto &paramInfo: params) {
     auto sym = std::make_unique<ParamSymbol>(paramInfo.name, paramInfo.type, paramInfo.passMode, paramInfo.loc);
     sym->setDefiningFunc(fsym);
@@ -303,14 +295,34 @@ void SemanticPass::visit(FuncDef &node) {
       fsym->addParam(static_cast<ParamSymbol *>(result.symbol));
     }
   }
+  semanticCtx.endScope();
+  // defined as soon as the signature is known: a later definition of the same
+  // name is a redefinition even while this body is still being checked
+  fsym->markDefined();
+  return fsym;
+}
+void SemanticPass::checkFunctionBody(FuncDef &node, FuncSymbol *fsym) {
+  semanticCtx.beginScope();
+
+  // Create function frame
+  sptr<SemanticCtx::FunctionFrame> frame = std::make_shared<SemanticCtx::FunctionFrame>();
+  frame->symbol = fsym;
+  frame->is_procedure = fsym->isProcedure();
+  frame->return_type = llvm::cast<FuncType>(fsym->getType())->returnType();
+  semanticCtx.enterFunction(frame);
+
+  for (auto *param: fsym->getParams()) {
+    param->setSlot(frame->slots++);
+    semanticCtx.bindSymbol(param);
+  }
 
   if (auto *body = node.funcBody()) {
-    body->accept(*this);
+    walk(body);
   }
 
+  fsym->setSlotCount(frame->slots);
   semanticCtx.leaveFunction();
   semanticCtx.endScope();
-  fsym->markDefined();
 }
 void SemanticPass::visit(VarDef &node) {
   node.symbols().clear();
@@ -323,22 +335,19 @@ void SemanticPass::visit(VarDef &node) {
     return;
   }
   // check if var def has initialization and type match
-  if (auto &init = node.initExpr(); init.has_value()) {
-    Expr *rawptr = init->get();
-    if (rawptr) {
-      rawptr->accept(*this);
-      auto init_type = rawptr->type();
-      if (!typesEqual(resolved_type, init_type)) {
-        Diag::getInstance()->report(
-            Diagnostics::Severity::Error,
-            Diagnostics::Phase::SemanticAnalysis,
-            node.loc,
-            "variable initialization type mismatch: declared type '" +
-                typeToString(resolved_type) +
-                "', but got '" + typeToString(init_type) + "'"
-        );
-        throw std::runtime_error("semantic analysis failed");
-      }
+  if (Expr *rawptr = node.initExpr()) {
+    walk(rawptr);
+    auto init_type = rawptr->type();
+    if (!typesEqual(resolved_type, init_type)) {
+      Diag::getInstance()->report(
+          Diagnostics::Severity::Error,
+          Diagnostics::Phase::SemanticAnalysis,
+          node.loc,
+          "variable initialization type mismatch: declared type '" +
+              typeToString(resolved_type) +
+              "', but got '" + typeToString(init_type) + "'"
+      );
+      throw std::runtime_error("semantic analysis failed");
     }
   }
   for (const auto &id: node.identifiers()) {
@@ -347,6 +356,7 @@ void SemanticPass::visit(VarDef &node) {
     // 将变量符号加载到当前函数帧中
     if (auto frame = semanticCtx.currentFunction()) {
       raw->setDefiningFunc(static_cast<FuncSymbol *>(frame->symbol));
+      raw->setSlot(frame->slots++);
     }
     semanticCtx.declareSymbol(std::move(sym));
     node.symbols().push_back(raw);
@@ -354,50 +364,50 @@ void SemanticPass::visit(VarDef &node) {
 }
 void SemanticPass::visit(FuncParameterDecl &node) {
   if (auto *t = node.parameterType()) {
-    t->accept(*this);
+    walk(t);
   }
 }
 void SemanticPass::visit(Block &node) {
   for (auto &stmt: node.statementsList()) {
     if (stmt) {
-      stmt->accept(*this);
+      walk(stmt);
     }
   }
 }
 
-void SemanticPass::visit(SkipStmt &node) { std::cout << "SkipStmt\n"; }
-void SemanticPass::visit(ExitStmt &node) { std::cout << "ExitStmt\n"; }
+void SemanticPass::visit(SkipStmt &node) {}
+void SemanticPass::visit(ExitStmt &node) {}
 void SemanticPass::visit(IfStmt &node) {
   if (auto *cond = node.conditionExpr()) {
-    cond->accept(*this);
+    walk(cond);
   }
   if (auto *thenBranch = node.thenBlock()) {
-    thenBranch->accept(*this);
+    walk(thenBranch);
   }
   for (auto &elif: node.elifs()) {
     if (elif.first) {
-      elif.first->accept(*this);
+      walk(elif.first);
     }
     if (elif.second) {
-      elif.second->accept(*this);
+      walk(elif.second);
     }
   }
   if (auto *elseBranch = node.elseBlock()) {
-    elseBranch->accept(*this);
+    walk(elseBranch);
   }
 }
 void SemanticPass::visit(LoopStmt &node) {
   if (auto *condition = node.conditionExpr()) {
-    condition->accept(*this);
+    walk(condition);
   }
   if (auto *body = node.loopBody()) {
-    body->accept(*this);
+    walk(body);
   }
 }
 void SemanticPass::visit(ReturnStmt &node) {
   auto *value = node.returnValue();
   if (value) {
-    value->accept(*this);
+    walk(value);
   }
 
   auto frame = semanticCtx.currentFunction();
@@ -418,10 +428,10 @@ void SemanticPass::visit(AssignStmt &node) {
   auto *lhs = node.left();
   auto *rhs = node.right();
   if (lhs) {
-    lhs->accept(*this);
+    walk(lhs);
   }
   if (rhs) {
-    rhs->accept(*this);
+    walk(rhs);
   }
   auto leftType = lhs ? lhs->type() : SemaTypePtr{};
   auto rightType = rhs ? rhs->type() : SemaTypePtr{};
@@ -461,11 +471,11 @@ void SemanticPass::visit(AssignStmt &node) {
     throw std::runtime_error("semantic analysis failed");
   }
 }
-void SemanticPass::visit(BreakStmt &node) { std::cout << "BreakStmt\n"; }
-void SemanticPass::visit(ContinueStmt &node) { std::cout << "ContinueStmt\n"; }
+void SemanticPass::visit(BreakStmt &node) {}
+void SemanticPass::visit(ContinueStmt &node) {}
 void SemanticPass::visit(ProcCall &node) {
   // main function entry
-  auto lookup = semanticCtx.lookup(node.identifier());
+  auto lookup = semanticCtx.lookup(node.ident());
   Symbol *symbol = lookup.symbol;
   auto *funcSym = (symbol && symbol->getKind() == Symbol::SymKind::FUNC)
                       ? static_cast<FuncSymbol *>(symbol)
@@ -483,16 +493,19 @@ void SemanticPass::visit(ProcCall &node) {
   node.setFuncSymbol(funcSym);
   const auto &params = funcSym->getParams();
   checkArguments(node.arguments(), params, node.identifier(), node.loc, funcSym->isVariadic()) ?: throw std::runtime_error("semantic analysis failed");
+  if (funcSym->isBuiltin() && funcSym->getIdent() == printIdent) {
+    checkFormat(node.arguments(), node.loc);
+  }
 }
 
 void SemanticPass::visit(BinaryExpr &node) {
   auto *lhs = node.leftExpr();
   auto *rhs = node.rightExpr();
   if (lhs) {
-    lhs->accept(*this);
+    walk(lhs);
   }
   if (rhs) {
-    rhs->accept(*this);
+    walk(rhs);
   }
   auto leftType = lhs ? lhs->type() : SemaTypePtr{};
   auto rightType = rhs ? rhs->type() : SemaTypePtr{};
@@ -565,7 +578,7 @@ void SemanticPass::visit(BinaryExpr &node) {
 void SemanticPass::visit(UnaryExpr &node) {
   auto *operand = node.operandExpr();
   if (operand) {
-    operand->accept(*this);
+    walk(operand);
   }
   auto operandType = operand ? operand->type() : SemaTypePtr{};
   switch (node.opKind()) {
@@ -601,14 +614,14 @@ void SemanticPass::visit(UnaryExpr &node) {
 void SemanticPass::visit(LValueExpr &node) {
   auto *value = node.lvalue();
   if (value) {
-    value->accept(*this);
+    walk(value);
   }
   node.setType(value ? value->type() : SemaTypePtr{});
   node.setLValue(true);
   node.setAssignable(value ? value->isAssignable() : false);
 }
 void SemanticPass::visit(IdLVal &node) {
-  LookupResult lookup = semanticCtx.lookup(node.identifier());
+  LookupResult lookup = semanticCtx.lookup(node.ident());
   Symbol *symbol = lookup.symbol;
 
   // If not found in current scope, check if it's in a method and look in class members
@@ -620,14 +633,11 @@ void SemanticPass::visit(IdLVal &node) {
 
       if (classSym) {
         // Search in class fields
-        const auto &fields = classSym->getFields();
-        for (auto *field: fields) {
-          if (field->getName() == node.identifier()) {
-            node.setSymbol(field);
-            node.setType(field->getType());
-            node.setAssignable(true);
-            return;
-          }
+        if (auto *field = classSym->findField(node.ident())) {
+          node.setSymbol(field);
+          node.setType(field->getType());
+          node.setAssignable(true);
+          return;
         }
       }
     }
@@ -643,6 +653,20 @@ void SemanticPass::visit(IdLVal &node) {
     node.setSymbol(nullptr);
     throw std::runtime_error("semantic analysis failed");
   }
+  // locals live in the frame of their own function, a nested function has no
+  // way to reach the frame of the one around it
+  auto frame = semanticCtx.currentFunction();
+  if (symbol->hasSlot() && frame && symbol->definingFunc() != frame->symbol) {
+    Diag::getInstance()->report(
+        Diagnostics::Severity::Error,
+        Diagnostics::Phase::SemanticAnalysis,
+        node.loc,
+        "'" + node.identifier() + "' is a local of the enclosing function '" +
+            symbol->definingFunc()->getName() + "' and cannot be used in a nested function"
+    );
+    node.setSymbol(nullptr);
+    throw std::runtime_error("semantic analysis failed");
+  }
   node.setSymbol(symbol);
   node.setType(symbol->getType());
   node.setAssignable(true);
@@ -651,10 +675,10 @@ void SemanticPass::visit(IndexLVal &node) {
   auto *base = node.baseExpr();
   auto *index = node.indexExpr();
   if (base) {
-    base->accept(*this);
+    walk(base);
   }
   if (index) {
-    index->accept(*this);
+    walk(index);
   }
   auto baseType = base ? base->type() : SemaTypePtr{};
   if (!isArrayType(baseType)) {
@@ -677,14 +701,14 @@ void SemanticPass::visit(IndexLVal &node) {
     );
     throw std::runtime_error("semantic analysis failed");
   }
-  node.setType(static_cast<const ArrayType *>(baseType.get())->elementType());
+  node.setType(static_cast<const ArrayType *>(baseType)->elementType());
   node.setAssignable(base ? base->isAssignable() : true);
 }
 
 void SemanticPass::visit(MemberAccessLVal &node) {
   auto *obj = node.object();
   if (obj) {
-    obj->accept(*this);
+    walk(obj);
   }
 
   auto objType = obj ? obj->type() : SemaTypePtr{};
@@ -703,8 +727,8 @@ void SemanticPass::visit(MemberAccessLVal &node) {
   }
 
   // Get the class name and look up the class symbol
-  auto instType = static_cast<const InstanceType *>(objType.get());
-  auto classLookup = semanticCtx.lookup(instType->className());
+  auto instType = static_cast<const InstanceType *>(objType);
+  auto classLookup = semanticCtx.lookup(instType->classIdent());
 
   if (!classLookup.found() || classLookup.symbol->getKind() != Symbol::SymKind::CLASS) {
     Diag::getInstance()->report(
@@ -721,14 +745,11 @@ void SemanticPass::visit(MemberAccessLVal &node) {
   auto *classSym = static_cast<ClassSymbol *>(classLookup.symbol);
 
   // Look up the member in the class
-  const auto &fields = classSym->getFields();
-  for (auto *field: fields) {
-    if (field->getName() == node.memberName()) {
-      node.setMemberSymbol(field);
-      node.setType(field->getType());
-      node.setAssignable(true);
-      return;
-    }
+  if (auto *field = classSym->findField(node.memberIdent())) {
+    node.setMemberSymbol(field);
+    node.setType(field->getType());
+    node.setAssignable(true);
+    return;
   }
 
   Diag::getInstance()->report(
@@ -745,21 +766,20 @@ void SemanticPass::visit(MemberAccessLVal &node) {
 void SemanticPass::visit(StringLiteralLVal &node) {
   // string is equivalent to array of chars in this Sematic analysis
   // str == char[]
-  auto len = static_cast<std::size_t>(node.literal().size() + 1);
-  node.setType(makeStrType(len - 2));// exclude quotes
+  node.setType(makeStrType());
   node.setAssignable(false);
 }
 void SemanticPass::visit(ParenExpr &node) {
   auto *inner = node.innerExpr();
   if (inner) {
-    inner->accept(*this);
+    walk(inner);
   }
   node.setType(inner ? inner->type() : SemaTypePtr{});
   node.setLValue(inner && inner->isLValue());
   node.setAssignable(inner && inner->isAssignable());
 }
 void SemanticPass::visit(FuncCall &node) {
-  LookupResult lookup = semanticCtx.lookup(node.identifier());
+  LookupResult lookup = semanticCtx.lookup(node.ident());
   Symbol *symbol = lookup.symbol;
   auto *funcSym = (lookup.found() && symbol->getKind() == Symbol::SymKind::FUNC)
                       ? static_cast<FuncSymbol *>(symbol)
@@ -778,7 +798,7 @@ void SemanticPass::visit(FuncCall &node) {
   node.setFuncSymbol(funcSym);
   const auto &params = funcSym->getParams();
   checkArguments(node.arguments(), params, node.identifier(), node.loc, funcSym->isVariadic());
-  const auto *sig = static_cast<const FuncType *>(funcSym->getType().get());
+  const auto *sig = static_cast<const FuncType *>(funcSym->getType());
   node.setType(sig ? sig->returnType() : SemaTypePtr{});
   node.setLValue(false);
   node.setAssignable(false);
@@ -787,7 +807,7 @@ void SemanticPass::visit(FuncCall &node) {
 void SemanticPass::visit(MemberAccessExpr &node) {
   auto *obj = node.object();
   if (obj) {
-    obj->accept(*this);
+    walk(obj);
   }
 
   auto objType = obj ? obj->type() : SemaTypePtr{};
@@ -806,8 +826,8 @@ void SemanticPass::visit(MemberAccessExpr &node) {
   }
 
   // Get the class name and look up the class symbol
-  auto instType = static_cast<const InstanceType *>(objType.get());
-  auto classLookup = semanticCtx.lookup(instType->className());
+  auto instType = static_cast<const InstanceType *>(objType);
+  auto classLookup = semanticCtx.lookup(instType->classIdent());
 
   if (!classLookup.found() || classLookup.symbol->getKind() != Symbol::SymKind::CLASS) {
     Diag::getInstance()->report(
@@ -824,15 +844,12 @@ void SemanticPass::visit(MemberAccessExpr &node) {
   auto *classSym = static_cast<ClassSymbol *>(classLookup.symbol);
 
   // Look up the member (field or method) in the class
-  const auto &fields = classSym->getFields();
-  for (auto *field: fields) {
-    if (field->getName() == node.memberName()) {
-      node.setMemberSymbol(field);
-      node.setType(field->getType());
-      node.setLValue(true);
-      node.setAssignable(true);
-      return;
-    }
+  if (auto *field = classSym->findField(node.memberIdent())) {
+    node.setMemberSymbol(field);
+    node.setType(field->getType());
+    node.setLValue(true);
+    node.setAssignable(true);
+    return;
   }
 
   Diag::getInstance()->report(
@@ -849,7 +866,7 @@ void SemanticPass::visit(MemberAccessExpr &node) {
 void SemanticPass::visit(MethodCall &node) {
   auto *obj = node.object();
   if (obj) {
-    obj->accept(*this);
+    walk(obj);
   }
 
   auto objType = obj ? obj->type() : SemaTypePtr{};
@@ -867,8 +884,8 @@ void SemanticPass::visit(MethodCall &node) {
   }
 
   // Get the class name and look up the class symbol
-  auto instType = static_cast<const InstanceType *>(objType.get());
-  auto classLookup = semanticCtx.lookup(instType->className());
+  auto instType = static_cast<const InstanceType *>(objType);
+  auto classLookup = semanticCtx.lookup(instType->classIdent());
 
   if (!classLookup.found() || classLookup.symbol->getKind() != Symbol::SymKind::CLASS) {
     Diag::getInstance()->report(
@@ -884,14 +901,7 @@ void SemanticPass::visit(MethodCall &node) {
   auto *classSym = static_cast<ClassSymbol *>(classLookup.symbol);
 
   // Look up the method in the class
-  const auto &methods = classSym->getMethods();
-  MethodSymbol *methodSym = nullptr;
-  for (auto *method: methods) {
-    if (method->getName() == node.methodName()) {
-      methodSym = method;
-      break;
-    }
-  }
+  MethodSymbol *methodSym = classSym->findMethod(node.methodIdent());
 
   if (!methodSym) {
     Diag::getInstance()->report(
@@ -907,17 +917,17 @@ void SemanticPass::visit(MethodCall &node) {
   const auto &params = methodSym->getParams();
   checkArguments(node.arguments(), params, node.methodName(), node.loc, methodSym->isVariadic());
 
-  const auto *sig = static_cast<const FuncType *>(methodSym->getType().get());
+  const auto *sig = static_cast<const FuncType *>(methodSym->getType());
   node.setType(sig ? sig->returnType() : SemaTypePtr{});
   node.setLValue(false);
   node.setAssignable(false);
 }
 
 void SemanticPass::visit(NewExpr &node) {
-  string clsName = node.getCotorName();
-  auto &args = node.getArgs();
+  const string &clsName = node.getCotorName();
+  auto args = node.getArgs();
 
-  LookupResult clsRes = semanticCtx.lookup(clsName);
+  LookupResult clsRes = semanticCtx.lookup(node.classIdent());
   if (!clsRes.found()) {
     Diag::getInstance()->report(
         Diagnostics::Severity::Error,
@@ -928,16 +938,13 @@ void SemanticPass::visit(NewExpr &node) {
     throw std::runtime_error("semantic analysis failed");
   }
   auto sym = clsRes.symbol;
-  if (auto clsSym = dynamic_cast<ClassSymbol *>(sym)) {
-    for (auto *mSym: clsSym->getMethods()) {
-      if (mSym->getName() == "constructor") {
-        auto &params = mSym->getParams();
-        checkArguments(args, params, "constructor of " + clsName, node.loc, false);
-        break;
-      }
+  if (auto clsSym = llvm::dyn_cast<ClassSymbol>(sym)) {
+    if (auto *mSym = clsSym->findMethod(ctorIdent)) {
+      auto &params = mSym->getParams();
+      checkArguments(args, params, "constructor of " + clsName, node.loc, false);
     }
   }
-  SemaTypePtr instTy = makeInstanceType(clsName);
+  SemaTypePtr instTy = makeInstanceType(node.classIdent());
   node.setType(instTy);
 }
 
@@ -950,7 +957,7 @@ void SemanticPass::visit(ArrayExpr &node) {
   }
 
   for (const auto &e: elems) {
-    e->accept(*this);
+    walk(e);
   }
   elemType = elems[0]->type();
   for (size_t i = 1; i < elems.size(); ++i) {
@@ -985,7 +992,7 @@ void SemanticPass::visit(FalseConst &node) {
 
 void SemanticPass::visit(ExprCond &node) {
   if (auto *expr = node.expression()) {
-    expr->accept(*this);
+    walk(expr);
   }
   // Dana does not allow bare expressions as conditions - except boolean literals;
   // conditions must be relational (=, <>, <, >, <=, >=) or logical (and, or, not)
@@ -999,33 +1006,55 @@ void SemanticPass::visit(ExprCond &node) {
   node.setType(makeBoolType());
 }
 
-void SemanticPass::VerifyEntryPoint(const vec<uptr<ASTNode>> &defs) {
-  FuncDef *mainFunc = nullptr;
-  for (const auto &d: defs) {
-    if (auto *funcDef = dynamic_cast<FuncDef *>(d.get())) {
-      auto *header = funcDef->funcHeader();
-      if (header && header->identifier() == "main") {
-        mainFunc = funcDef;
-        break;
-      }
-    }
+void SemanticPass::analyzeDefinition(ASTNode *def) {
+  const bool entry = noteEntryPoint(def);
+  walk(def);
+  if (entry) {
+    checkEntryPoint(*llvm::cast<FuncDef>(def));
   }
-  if (!mainFunc) {
-    Diag::getInstance()->report(
-        Diagnostics::Severity::Error,
-        Diagnostics::Phase::SemanticAnalysis,
-        mainFunc->loc,
-        "No 'main' function defined."
-    );
-    throw std::runtime_error("semantic analysis failed");
+}
+
+FuncDef *SemanticPass::declareDefinition(ASTNode *def) {
+  const bool entry = noteEntryPoint(def);
+  auto *funcDef = llvm::dyn_cast<FuncDef>(def);
+  if (!funcDef) {
+    walk(def);
+    return nullptr;
+  }
+  FuncDef *unchecked = declareFunction(*funcDef) ? funcDef : nullptr;
+  if (entry) {
+    checkEntryPoint(*funcDef);
+  }
+  return unchecked;
+}
+
+void SemanticPass::checkBody(FuncDef &def) {
+  checkFunctionBody(def, def.funcHeader()->symbol());
+}
+
+bool SemanticPass::noteEntryPoint(ASTNode *def) {
+  // main is marked before its body is checked, passes fused behind this one
+  // look at it as soon as the definition is done
+  if (auto *funcDef = llvm::dyn_cast<FuncDef>(def); funcDef && !hasEntryPoint) {
+    auto *header = funcDef->funcHeader();
+    if (header && header->ident() == mainIdent) {
+      funcDef->setEntrypoint(true);
+      hasEntryPoint = true;
+      return true;
+    }
   }
-  mainFunc->setEntrypoint(true);
-  auto *header = mainFunc->funcHeader();
+  return false;
+}
+
+// checked while main's definition is still around, it may be gone by the
+// time the whole program is
+void SemanticPass::checkEntryPoint(FuncDef &mainFunc) {
+  auto *header = mainFunc.funcHeader();
   if (!header) {
     Diag::getInstance()->report(
         Diagnostics::Severity::Error,
         Diagnostics::Phase::SemanticAnalysis,
-        mainFunc->loc,
+        mainFunc.loc,
         "'main' function has no header."
     );
     throw std::runtime_error("semantic analysis failed");
@@ -1035,19 +1064,31 @@ void SemanticPass::VerifyEntryPoint(const vec<uptr<ASTNode>> &defs) {
     Diag::getInstance()->report(
         Diagnostics::Severity::Error,
         Diagnostics::Phase::SemanticAnalysis,
-        mainFunc->loc,
+        mainFunc.loc,
         "'main' function has no associated symbol."
     );
     throw std::runtime_error("semantic analysis failed");
   }
   // if (!mainSymbol->isProcedure()) {
-  //     semanticCtx.getDiagnostics().report(Diagnostics::Severity::Error, Diagnostics::Phase::SemanticAnalysis, mainFunc->loc, "'main' function must be a procedure with no return type.");
+  //     semanticCtx.getDiagnostics().report(Diagnostics::Severity::Error, Diagnostics::Phase::SemanticAnalysis, mainFunc.loc, "'main' function must be a procedure with no return type.");
   // }
   // if (!mainSymbol->getParams().empty()) {
-  //     semanticCtx.getDiagnostics().report(Diagnostics::Severity::Error, Diagnostics::Phase::SemanticAnalysis, mainFunc->loc, "'main' function must not have parameters.");
+  //     semanticCtx.getDiagnostics().report(Diagnostics::Severity::Error, Diagnostics::Phase::SemanticAnalysis, mainFunc.loc, "'main' function must not have parameters.");
   // }
 }
 
+void SemanticPass::VerifyEntryPoint(const Program &program) {
+  if (!hasEntryPoint) {
+    Diag::getInstance()->report(
+        Diagnostics::Severity::Error,
+        Diagnostics::Phase::SemanticAnalysis,
+        program.loc,
+        "No 'main' function defined."
+    );
+    throw std::runtime_error("semantic analysis failed");
+  }
+}
+
 // Type resolution helper
 bool SemanticPass::arrayTypesCompatible(const ArrayType *actual, const ArrayType *expected) {
   if (!actual || !expected) return false;
@@ -1064,7 +1105,7 @@ bool SemanticPass::arrayTypesCompatible(const ArrayType *actual, const ArrayType
   // If the parameter is unsized, any actual size is acceptable
   return typesCompatible(actual->elementType(), expected->elementType());
 }
-bool SemanticPass::typesCompatible(const SemaTypePtr &actual, const SemaTypePtr &expected) {
+bool SemanticPass::typesCompatible(SemaTypePtr actual, SemaTypePtr expected) {
   if (actual == expected) return true;
   if (!actual || !expected) return false;
 
@@ -1073,8 +1114,8 @@ bool SemanticPass::typesCompatible(const SemaTypePtr &actual, const SemaTypePtr
       return false;
     }
     return arrayTypesCompatible(
-        static_cast<const ArrayType *>(actual.get()),
-        static_cast<const ArrayType *>(expected.get())
+        static_cast<const ArrayType *>(actual),
+        static_cast<const ArrayType *>(expected)
     );
   }
 
@@ -1145,7 +1186,7 @@ SemaTypePtr SemanticPass::resolveType(const Type &node, bool allowUnsizedFirst)
   auto base_type = scalarType(node.data_type());
   auto array_type = buildArrayType(node.loc, base_type, node.dimensions(), allowUnsizedFirst);
   if (!array_type && node.data_type() == DataType::DataType::MAY_INSTANCE) {
-    return makeInstanceType(node.getName().value());
+    return makeInstanceType(node.typeName());
   }
   return array_type;
 }
@@ -1163,7 +1204,7 @@ SemaTypePtr SemanticPass::resolveParamType(const FuncParameterType &node, Symbol
   }
   return resolvedType;
 }
-std::string SemanticPass::typeToString(const SemaTypePtr &type) {
+std::string SemanticPass::typeToString(SemaTypePtr type) {
   if (!type) {
     return "<invalid type>";
   }
@@ -1179,7 +1220,7 @@ std::string SemanticPass::typeToString(const SemaTypePtr &type) {
     case SemaType::TypeKind::STR:
       return "string";
     case SemaType::TypeKind::ARRAY: {
-      const ArrayType *arrType = static_cast<const ArrayType *>(type.get());
+      const ArrayType *arrType = static_cast<const ArrayType *>(type);
       std::ostringstream oss;
       oss << typeToString(arrType->elementType()) << '[';
       if (arrType->size()) {
@@ -1189,7 +1230,7 @@ std::string SemanticPass::typeToString(const SemaTypePtr &type) {
       return oss.str();
     }
     case SemaType::TypeKind::INST: {
-      const InstanceType *instType = static_cast<const InstanceType *>(type.get());
+      const InstanceType *instType = static_cast<const InstanceType *>(type);
       return "instance of " + instType->className();
     }
     case SemaType::TypeKind::FUNC:
@@ -1203,7 +1244,7 @@ std::string SemanticPass::typeToString(const SemaTypePtr &type) {
 
 // Semantic analysis helpers
 bool SemanticPass::collectParams(const Header &header, std::vector<ParamInfo> &params) {
-  std::unordered_set<string> seen;
+  llvm::SmallDenseSet<Ident, 8> seen;
   const string &name = header.identifier();
   for (const auto &param: header.parameters()) {
     if (!param) {
@@ -1231,7 +1272,7 @@ bool SemanticPass::collectParams(const Header &header, std::vector<ParamInfo> &p
             Diagnostics::Severity::Error,
             Diagnostics::Phase::SemanticAnalysis,
             param->loc,
-            "Duplicate parameter name '" + param_name + "' in function '" + name + "'."
+            "Duplicate parameter name '" + spelling(param_name) + "' in function '" + name + "'."
         );
         throw std::runtime_error("semantic analysis failed");
       }
@@ -1245,7 +1286,7 @@ bool SemanticPass::collectParams(const Header &header, std::vector<ParamInfo> &p
   }
   return true;
 }
-bool SemanticPass::signaturesMatch(bool isProcedure, const SemaTypePtr &returnType, const std::vector<ParamInfo> &params, const Symbol *symbol) {
+bool SemanticPass::signaturesMatch(bool isProcedure, SemaTypePtr returnType, const std::vector<ParamInfo> &params, const Symbol *symbol) {
   // make sure that function call is matched with definition or declaration
   // often for forward declaration checking and function definition checking
   if (!symbol || symbol->getKind() != Symbol::SymKind::FUNC) {
@@ -1283,12 +1324,12 @@ bool SemanticPass::signaturesMatch(bool isProcedure, const SemaTypePtr &returnTy
 
   return true;
 }
-bool SemanticPass::checkArguments(const vec<uptr<Expr>> &args, const std::vector<ParamSymbol *> &params, const std::string &callee, const Location &loc, bool isVarArg) {
+bool SemanticPass::checkArguments(ASTList<Expr> args, const std::vector<ParamSymbol *> &params, const std::string &callee, const Location &loc, bool isVarArg) {
   // FIXME: may have bug, not sure
   if (isVarArg) {
     for (std::size_t i = 0; i < args.size(); ++i) {
-      auto arg = args[i].get();
-      if (arg) arg->accept(*this);
+      auto arg = args[i];
+      if (arg) walk(arg);
     }
     return true;
   }
@@ -1304,9 +1345,9 @@ bool SemanticPass::checkArguments(const vec<uptr<Expr>> &args, const std::vector
   std::size_t count = std::min(args.size(), params.size());
 
   for (std::size_t i = 0; i < count; ++i) {
-    auto *arg = args[i].get();
+    auto *arg = args[i];
     if (arg) {
-      arg->accept(*this);
+      walk(arg);
     }
     auto actualType = arg ? arg->type() : SemaTypePtr{};
     if (!typesCompatible(actualType, params[i]->getType())) {
@@ -1328,12 +1369,59 @@ bool SemanticPass::checkArguments(const vec<uptr<Expr>> &args, const std::vector
         );
         throw std::runtime_error("semantic analysis failed");
       }
+      // the callee gets the local's address, codegen must keep it in memory
+      Expr *inner = arg;
+      while (auto *paren = llvm::dyn_cast_or_null<ParenExpr>(inner)) {
+        inner = paren->innerExpr();
+      }
+      auto *lvalExpr = llvm::dyn_cast_or_null<LValueExpr>(inner);
+      auto *id = lvalExpr ? llvm::dyn_cast_or_null<IdLVal>(lvalExpr->lvalue()) : nullptr;
+      if (id && id->symbol() && id->symbol()->hasSlot()) {
+        id->symbol()->markAddressTaken();
+      }
     }
   }
   for (std::size_t i = count; i < args.size(); ++i) {
-    if (auto *arg = args[i].get()) {
-      arg->accept(*this);
+    if (auto *arg = args[i]) {
+      walk(arg);
     }
   }
   return args.size() == params.size();
 }
+void SemanticPass::checkFormat(ASTList<Expr> args, const Location &loc) {
+  auto fail = [](const Location &at, const std::string &message) {
+    Diag::getInstance()->report(Diagnostics::Severity::Error, Diagnostics::Phase::SemanticAnalysis, at, message);
+    throw std::runtime_error("semantic analysis failed");
+  };
+  auto *format = args.empty() ? nullptr : llvm::dyn_cast_or_null<LValueExpr>(args[0]);
+  auto *literal = format ? llvm::dyn_cast_or_null<StringLiteralLVal>(format->lvalue()) : nullptr;
+  // the scanner makes a one-character literal such as "\n" a CHAR
+  auto *single = args.empty() ? nullptr : llvm::dyn_cast_or_null<CharConst>(args[0]);
+  if (!literal && !single) {
+    fail(args.empty() ? loc : args[0]->loc, "the format of 'print' must be a string literal");
+  }
+
+  std::size_t next = 1;
+  for (const auto &piece: parseFormat(literal ? literal->literal() : std::string(1, static_cast<char>(single->getValue())))) {
+    if (piece.kind == FormatPiece::Kind::Text) {
+      continue;
+    }
+    if (piece.kind == FormatPiece::Kind::Invalid) {
+      fail(args[0]->loc, "unsupported conversion '" + piece.text + "' in format of 'print'");
+    }
+    if (next >= args.size()) {
+      fail(loc, "format of 'print' has more conversions than arguments");
+    }
+    auto *arg = args[next++];
+    auto type = arg ? arg->type() : SemaTypePtr{};
+    const bool isInteger = isIntType(type) || isByteType(type) || isChartype(type) || isBoolType(type);
+    const bool matches = piece.conversion == 's' ? (type && type->getKind() == SemaType::TypeKind::STR) || llvm::isa<CharConst>(arg)
+                                                 : isInteger;
+    if (!matches) {
+      fail(arg ? arg->loc : loc, "argument " + std::to_string(next - 1) + " of 'print' has type '" + typeToString(type) + "', which does not match '" + piece.text + "'");
+    }
+  }
+  if (next < args.size()) {
+    fail(args[next]->loc, "format of 'print' has fewer conversions than arguments");
+  }
+}
@@ -3,21 +3,21 @@
 
 #include <utility>
 
-Symbol::Symbol(std::string name, SymKind kind, SemaTypePtr type, Location loc)
-    : name_(std::move(name)),
+Symbol::Symbol(Ident name, SymKind kind, SemaTypePtr type, Location loc)
+    : name_(name),
       kind_(kind),
       type_(std::move(type)),
       loc_(loc) {}
 
 const std::string &Symbol::getName() const {
-  return name_;
+  return spelling(name_);
 }
 
 Symbol::SymKind Symbol::getKind() const {
   return kind_;
 }
 
-const SemaTypePtr &Symbol::getType() const {
+SemaTypePtr Symbol::getType() const {
   return type_;
 }
 
@@ -104,7 +104,7 @@ void FuncSymbol::clearParams() {
 }
 
 void Symbol::dump(std::ostream &out) const {
-  out << "Symbol(name='" << name_ << "', kind=";
+  out << "Symbol(name='" << getName() << "', kind=";
   switch (kind_) {
     case SymKind::VAR:
       out << "VAR";
@@ -1,29 +1,36 @@
 #include "SymbolTable.hpp"
 #include "Diagnostics.hpp"
-#include "Scope.hpp"
 #include <cassert>
 
 SymbolTable::SymbolTable() {
   beginScope();// global scope
 }
 
-void SymbolTable::beginScope() {
-  scopes_.emplace_back(std::make_shared<Scope>(scopes_.empty() ? nullptr : scopes_.back()));
+SymbolTable::SymbolTable(const SymbolTable *globals) : SymbolTable() {
+  globals_ = globals;
+  globalsVisible_ = globals ? globals->declarationCount() : 0;
 }
 
-void SymbolTable::endScope() {
-  assert(!scopes_.empty());
-  scopes_.pop_back();
+void SymbolTable::beginScope() {
+  scopeStarts_.push_back(undo_.size());
 }
 
-Scope &SymbolTable::currentScope() {
-  assert(!scopes_.empty());
-  return *scopes_.back();
+void SymbolTable::endScope() {
+  assert(!scopeStarts_.empty());
+  std::size_t start = scopeStarts_.back();
+  scopeStarts_.pop_back();
+  // every binding made in this scope sits on top of its stack
+  while (undo_.size() > start) {
+    bindings_[undo_.back()].pop_back();
+    undo_.pop_back();
+  }
 }
 
-const Scope &SymbolTable::currentScope() const {
-  assert(!scopes_.empty());
-  return *scopes_.back();
+const SymbolTable::Binding *SymbolTable::top(Ident name) const {
+  if (name.id >= bindings_.size() || bindings_[name.id].empty()) {
+    return nullptr;
+  }
+  return &bindings_[name.id].back();
 }
 
 InsertResult SymbolTable::declare(uptr<Symbol> symbol) {
@@ -31,39 +38,87 @@ InsertResult SymbolTable::declare(uptr<Symbol> symbol) {
     return InsertResult::error();
   }
   Symbol *symPtr = symbol.get();
-  // store the symbol to manage its lifetime(ownership)
+  // store the symbol to manage its lifetime(ownership), even when it is
+  // rejected: callers may still hold on to it
   symbols_.emplace_back(std::move(symbol));
-  return currentScope().declare(symPtr);
+  return bind(symPtr);
+}
+
+InsertResult SymbolTable::bind(Symbol *symbol) {
+  if (!symbol) {
+    return InsertResult::error();
+  }
+  uint32_t id = symbol->getIdent().id;
+  if (id >= bindings_.size()) {
+    bindings_.resize(id + 1);
+  }
+  auto &stack = bindings_[id];
+  auto depth = static_cast<uint32_t>(scopeDepth());
+  if (!stack.empty() && stack.back().depth == depth) {
+    return InsertResult::redeclared(stack.back().symbol);
+  }
+  stack.push_back({symbol, depth, static_cast<uint32_t>(undo_.size())});
+  undo_.push_back(id);
+  return InsertResult::ok(symbol);
+}
+
+LookupResult SymbolTable::lookup(Ident name) const {
+  const Binding *binding = top(name);
+  if (!binding) {
+    return globals_ ? lookupGlobal(name) : LookupResult::notFound();
+  }
+  return LookupResult::ok(binding->symbol, binding->depth);
+}
+
+LookupResult SymbolTable::lookupGlobal(Ident name) const {
+  // the globals table is not modified while layered tables use it, and all
+  // of its scopes but the global one are closed
+  const Binding *binding = globals_->top(name);
+  if (!binding || binding->seq >= globalsVisible_) {
+    return LookupResult::notFound();
+  }
+  return LookupResult::ok(binding->symbol, binding->depth);
 }
 
 LookupResult SymbolTable::lookup(const llvm::StringRef name) const {
-  return currentScope().lookup(name);
+  Ident ident = Idents::getInstance()->find(std::string_view(name.data(), name.size()));
+  if (!ident) {
+    return LookupResult::notFound();
+  }
+  return lookup(ident);
+}
+
+LookupResult SymbolTable::lookupLocal(Ident name) const {
+  auto result = lookup(name);
+  if (result.found() && result.depth != scopeDepth()) {
+    return LookupResult::notFound();
+  }
+  return result;
 }
 
-bool SymbolTable::replaceSymbol(const llvm::StringRef name, uptr<Symbol> newSymbol) {
+bool SymbolTable::replaceSymbol(Ident name, uptr<Symbol> newSymbol) {
   if (!newSymbol) {
     return false;
   }
-  // Look up the old symbol in current scope
-  auto result = currentScope().lookup(name);
-  if (!result.found()) {
+  // only a symbol of the current scope can be replaced
+  const Binding *binding = top(name);
+  if (!binding || binding->depth != scopeDepth()) {
     return false;
   }
+  // the old symbol stays owned: AST nodes may still point at it
+  bindings_[name.id].back().symbol = newSymbol.get();
+  symbols_.emplace_back(std::move(newSymbol));
+  return true;
+}
 
-  Symbol *oldSymPtr = result.symbol;
-  Symbol *newSymPtr = newSymbol.get();
-  string oldName = oldSymPtr->getName();
-  // Find and replace the old symbol in the symbols_ vector
-  for (auto &sym: symbols_) {
-    if (sym.get() == oldSymPtr) {
-      sym = std::move(newSymbol);
-      break;
-    }
+void SymbolTable::adopt(SymbolTable &other) {
+  symbols_.reserve(symbols_.size() + other.symbols_.size());
+  for (auto &symbol: other.symbols_) {
+    symbols_.push_back(std::move(symbol));
   }
-  // Replace the pointer in the current scope
-  return currentScope().replace(oldName, newSymPtr);
+  other.symbols_.clear();
 }
 
 std::size_t SymbolTable::scopeDepth() const {
-  return scopes_.size();
+  return scopeStarts_.size();
 }
@@ -3,6 +3,7 @@
 #include "CodeGenCtx.hpp"
 #include "Diagnostics.hpp"
 #include "Environment.hpp"
+#include "PrintFormat.hpp"
 #include "SemaType.hpp"
 #include "Symbol.hpp"
 #include "Token.hpp"
@@ -22,11 +23,10 @@
 #include <llvm/IR/Verifier.h>
 #include <memory>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <utility>
 
-llvm::Value *CodeGen::lastValue = nullptr;
-
 // ------------------------------------------------------------------------------------------------------
 // some helper function for Structures and Functions
 // ------------------------------------------------------------------------------------------------------
@@ -34,11 +34,11 @@ llvm::Value *CodeGen::lastValue = nullptr;
 // factory function to build function signature from FuncSymbol
 
 // ------------------------------------------------------------------------------------------------------
-CodeGen::CodeGen(CodeGenCtx &ctx) : ctx(ctx) { setupGlobalEnvironment(); }
+CodeGen::CodeGen(CodeGenCtx &ctx, bool defineGlobals) : ctx(ctx) { setupGlobalEnvironment(defineGlobals); }
 
 void CodeGen::visit(Program &node) {
   for (const auto &def: node.getDefs()) {
-    def->accept(*this);
+    walk(def);
   }
 }
 // ?no ir
@@ -52,50 +52,65 @@ void CodeGen::visit(VarDef &node) {
   }
   auto syms = node.symbols();
   auto type = node.declaredType();
-  const auto &initExprOpt = node.initExpr();
+  Expr *initExpr = node.initExpr();
 
   // if variable is a instance
-  if (type->getName().has_value() && type->data_type() == DataType::DataType::MAY_INSTANCE) {
-    if (initExprOpt.has_value()) {
-      const auto &initExpr = initExprOpt.value();
-      initExpr->accept(*this);
+  if (type->typeName() && type->data_type() == DataType::DataType::MAY_INSTANCE) {
+    if (initExpr) {
+      walk(initExpr);
 
       for (auto *sym: syms) {
-        currentEnv->bind(sym, lastValue);
+        env.bind(sym, lastValue);
       }
       return;
     }
 
+    auto *clsInfo = ctx.lookupClsMap(type->typeName());
     for (auto *sym: syms) {
-      auto cls = llvm::StructType::getTypeByName(
-          ctx.getLLVMContext(), type->getName().value()
-      );
-      auto instance = ctx.mallocInstance(cls, sym->getName());
-      currentEnv->bind(sym, instance);
+      auto instance = ctx.mallocInstance(clsInfo, sym->getName());
+      env.bind(sym, instance);
       lastValue = instance;
     }
     return;
   }
   // if there is no initializer
-  if (!initExprOpt.has_value()) {
+  if (!initExpr) {
     for (auto *sym: syms) {
       string name = sym->getName();
       llvm::Type *llvmType = ctx.getLLVMType(*sym->getType());
-      auto varAddr = ctx.createLocalVariable(sym, llvmType, currentEnv);
+      auto varAddr = createLocal(sym, llvmType);
       lastValue = varAddr;
     }
     //lastValue = nullptr;
     return;
   }
+  if (syms.front()->getType()->getKind() == SemaType::TypeKind::ARRAY) {
+    // the initializer is built in the first array and copied to the others
+    llvm::Value *first = nullptr;
+    for (auto *sym: syms) {
+      llvm::Type *llvmType = ctx.getLLVMType(*sym->getType());
+      auto varAddr = createLocal(sym, llvmType);
+      if (first) {
+        copyArray(varAddr, first, llvmType);
+      } else {
+        storeArray(initExpr, varAddr, llvmType);
+        first = varAddr;
+      }
+    }
+    lastValue = nullptr;
+    return;
+  }
   // there is initializer
-  const auto &initExpr = initExprOpt.value();
-  initExpr->accept(*this);
+  walk(initExpr);
   // for each symbol, allocate variable and store the initialized value
   for (auto *sym: syms) {
     string name = sym->getName();
     llvm::Type *llvmType = ctx.getLLVMType(*sym->getType());
-    auto varAddr = ctx.createLocalVariable(sym, llvmType, currentEnv);
-    ctx.getBuilder().CreateStore(lastValue, varAddr);
+    if (auto varAddr = createLocal(sym, llvmType)) {
+      ctx.getBuilder().CreateStore(lastValue, varAddr);
+    } else {
+      writeLocal(sym, lastValue);
+    }
   }
   lastValue = nullptr;
 }
@@ -122,9 +137,8 @@ void CodeGen::visit(FuncDef &node) {
     return;
   }
   // save current function
-  auto prevFn = CodeGenCtx::curFunction;
+  auto prevFn = ctx.curFunction;
   auto prevBlock = ctx.getBuilder().GetInsertBlock();
-  auto prevEnv = currentEnv;
 
   const bool is_main = node.isEntrypoint();
   const bool is_method = node.isMethod() && ctx.curCls != nullptr;
@@ -133,14 +147,16 @@ void CodeGen::visit(FuncDef &node) {
   auto funcType = llvm::FunctionType::get(sig.retTy, sig.paramTys, false);
 
   // Create entry basic block for function body
-  auto newFunction = ctx.createFunction(funcSym, funcType, currentEnv);
+  auto newFunction = ctx.createFunction(funcSym, funcType, env);
 
-  CodeGenCtx::curFunction = newFunction;
+  ctx.curFunction = newFunction;
+  SSABuilder ssaBuilder(ctx.getBuilder(), *funcSym);
+  auto *enclosingSsa = std::exchange(ssa, &ssaBuilder);
+  ssa->seal(&newFunction->getEntryBlock());
 
   unsigned idx = 0;
   // store parameters in function
-  // function Environment
-  currentEnv = std::make_shared<Environment>(currentEnv);
+  auto enclosingFrame = env.enterFunction(*funcSym);
   if (is_method) {
     // we add this pointer to method
     auto argIt = newFunction->arg_begin();
@@ -152,24 +168,18 @@ void CodeGen::visit(FuncDef &node) {
     for (; argIt != newFunction->arg_end(); ++argIt) {
       auto paramSym = funcSym->getParams().at(idx++);
       argIt->setName(paramSym->getName());
-
-      auto argBinding =
-          ctx.createLocalVariable(paramSym, argIt->getType(), currentEnv);
-      ctx.getBuilder().CreateStore(&(*argIt), argBinding);
+      bindParam(paramSym, &*argIt);
     }
   } else {
     ctx.curThisCls = nullptr;
     for (auto &arg: newFunction->args()) {
       auto paramSym = funcSym->getParams().at(idx++);
       arg.setName(paramSym->getName());
-
-      auto argBinding =
-          ctx.createLocalVariable(paramSym, arg.getType(), currentEnv);
-      ctx.getBuilder().CreateStore(&arg, argBinding);
+      bindParam(paramSym, &arg);
     }
   }
 
-  body->accept(*this);
+  walk(body);
 
   llvm::BasicBlock *BB = ctx.getBuilder().GetInsertBlock();
   if (BB && !BB->getTerminator()) {
@@ -184,9 +194,11 @@ void CodeGen::visit(FuncDef &node) {
     }
   }
 
+  ssa->finish();
+  ssa = enclosingSsa;
   ctx.getBuilder().SetInsertPoint(prevBlock);
-  CodeGenCtx::curFunction = prevFn;
-  currentEnv = prevEnv;
+  ctx.curFunction = prevFn;
+  env.leaveFunction(std::move(enclosingFrame));
 
   // Validate the generated code, checking for consistency.
   verifyFunction(*newFunction);
@@ -195,10 +207,10 @@ void CodeGen::visit(FuncDef &node) {
 }
 
 void CodeGen::visit(ClassDecl &node) {
-  string clsName = node.identifier();
+  const string &clsName = node.identifier();
   auto parent = nullptr;
-  const auto &fields = node.fieldList();
-  const auto &methods = node.methodList();
+  const auto fields = node.fieldList();
+  const auto methods = node.methodList();
 
   // create cls
   ctx.curCls = llvm::StructType::create(ctx.getLLVMContext(), clsName);
@@ -209,25 +221,24 @@ void CodeGen::visit(ClassDecl &node) {
   } else {
     auto clsInfo =
         std::make_unique<CodeGenCtx::ClassInfo>(ctx.curCls, parent);
-    ctx.addClsMap(clsName, std::move(clsInfo));
+    ctx.curClsInfo = ctx.addClsMap(node.ident(), std::move(clsInfo));
   }
   // populate class with fields and methods
-  ctx.buildClassInfo(ctx.curCls, node, currentEnv);
+  ctx.buildClassInfo(ctx.curClsInfo, node, env);
   // compile class body
   // we dont need to compile variables in class because it is already compiled in 'buildClass'
   for (auto &field: fields) {
-    field->accept(*this);
+    walk(field);
   }
   for (auto &method: methods) {
-    method->accept(*this);
+    walk(method);
   }
   ctx.curCls = nullptr;// after compiling, reset it
+  ctx.curClsInfo = nullptr;
 }
 void CodeGen::visit(Block &node) {
-  Environment::Env env = std::make_shared<Environment>(currentEnv);
-  EnvironmentGuard env_guard{*this, env};
   for (auto &stmt: node.statementsList()) {
-    stmt->accept(*this);
+    walk(stmt);
   }
 }
 
@@ -237,12 +248,27 @@ void CodeGen::visit(AssignStmt &node) {
   llvm::Value *rhsValue = nullptr;// rval or lval
   llvm::Value *lhsAddr = nullptr; // lval address
 
+  if (auto *lhs = node.left(); lhs && lhs->type() && lhs->type()->getKind() == SemaType::TypeKind::ARRAY) {
+    walk(lhs);
+    if (lastValue) {
+      storeArray(node.right(), lastValue, ctx.getLLVMType(*lhs->type()));
+    }
+    lastValue = nullptr;
+    return;
+  }
   if (auto *rhs = node.right()) {
-    rhs->accept(*this);
+    walk(rhs);
     rhsValue = lastValue;
   }
+  if (auto *id = llvm::dyn_cast_or_null<IdLVal>(node.left()); id && isPromoted(id->symbol())) {
+    if (rhsValue) {
+      writeLocal(id->symbol(), rhsValue);
+    }
+    lastValue = nullptr;
+    return;
+  }
   if (auto *lhs = node.left()) {
-    lhs->accept(*this);
+    walk(lhs);
     lhsAddr = lastValue;
   }
   if (lhsAddr && rhsValue) {
@@ -251,9 +277,13 @@ void CodeGen::visit(AssignStmt &node) {
   lastValue = nullptr;
 }
 void CodeGen::visit(ReturnStmt &node) {
-  node.returnValue()->accept(*this);
+  walk(node.returnValue());
   llvm::Value *retValue = lastValue;
-  if (CodeGenCtx::curFunction->getReturnType()->isVoidTy()) {
+  auto *retTy = ctx.curFunction->getReturnType();
+  if (retValue && retTy->isArrayTy() && retValue->getType()->isPointerTy()) {
+    retValue = ctx.getBuilder().CreateLoad(retTy, retValue);// arrays are returned by value
+  }
+  if (retTy->isVoidTy()) {
     ctx.getBuilder().CreateRetVoid();
   } else {
     ctx.getBuilder().CreateRet(retValue);
@@ -283,7 +313,7 @@ void CodeGen::visit(IfStmt &node) {
   // add if-then branch
   branches.emplace_back(node.conditionExpr(), node.thenBlock());
   for (const auto &elifPair: node.elifs()) {
-    branches.emplace_back(elifPair.first.get(), elifPair.second.get());
+    branches.emplace_back(elifPair.first, elifPair.second);
   }
 
   llvm::BasicBlock *condBB = curBB;
@@ -300,31 +330,36 @@ void CodeGen::visit(IfStmt &node) {
 
     // generate condition
     ctx.getBuilder().SetInsertPoint(condBB);
-    condNode->accept(*this);
+    walk(condNode);
     llvm::Value *condValue = lastValue;
     ctx.getBuilder().CreateCondBr(condValue, thenBlock, falseBlock);
+    ssa->seal(thenBlock);
+    if (falseBlock != endBlock) {
+      ssa->seal(falseBlock);
+    }
     // generate then block
     ctx.getBuilder().SetInsertPoint(thenBlock);
-    bodyNode->accept(*this);
+    walk(bodyNode);
     // if then block is not terminated, branch to end
     llvm::BasicBlock *thenExit = ctx.getBuilder().GetInsertBlock();
     if (thenExit && !thenExit->getTerminator()) {
       ctx.getBuilder().CreateBr(endBlock);
     }
     condBB = falseBlock;
+  }
 
-    // generate else block
-    if (elseBlockNode) {
-      lastValue = nullptr;
-      ctx.getBuilder().SetInsertPoint(elseBlock);
-      elseBlockNode->accept(*this);
-      llvm::BasicBlock *elseExit = ctx.getBuilder().GetInsertBlock();
-      if (elseExit && !elseExit->getTerminator()) {
-        ctx.getBuilder().CreateBr(endBlock);
-      }
+  // generate else block
+  if (elseBlockNode) {
+    lastValue = nullptr;
+    ctx.getBuilder().SetInsertPoint(elseBlock);
+    walk(elseBlockNode);
+    llvm::BasicBlock *elseExit = ctx.getBuilder().GetInsertBlock();
+    if (elseExit && !elseExit->getTerminator()) {
+      ctx.getBuilder().CreateBr(endBlock);
     }
   }
   // continue at end block
+  ssa->seal(endBlock);
   ctx.getBuilder().SetInsertPoint(endBlock);
   lastValue = nullptr;
 }
@@ -349,55 +384,51 @@ void CodeGen::visit(LoopStmt &node) {
 
   // compile while
   ctx.getBuilder().SetInsertPoint(condBlock);
-  condNode->accept(*this);
+  walk(condNode);
   ctx.getBuilder().CreateCondBr(lastValue, bodyBlock, endBlock);
+  ssa->seal(bodyBlock);
+  ssa->seal(endBlock);
   // compile body
   ctx.getBuilder().SetInsertPoint(bodyBlock);
-  bodyNode->accept(*this);
+  walk(bodyNode);
   if (!ctx.getBuilder().GetInsertBlock()->getTerminator()) {
     ctx.getBuilder().CreateBr(condBlock);
   }
+  // the back edge is in, the phis of the condition are complete
+  ssa->seal(condBlock);
   // end while
   ctx.getBuilder().SetInsertPoint(endBlock);
 }
 
 void CodeGen::visit(IdLVal &node) {
   auto sym = node.symbol();
-  if (auto var = currentEnv->lookup(sym)) {
+  if (isPromoted(sym)) {
+    lastValue = nullptr;// has no address, see visit(LValueExpr)
+    return;
+  }
+  if (auto var = env.lookup(sym)) {
     lastValue = var;// var is actually address value
     return;
   }
   // !it should be a class field
   if (ctx.curCls != nullptr) {
-    string clsName = ctx.curCls->getName().data();
-    CodeGenCtx::ClassInfo *clsInfo = ctx.lookupClsMap(clsName);
+    CodeGenCtx::ClassInfo *clsInfo = ctx.curClsInfo;
     auto &fields = clsInfo->fieldsMap;
-    if (fields.find(sym->getName()) != fields.end()) {
+    if (fields.count(sym->getIdent())) {
       string ptrName = string("p") + sym->getName();
-      size_t fieldIndex = ctx.getFieldIndex(ctx.curCls, sym->getName());
+      size_t fieldIndex = ctx.getFieldIndex(clsInfo, sym->getIdent());
       lastValue = ctx.getBuilder().CreateStructGEP(ctx.curCls, ctx.curThisCls, fieldIndex, ptrName);
     }
   }
 }
 void CodeGen::visit(StringLiteralLVal &node) {
-  const std::string &literal = node.literal();
-  // remove the surrounding quotes
-  string content = literal.substr(1, literal.size() - 2);
-  auto *constStr =
-      llvm::ConstantDataArray::getString(ctx.getLLVMContext(), content, true);
-  auto *arrayTy = constStr->getType();
-
-  static int strCounter = 0;
-  std::string globalName = ".str." + std::to_string(strCounter++);
-
-  auto *global = new llvm::GlobalVariable(ctx.getModule(), arrayTy, true, llvm::GlobalValue::PrivateLinkage, constStr, globalName);
-  global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
-  lastValue = global;
+  // the scanner has already dropped the quotes and unescaped the text
+  lastValue = ctx.internString(node.literal());
 }
 void CodeGen::visit(IndexLVal &node) {
   llvm::Value *basePtr = nullptr;
   if (auto *base = node.baseExpr()) {
-    base->accept(*this);
+    walk(base);
     basePtr = lastValue;
   }
   if (!basePtr) {
@@ -406,7 +437,7 @@ void CodeGen::visit(IndexLVal &node) {
   }
   llvm::Value *indexVal = nullptr;
   if (auto *idx = node.indexExpr()) {
-    idx->accept(*this);
+    walk(idx);
     indexVal = lastValue;
   }
   if (!indexVal) {
@@ -427,9 +458,8 @@ void CodeGen::visit(IndexLVal &node) {
     lastValue = nullptr;
     return;
   }
-  const auto *baseSema =
-      node.baseExpr() ? node.baseExpr()->type().get() : nullptr;
-  const auto *elemSema = node.type() ? node.type().get() : nullptr;
+  const auto *baseSema = node.baseExpr() ? node.baseExpr()->type() : nullptr;
+  const auto *elemSema = node.type();
   llvm::Type *elemType = elemSema ? ctx.getLLVMType(*elemSema) : nullptr;
   if (!elemType) {
     lastValue = nullptr;
@@ -469,7 +499,19 @@ void CodeGen::visit(FalseConst &node) {
       llvm::ConstantInt::get(ctx.getLLVMContext(), llvm::APInt(8, 0, false));
 }
 void CodeGen::visit(LValueExpr &node) {
-  node.lvalue()->accept(*this);
+  if (auto *id = llvm::dyn_cast_or_null<IdLVal>(node.lvalue()); id && isPromoted(id->symbol())) {
+    lastValue = ssa->read(*id->symbol(), ctx.getBuilder().GetInsertBlock());
+    return;
+  }
+  if (llvm::isa_and_nonnull<StringLiteralLVal>(node.lvalue())) {
+    walk(node.lvalue());// a str is the address of its characters
+    return;
+  }
+  if (node.type() && node.type()->getKind() == SemaType::TypeKind::ARRAY) {
+    walk(node.lvalue());// so is an array, it is never loaded whole
+    return;
+  }
+  walk(node.lvalue());
   llvm::Value *lvalAddr = lastValue;
 
   if (!lvalAddr) {
@@ -483,80 +525,66 @@ void CodeGen::visit(LValueExpr &node) {
 }
 void CodeGen::visit(ParenExpr &node) {
   if (auto *inner = node.innerExpr()) {
-    inner->accept(*this);
+    walk(inner);
   }
 }
 void CodeGen::visit(FuncCall &node) {
-  auto funcSym = node.funcSymbol();
-  auto &args = node.arguments();
-  llvm::Function *func = currentEnv->lookupFunc(funcSym);
-  vec<llvm::Value *> llvmArgs;
-  for (size_t i = 0; i < args.size(); ++i) {
-    args[i]->accept(*this);
-    auto paramType = func->getArg(i)->getType();
-    auto bitCastArgVal = ctx.getBuilder().CreateBitCast(lastValue, paramType);
-    llvmArgs.push_back(bitCastArgVal);
-  }
-  lastValue = ctx.getBuilder().CreateCall(func, llvmArgs);
+  // by-ref arguments, arrays among them, are passed as their address
+  lastValue = makeCall(node.funcSymbol(), node.arguments());
 }
 void CodeGen::visit(MemberAccessExpr &node) {
   auto fieldSym = node.memberSymbol();
   string fieldName = fieldSym->getName();
   auto instExpr = node.object();
 
-  static_cast<LValueExpr *>(instExpr)->lvalue()->accept(*this);
-  llvm::Value *instance = lastValue;
-  string clsName;
   // TODO: ast node do not need to store lval expression but to just store lval
-  if (auto lvalExpr = dynamic_cast<LValueExpr *>(instExpr)) {
-    auto semaTy = lvalExpr->lvalue()->type();
-    if (auto instTy = std::dynamic_pointer_cast<const InstanceType>(semaTy)) {
-      clsName = instTy->getClassName();
-    }
+  auto lvalExpr = llvm::cast<LValueExpr>(instExpr);
+  walk(lvalExpr->lvalue());
+  llvm::Value *instance = lastValue;
+  Ident clsName;
+  if (auto instTy = llvm::dyn_cast_or_null<InstanceType>(lvalExpr->lvalue()->type())) {
+    clsName = instTy->classIdent();
   }
-  auto cls = llvm::StructType::getTypeByName(ctx.getLLVMContext(), clsName);
-  size_t fieldIndex = ctx.getFieldIndex(cls, fieldName);
+  auto clsInfo = ctx.lookupClsMap(clsName);
+  auto cls = clsInfo->cls;
+  size_t fieldIndex = ctx.getFieldIndex(clsInfo, fieldSym->getIdent());
   string ptrName = string("p") + fieldName;
   auto address = ctx.getBuilder().CreateStructGEP(cls, instance, fieldIndex, ptrName);
   lastValue = ctx.getBuilder().CreateLoad(cls->getElementType(fieldIndex), address, fieldName);
 }
 void CodeGen::visit(MethodCall &node) {
   auto callee = node.object();
-  auto methodSym = node.methodSymbol();
-  string methodName = methodSym->getName();
+  Ident methodName = node.methodIdent();
   // TODO: same problem as before
-  // we do not use callee->accept because LValueExpr would do load Instruction
-  static_cast<LValueExpr *>(callee)->lvalue()->accept(*this);
+  // we do not walk the callee because LValueExpr would do load Instruction
+  auto lvalExpr = llvm::cast<LValueExpr>(callee);
+  walk(lvalExpr->lvalue());
 
   llvm::Value *instance = lastValue;
 
   llvm::StructType *vTableType = nullptr;
   llvm::Value *vTable = nullptr;
 
-  string clsName;
-  if (auto lvalExpr = dynamic_cast<LValueExpr *>(callee)) {
-    auto semaTy = lvalExpr->lvalue()->type();
-    if (auto instTy = std::dynamic_pointer_cast<const InstanceType>(semaTy)) {
-      clsName = instTy->getClassName();
-    }
+  Ident clsName;
+  if (auto instTy = llvm::dyn_cast_or_null<InstanceType>(lvalExpr->lvalue()->type())) {
+    clsName = instTy->classIdent();
   }
-  auto cls = llvm::StructType::getTypeByName(ctx.getLLVMContext(), clsName);
+  auto clsInfo = ctx.lookupClsMap(clsName);
+  auto cls = clsInfo->cls;
 
   // laod vtable
-  string vTableName = clsName + "_vTable";
-  vTableType = llvm::StructType::getTypeByName(ctx.getLLVMContext(), vTableName);
+  vTableType = clsInfo->vTableType;
   auto vTableAddr = ctx.getBuilder().CreateStructGEP(cls, instance, VTABLE_INDEX, "vtable_addr");
   vTable = ctx.getBuilder().CreateLoad(llvm::PointerType::get(vTableType, 0), vTableAddr, "vtbale");
 
   // load method
-  size_t methodIndex = ctx.getMethodIndex(cls, methodName);
+  size_t methodIndex = ctx.getMethodIndex(clsInfo, methodName);
   // auto methodType = (llvm::FunctionType *) vTableType->getElementType(methodIndex);
   auto methodPtrType = vTableType->getElementType(methodIndex);
   llvm::FunctionType *methodType = nullptr;
 
   if (auto ptrTy = llvm::dyn_cast<llvm::PointerType>(methodPtrType)) {
-    auto clsInfo = ctx.lookupClsMap(clsName);
-    auto methodFunc = clsInfo->methodsMap[methodName];
+    auto methodFunc = clsInfo->methods[methodIndex];
     methodType = methodFunc->getFunctionType();
   }
 
@@ -570,23 +598,22 @@ void CodeGen::visit(MethodCall &node) {
   args.push_back(instance);// this pointer
 
   for (auto &arg: node.arguments()) {
-    arg->accept(*this);
+    walk(arg);
     args.push_back(lastValue);
   }
 
   lastValue = ctx.getBuilder().CreateCall(methodType, methodPtr, args, "method_call");
 }
 void CodeGen::visit(NewExpr &node) {
-  string clsName = node.getCotorName();
-  auto &args = node.getArgs();
+  auto args = node.getArgs();
 
-  auto cls = llvm::StructType::getTypeByName(ctx.getLLVMContext(), clsName);
-  auto ctor = ctx.getModule().getFunction(clsName + "_constructor");
-  auto instance = ctx.mallocInstance(cls, "inst");
+  auto clsInfo = ctx.lookupClsMap(node.classIdent());
+  auto ctor = clsInfo->ctor;
+  auto instance = ctx.mallocInstance(clsInfo, "inst");
 
   vec<llvm::Value *> ctorArgs{instance};
   for (auto &arg: args) {
-    arg->accept(*this);
+    walk(arg);
     ctorArgs.push_back(lastValue);
   }
   ctx.getBuilder().CreateCall(ctor, ctorArgs);
@@ -594,7 +621,7 @@ void CodeGen::visit(NewExpr &node) {
   lastValue = instance;
 }
 void CodeGen::visit(UnaryExpr &node) {
-  node.operandExpr()->accept(*this);
+  walk(node.operandExpr());
   llvm::Value *operand = lastValue;
 
   if (!operand)
@@ -618,10 +645,10 @@ void CodeGen::visit(UnaryExpr &node) {
   }
 }
 void CodeGen::visit(BinaryExpr &node) {
-  node.leftExpr()->accept(*this);
+  walk(node.leftExpr());
   llvm::Value *lhs = lastValue;
 
-  node.rightExpr()->accept(*this);
+  walk(node.rightExpr());
   llvm::Value *rhs = lastValue;
 
   if (!lhs || !rhs) {
@@ -688,56 +715,156 @@ void CodeGen::visit(BinaryExpr &node) {
 }
 
 void CodeGen::visit(ArrayExpr &node) {
-  const auto &elems = node.getElements();
-  if (elems.empty()) {
-    return;
+  lastValue = nullptr;
+  const auto *arraySema = llvm::dyn_cast_or_null<ArrayType>(node.type());
+  if (node.getElements().empty() || !arraySema || !arraySema->size().has_value()) {
+    return;// only arrat literal with length supported
   }
+  // a literal with no destination of its own gets a temporary
+  llvm::Type *arrayTy = ctx.getLLVMType(*arraySema);
+  auto *arrayPtr = ctx.createEntryAlloca(arrayTy, "arr.lit");
+  storeArray(&node, arrayPtr, arrayTy);
+  lastValue = arrayPtr;
+}
 
-  const auto semaTy = node.type();
-  const auto *arraySema =
-      semaTy ? dynamic_cast<const ArrayType *>(semaTy.get()) : nullptr;
-  if (!arraySema || !arraySema->size().has_value()) {
-    return;// only arrat literal with length supported
+void CodeGen::visit(ExprCond &node) { walk(node.expression()); }
+
+llvm::Value *CodeGen::createLocal(Symbol *sym, llvm::Type *type) {
+  bool scalar = false;
+  switch (sym->getType()->getKind()) {
+    case SemaType::TypeKind::INT:
+    case SemaType::TypeKind::CHAR:
+    case SemaType::TypeKind::BYTE:
+    case SemaType::TypeKind::BOOL:
+    case SemaType::TypeKind::STR:
+      scalar = true;
+      break;
+    default:
+      break;
+  }
+  if (ssa && scalar && sym->hasSlot() && !sym->isAddressTaken()) {
+    ssa->declare(*sym, type);
+    return nullptr;
   }
+  return ctx.createLocalVariable(sym, type, env);
+}
+
+void CodeGen::writeLocal(Symbol *sym, llvm::Value *value) {
+  ssa->write(*sym, ctx.getBuilder().GetInsertBlock(), value);
+}
 
-  llvm::Type *elemTy = ctx.getLLVMType(*arraySema->elementType());
-  if (!elemTy) {
+void CodeGen::bindParam(ParamSymbol *paramSym, llvm::Argument *arg) {
+  // a by-ref parameter is the address of the caller's variable
+  if (paramSym->getPass() == Symbol::ParamPass::BY_REF) {
+    env.bind(paramSym, arg);
     return;
   }
+  if (auto *argBinding = createLocal(paramSym, arg->getType())) {
+    ctx.getBuilder().CreateStore(arg, argBinding);
+  } else {
+    writeLocal(paramSym, arg);
+  }
+}
 
-  auto *arrayTy = llvm::ArrayType::get(elemTy, *arraySema->size());
-  auto *arrayPtr = ctx.getBuilder().CreateAlloca(arrayTy, nullptr, "arr.lit");
-  auto *zero =
-      llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx.getLLVMContext()), 0);
+void CodeGen::storeArray(Expr *init, llvm::Value *dest, llvm::Type *arrayTy) {
+  auto &builder = ctx.getBuilder();
+  auto *literal = llvm::dyn_cast_or_null<ArrayExpr>(init);
+  if (!literal) {
+    walk(init);
+    if (lastValue && lastValue->getType()->isPointerTy()) {
+      copyArray(dest, lastValue, arrayTy);
+    } else if (lastValue) {
+      builder.CreateStore(lastValue, dest);
+    }
+    return;
+  }
 
-  for (std::size_t i = 0; i < elems.size(); ++i) {
-    elems[i]->accept(*this);
-    llvm::Value *elemVal = lastValue;
-    if (!elemVal) {
+  // nested literals fill the array in memory order, element by element
+  llvm::Type *scalarTy = arrayTy;
+  uint64_t count = 1;
+  while (auto *nested = llvm::dyn_cast<llvm::ArrayType>(scalarTy)) {
+    count *= nested->getNumElements();
+    scalarTy = nested->getElementType();
+  }
+  // every element is evaluated before the first store, the literal may read
+  // the array it is assigned to
+  vec<ArrayElement> elements;
+  collectElements(*literal, elements);
+  vec<llvm::Constant *> constants;
+  for (auto &element: elements) {
+    auto *value = element.value;
+    if (element.arrayTy) {
       continue;
     }
-    // 简单的整数/指针类型对齐
-    if (elemVal->getType() != elemTy) {
-      if (elemVal->getType()->isIntegerTy() && elemTy->isIntegerTy()) {
-        elemVal = ctx.getBuilder().CreateIntCast(elemVal, elemTy, true, "arr.elem.cast");
-      } else if (elemVal->getType()->isPointerTy() &&
-                 elemTy->isPointerTy()) {
-        elemVal = ctx.getBuilder().CreateBitCast(elemVal, elemTy, "arr.elem.cast");
+    if (value && value->getType() != scalarTy && value->getType()->isIntegerTy() && scalarTy->isIntegerTy()) {
+      element.value = value = builder.CreateIntCast(value, scalarTy, true, "arr.elem.cast");
+    }
+    if (auto *constant = llvm::dyn_cast_or_null<llvm::Constant>(value)) {
+      constants.push_back(constant);
+    }
+  }
+  if (constants.size() == count && elements.size() == count) {
+    // emitted once per module and copied, instead of a store per element
+    auto *image = llvm::ConstantArray::get(llvm::ArrayType::get(scalarTy, count), constants);
+    copyArray(dest, ctx.internConstant(image), arrayTy);
+    return;
+  }
+  uint64_t index = 0;
+  for (const auto &element: elements) {
+    if (index >= count) {
+      break;
+    }
+    auto *slot = builder.CreateConstInBoundsGEP1_64(scalarTy, dest, index, "arr.slot");
+    if (!element.arrayTy) {
+      if (element.value) {
+        builder.CreateStore(element.value, slot);
       }
+      ++index;
+      continue;
     }
-    auto *idxConst = llvm::ConstantInt::get(
-        llvm::Type::getInt32Ty(ctx.getLLVMContext()), i
-    );
-    auto *slot = ctx.getBuilder().CreateInBoundsGEP(
-        arrayTy, arrayPtr, {zero, idxConst}, "arr.slot"
-    );
-    ctx.getBuilder().CreateStore(elemVal, slot);
+    // a whole sub-array, an array variable or the result of a call
+    if (element.value && element.value->getType()->isPointerTy()) {
+      copyArray(slot, element.value, element.arrayTy);
+    } else if (element.value) {
+      builder.CreateStore(element.value, slot);
+    }
+    index += element.count;
   }
+}
 
-  lastValue = ctx.getBuilder().CreateLoad(arrayTy, arrayPtr, "arr.val");
+void CodeGen::copyArray(llvm::Value *dest, llvm::Value *src, llvm::Type *arrayTy) {
+  const auto &layout = ctx.getModule().getDataLayout();
+  auto align = layout.getABITypeAlign(arrayTy);
+  ctx.getBuilder().CreateMemCpy(dest, align, src, align, layout.getTypeAllocSize(arrayTy));
 }
 
-void CodeGen::visit(ExprCond &node) { node.expression()->accept(*this); }
+void CodeGen::collectElements(ArrayExpr &node, vec<ArrayElement> &elements) {
+  for (auto *elem: node.getElements()) {
+    if (auto *inner = llvm::dyn_cast_or_null<ArrayExpr>(elem)) {
+      collectElements(*inner, elements);
+      continue;
+    }
+    walk(elem);
+    const auto *elemSema = elem ? elem->type() : nullptr;
+    if (!elemSema || elemSema->getKind() != SemaType::TypeKind::ARRAY) {
+      elements.push_back({lastValue, nullptr, 1});
+      continue;
+    }
+    llvm::Type *subTy = ctx.getLLVMType(*elemSema);
+    uint64_t count = 1;
+    for (llvm::Type *ty = subTy; auto *nested = llvm::dyn_cast<llvm::ArrayType>(ty); ty = nested->getElementType()) {
+      count *= nested->getNumElements();
+    }
+    llvm::Value *value = lastValue;
+    if (value && value->getType()->isPointerTy()) {
+      // read now, the destination may be the array it lives in
+      auto *copy = ctx.createEntryAlloca(subTy, "arr.elem");
+      copyArray(copy, value, subTy);
+      value = copy;
+    }
+    elements.push_back({value, subTy, count});
+  }
+}
 
 // make sure that function symbol has corresponding LLVM function in module
 llvm::Function *
@@ -745,7 +872,7 @@ CodeGen::ensureLLVMFunction(FuncSymbol *funcSym, const CodeGenCtx::FuncSignature
   // look up existing function symbol in module
   if (!funcSym)
     return nullptr;
-  auto *llvmFunc = currentEnv->lookupFunc(funcSym);
+  auto *llvmFunc = env.lookupFunc(funcSym);
   if (llvmFunc)
     return llvmFunc;
 
@@ -757,67 +884,165 @@ CodeGen::ensureLLVMFunction(FuncSymbol *funcSym, const CodeGenCtx::FuncSignature
       llvmFnTy, llvm::GlobalValue::ExternalLinkage,
       is_main ? "main" : funcSym->getName(), &ctx.getModule()
   );
-  currentEnv->bindFunc(funcSym, llvmFunc);
+  env.bindFunc(funcSym, llvmFunc);
   return llvmFunc;
 }
 
-llvm::Value *CodeGen::emitPrint(FuncSymbol *calleeSym, const vec<uptr<Expr>> &args) {
+void CodeGen::declareFunctions(Program &program) {
+  for (auto *def: program.getDefs()) {
+    Header *header = nullptr;
+    bool isMain = false;
+    if (auto *funcDef = llvm::dyn_cast<FuncDef>(def)) {
+      header = funcDef->funcHeader();
+      isMain = funcDef->isEntrypoint();
+    } else if (auto *funcDecl = llvm::dyn_cast<FuncDecl>(def)) {
+      header = funcDecl->funcHeader();
+    }
+    if (auto *funcSym = header ? header->symbol() : nullptr) {
+      ensureLLVMFunction(funcSym, ctx.buildSignature(funcSym, isMain), isMain);
+    }
+  }
+}
+
+void CodeGen::importDeclarations(Program &program, const CodeGenCtx &header) {
+  for (auto *def: program.getDefs()) {
+    auto *cls = llvm::dyn_cast<ClassDecl>(def);
+    if (!cls) {
+      continue;
+    }
+    if (const auto *defined = header.lookupClsMap(cls->ident())) {
+      ctx.importClass(*cls, *defined, env);
+    }
+  }
+  declareFunctions(program);
+}
+
+llvm::Value *CodeGen::emitPrint(FuncSymbol *calleeSym, ASTList<Expr> args) {
   auto &builder = ctx.getBuilder();
   auto &llctx = ctx.getLLVMContext();
   auto &module = ctx.getModule();
+  auto *i8Ty = llvm::Type::getInt8Ty(llctx);
+  auto *i32Ty = llvm::Type::getInt32Ty(llctx);
+
+  // sema has checked the format against the arguments; a one-character
+  // format is scanned as a CHAR
+  std::string format;
+  if (auto *single = llvm::dyn_cast<CharConst>(args[0])) {
+    format.assign(1, static_cast<char>(single->getValue()));
+  } else {
+    format = llvm::cast<StringLiteralLVal>(llvm::cast<LValueExpr>(args[0])->lvalue())->literal();
+  }
+  // every argument is evaluated before anything is printed, as for a call
+  vec<llvm::Value *> values;
+  for (size_t i = 1; i < args.size(); ++i) {
+    walk(args[i]);
+    values.push_back(lastValue);
+  }
+  auto stringLiteral = [](Expr *expr) -> StringLiteralLVal * {
+    auto *lvalExpr = llvm::dyn_cast_or_null<LValueExpr>(expr);
+    return lvalExpr ? llvm::dyn_cast_or_null<StringLiteralLVal>(lvalExpr->lvalue()) : nullptr;
+  };
 
-  std::vector<llvm::Value *> printArgs;
-
-  for (size_t i = 0; i < args.size(); ++i) {
-    auto *expr = args[i].get();
-
-    if (i == 0) {
-      auto *strLit = dynamic_cast<LValueExpr *>(expr);
-      assert(strLit && "print function's first argument must be a string literal");
-
-      llvm::Constant *strConst = llvm::ConstantDataArray::getString(
-          llctx, dynamic_cast<StringLiteralLVal *>(strLit->lvalue())->literal(), /*AddNull=*/true
-      );
-      auto *gv = new llvm::GlobalVariable(
-          module,
-          strConst->getType(),
-          /*isConstant=*/true,
-          llvm::GlobalValue::PrivateLinkage,
-          strConst,
-          ".fmt"
-      );
-      gv->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
-      gv->setAlignment(llvm::Align(1));
-
-      printArgs.push_back(gv);
+  // the runtime functions are declared by genBuiltins, from builtinTable
+  auto callRuntime = [&](const char *runtimeName, llvm::ArrayRef<llvm::Value *> callArgs) {
+    llvm::Function *fn = module.getFunction(runtimeName);
+    bool matches = fn && fn->arg_size() == callArgs.size();
+    for (std::size_t i = 0; matches && i < callArgs.size(); ++i) {
+      matches = fn->getArg(i)->getType() == callArgs[i]->getType();
+    }
+    if (!matches) {
+      throw std::runtime_error(string("runtime function '") + runtimeName + "' is not declared as print expects");
+    }
+    builder.CreateCall(fn, callArgs);
+  };
+  // text and constant arguments are gathered into one cat_write_lit
+  std::string text;
+  auto flushText = [&]() {
+    if (text.empty()) {
+      return;
+    }
+    callRuntime("cat_write_lit", {ctx.internString(text), builder.getInt64(text.size())});
+    text.clear();
+  };
+  auto write = [&](const char *runtimeName, llvm::Value *value) {
+    flushText();
+    callRuntime(runtimeName, {value});
+  };
 
-    } else {
-      expr->accept(*this);
-      printArgs.push_back(lastValue);
+  std::size_t next = 0;
+  for (const auto &piece: parseFormat(format)) {
+    if (piece.kind == FormatPiece::Kind::Text) {
+      text += piece.text;
+      continue;
+    }
+    Expr *arg = args[next + 1];
+    llvm::Value *value = values[next++];
+    if (!value) {
+      continue;
+    }
+    // narrower integers are widened as a variadic call would
+    llvm::Value *asInt = value->getType()->isIntegerTy() ? builder.CreateZExtOrTrunc(value, i32Ty) : value;
+    auto *constant = llvm::dyn_cast<llvm::ConstantInt>(asInt);
+    switch (piece.kind) {
+      case FormatPiece::Kind::Int:
+        if (constant) {
+          text += std::to_string(static_cast<int32_t>(constant->getSExtValue()));
+        } else {
+          write("cat_write_i32", asInt);
+        }
+        break;
+      case FormatPiece::Kind::Unsigned:
+        if (constant) {
+          text += std::to_string(static_cast<uint32_t>(constant->getZExtValue()));
+        } else {
+          write("cat_write_u32", asInt);
+        }
+        break;
+      case FormatPiece::Kind::Char:
+        if (constant) {
+          text += static_cast<char>(constant->getZExtValue());
+        } else {
+          write("cat_write_char", builder.CreateTrunc(asInt, i8Ty));
+        }
+        break;
+      case FormatPiece::Kind::Str:
+        if (auto *literal = stringLiteral(arg)) {
+          text += literal->literal();
+        } else if (auto *single = llvm::dyn_cast<CharConst>(arg)) {
+          text += static_cast<char>(single->getValue());
+        } else {
+          write("cat_write_str", value);
+        }
+        break;
+      case FormatPiece::Kind::Spec: {
+        flushText();
+        // printf still does the padding and bases
+        llvm::Function *printFn = env.lookupFunc(calleeSym);
+        builder.CreateCall(printFn->getFunctionType(), printFn, {ctx.internString(piece.text), asInt});
+        break;
+      }
+      default:
+        break;
     }
   }
-
-  llvm::Function *printFn = currentEnv->lookupFunc(calleeSym);
-  llvm::FunctionType *printTy = printFn->getFunctionType();
-
-  // variadic 函数必须显式传 FunctionType
-  return builder.CreateCall(printTy, printFn, printArgs);
+  flushText();
+  return nullptr;
 }
 
-llvm::Value *CodeGen::makeBuiltinCall(FuncSymbol *calleeSym, const vec<uptr<Expr>> &args) {
+llvm::Value *CodeGen::makeBuiltinCall(FuncSymbol *calleeSym, ASTList<Expr> args) {
   if (calleeSym->getName() == "print") {
     return emitPrint(calleeSym, args);
   }
   return nullptr;
 }
 
-llvm::Value *CodeGen::makeCall(FuncSymbol *calleeSym, const vec<uptr<Expr>> &args) {
+llvm::Value *CodeGen::makeCall(FuncSymbol *calleeSym, ASTList<Expr> args) {
   if (!calleeSym)
     return nullptr;
 
   // declared function and we can find its LLVM function, parameters and
   // return type
-  llvm::Function *callee = currentEnv->lookupFunc(calleeSym);
+  llvm::Function *callee = env.lookupFunc(calleeSym);
   if (!callee)
     return nullptr;
 
@@ -840,10 +1065,10 @@ llvm::Value *CodeGen::makeCall(FuncSymbol *calleeSym, const vec<uptr<Expr>> &arg
   // helper to get lvalue node
   auto getLValueNode = [](Expr *expr) -> Lval * {
     while (expr) {
-      if (auto *lvalExpr = dynamic_cast<LValueExpr *>(expr)) {
+      if (auto *lvalExpr = llvm::dyn_cast<LValueExpr>(expr)) {
         return lvalExpr->lvalue();
       }
-      if (auto *parenExpr = dynamic_cast<ParenExpr *>(expr)) {
+      if (auto *parenExpr = llvm::dyn_cast<ParenExpr>(expr)) {
         expr = parenExpr->innerExpr();
         continue;
       }
@@ -854,7 +1079,7 @@ llvm::Value *CodeGen::makeCall(FuncSymbol *calleeSym, const vec<uptr<Expr>> &arg
 
   // args 是实参，我们会比较实参和形参，进行cast
   for (std::size_t i = 0; i < realCount; ++i) {
-    auto *expr = args[i].get();
+    auto *expr = args[i];
     auto *paramSym = params[i];
 
     llvm::Type *parmTy = functionTy->getFunctionParamType(paramIdx++);
@@ -865,15 +1090,15 @@ llvm::Value *CodeGen::makeCall(FuncSymbol *calleeSym, const vec<uptr<Expr>> &arg
           paramSym && paramSym->getPass() == Symbol::ParamPass::BY_REF;
       if (byRef) {
         if (auto *lvalNode = getLValueNode(expr)) {
-          lvalNode->accept(*this);
+          walk(lvalNode);
           argValue = lastValue;
         }
         if (!argValue) {
-          expr->accept(*this);
+          walk(expr);
           argValue = lastValue;
         }
       } else {
-        expr->accept(*this);
+        walk(expr);
         argValue = lastValue;
       }
     }
@@ -16,8 +16,6 @@
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/Alignment.h>
 #include <string>
-llvm::Function *CodeGenCtx::curFunction = nullptr;
-
 llvm::Type *CodeGenCtx::getLLVMType(const SemaType &ty, bool forParam) {
   auto typeKind = ty.getKind();
   switch (typeKind) {
@@ -79,7 +77,39 @@ llvm::GlobalVariable *CodeGenCtx::createGlobalVariable(const llvm::StringRef nam
   return variable;
 }
 
-llvm::Value *CodeGenCtx::createLocalVariable(Symbol *sym, llvm::Type *type, Environment::Env env) {
+llvm::GlobalVariable *CodeGenCtx::declareGlobalVariable(const llvm::StringRef name, llvm::Type *type) {
+  module->getOrInsertGlobal(name, type);
+  return module->getNamedGlobal(name);
+}
+
+llvm::GlobalVariable *CodeGenCtx::internString(llvm::StringRef text) {
+  auto &pooled = stringPool[text];
+  if (!pooled) {
+    auto *init = llvm::ConstantDataArray::getString(getLLVMContext(), text, true);
+    pooled = new llvm::GlobalVariable(*module, init->getType(), true, llvm::GlobalValue::PrivateLinkage, init, ".str");
+    pooled->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    pooled->setAlignment(llvm::Align(1));
+  }
+  return pooled;
+}
+
+llvm::GlobalVariable *CodeGenCtx::internConstant(llvm::Constant *init) {
+  // constants are uniqued by the context, equal literals share one global
+  auto &pooled = constantPool[init];
+  if (!pooled) {
+    pooled = new llvm::GlobalVariable(*module, init->getType(), true, llvm::GlobalValue::PrivateLinkage, init, ".arr");
+    pooled->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+  }
+  return pooled;
+}
+
+llvm::Value *CodeGenCtx::createLocalVariable(Symbol *sym, llvm::Type *type, Environment &env) {
+  auto varAlloc = createEntryAlloca(type, sym->getName());
+  env.bind(sym, varAlloc);
+  return varAlloc;
+}
+
+llvm::AllocaInst *CodeGenCtx::createEntryAlloca(llvm::Type *type, const llvm::Twine &name) {
   // Save current insertion point
   auto savedInsertBlock = builder->GetInsertBlock();
   auto savedInsertPoint = builder->GetInsertPoint();
@@ -89,16 +119,14 @@ llvm::Value *CodeGenCtx::createLocalVariable(Symbol *sym, llvm::Type *type, Envi
   builder->SetInsertPoint(&entryBlock, entryBlock.begin());
 
   // Create alloca instruction
-  auto varAlloc = builder->CreateAlloca(type, nullptr, sym->getName());
+  auto varAlloc = builder->CreateAlloca(type, nullptr, name);
 
   // Restore insertion point to continue generating code where we left off
   builder->SetInsertPoint(savedInsertBlock, savedInsertPoint);
-
-  env->bind(sym, varAlloc);
   return varAlloc;
 }
 
-llvm::Function *CodeGenCtx::createFunction(const FuncSymbol *funcSym, llvm::FunctionType *fnType, Environment::Env env) {
+llvm::Function *CodeGenCtx::createFunction(const FuncSymbol *funcSym, llvm::FunctionType *fnType, Environment &env) {
   auto func = module->getFunction(funcSym->getName());
   if (!func) {
     func = createFunctionProto(funcSym, fnType, env);
@@ -107,11 +135,11 @@ llvm::Function *CodeGenCtx::createFunction(const FuncSymbol *funcSym, llvm::Func
   return func;
 }
 
-llvm::Function *CodeGenCtx ::createFunctionProto(const FuncSymbol *funcSym, llvm::FunctionType *fnType, Environment::Env env) {
+llvm::Function *CodeGenCtx ::createFunctionProto(const FuncSymbol *funcSym, llvm::FunctionType *fnType, Environment &env) {
   auto func =
       llvm::Function::Create(fnType, llvm::GlobalValue::ExternalLinkage, funcSym->getName(), module.get());
   verifyFunction(*func);
-  env->bindFunc(funcSym, func);
+  env.bindFunc(funcSym, func);
   return func;
 }
 
@@ -129,19 +157,19 @@ size_t CodeGenCtx::getTypeSize(llvm::Type *type) {
   return module->getDataLayout().getTypeAllocSize(type);
 }
 
-llvm::Value *CodeGenCtx::createInstance(const string &clsName, const string &varName, Environment::Env env) {
-  auto cls = llvm::StructType::getTypeByName(getLLVMContext(), clsName);
-  auto instance = mallocInstance(cls, varName);
+llvm::Value *CodeGenCtx::createInstance(const ClassInfo *clsInfo, const string &varName) {
+  auto instance = mallocInstance(clsInfo, varName);
   // call Constructor
-  auto constor = getModule().getFunction(clsName + "_constructor");
-  if (constor->arg_size() == 1) {
+  auto constor = clsInfo->ctor;
+  if (constor && constor->arg_size() == 1) {
     getBuilder().CreateCall(constor, {instance});
   }
   return instance;
 }
 
 // allocate an object of a given class on the heap
-llvm::Value *CodeGenCtx::mallocInstance(llvm::StructType *cls, const std::string &name) {
+llvm::Value *CodeGenCtx::mallocInstance(const ClassInfo *clsInfo, const std::string &name) {
+  auto cls = clsInfo->cls;
   auto typeSize = builder->getInt64(getTypeSize(cls));
 
   llvm::Value *instance = builder->CreateCall(module->getFunction("malloc"), typeSize, name);
@@ -150,87 +178,116 @@ llvm::Value *CodeGenCtx::mallocInstance(llvm::StructType *cls, const std::string
   //auto instance = builder->CreatePointerCast(mallocPtr, llvm::PointerType::get(cls, 0));
 
   // set vtable
-  std::string className{cls->getName().data()};
-  auto vTableName = className + "_vTable";
   auto vTableAddr = builder->CreateStructGEP(cls, instance, VTABLE_INDEX);
-  auto vTable = module->getNamedGlobal(vTableName);
-
-  builder->CreateStore(vTable, vTableAddr);
+  builder->CreateStore(clsInfo->vTable, vTableAddr);
 
   return instance;
 }
-void CodeGenCtx::buildClassInfo(llvm::StructType *cls, const ClassDecl &node, Environment::Env env) {
-  string clsName = node.identifier();
+void CodeGenCtx::buildClassInfo(ClassInfo *classInfo, const ClassDecl &node, Environment &env) {
+  const string &clsName = node.identifier();
   const auto *clsSym = node.getClassSymbol();
-  auto &classInfo = classMap[clsName];
+  const Ident ctorIdent = intern("constructor");
   // member variable need to be added outside of the class
   // add using code like cls.a=1; and visit as well
 
   // now suppport declare variable in class
   for (auto *method: clsSym->getMethods()) {
-    string methodName = clsName + "_" + method->getName();
-    method->setName(methodName);
+    // members are indexed by their source name; only the llvm symbol is prefixed
+    Ident memberName = method->getIdent();
+    method->setName(intern(clsName + "_" + method->getName()));
     auto methodSig = buildSignature(method, false, true);
     auto llvmFuncType =
         llvm::FunctionType::get(methodSig.retTy, methodSig.paramTys, false);
-    classInfo->methodsMap[methodName] =
-        createFunctionProto(method, llvmFuncType, env);
+    auto *fn = createFunctionProto(method, llvmFuncType, env);
+    classInfo->methodsMap[memberName] = classInfo->methods.size();
+    classInfo->methods.push_back(fn);
+    if (memberName == ctorIdent) {
+      classInfo->ctor = fn;
+    }
   }
   for (auto *field: clsSym->getFields()) {
     auto fieldType = getLLVMType(*(field->getType()));
-    classInfo->fieldsMap[field->getName()] = fieldType;
+    classInfo->fieldsMap[field->getIdent()] = classInfo->fieldTypes.size();
+    classInfo->fieldTypes.push_back(fieldType);
   }
-  buildClassBody(cls);
+  buildClassBody(classInfo);
 }
-void CodeGenCtx::buildClassBody(llvm::StructType *cls) {
-  string clsName = cls->getName().data();
-  auto clsInfo = classMap[clsName].get();
+void CodeGenCtx::buildClassBody(ClassInfo *clsInfo) {
+  string clsName = clsInfo->cls->getName().str();
   // allocate vtable to set type
   string vTabeleName = clsName + "_vTable";
   // ! we now create virtual table of a class which means we create actual class and its members
-  llvm::StructType *vTableType = llvm::StructType::create(getLLVMContext(), vTabeleName);
+  clsInfo->vTableType = llvm::StructType::create(getLLVMContext(), vTabeleName);
 
   // virtual table first has a pointer to itself
   // auto clsField = vec<llvm::Type *>{vTableType->getPointerTo()};
   // 1 => global address space; 0 => generic address space
-  auto clsField = vec<llvm::Type *>{llvm::PointerType::get(vTableType, 0)};
-  for (const auto &field: clsInfo->fieldsMap) {
-    clsField.push_back(field.second);
-  }
-  cls->setBody(clsField, false);
+  auto clsField = vec<llvm::Type *>{llvm::PointerType::get(clsInfo->vTableType, 0)};
+  clsField.insert(clsField.end(), clsInfo->fieldTypes.begin(), clsInfo->fieldTypes.end());
+  clsInfo->cls->setBody(clsField, false);
   // build methods
-  buildVTable(cls, clsInfo);
+  buildVTable(clsInfo);
 }
-void CodeGenCtx::buildVTable(llvm::StructType *cls, ClassInfo *classInfo) {
-  string clsName = cls->getName().data();
-  string vTableName = clsName + "_vTable";
-  auto vTableType = llvm::StructType::getTypeByName(getLLVMContext(), vTableName);
+void CodeGenCtx::buildVTable(ClassInfo *classInfo) {
+  string vTableName = classInfo->cls->getName().str() + "_vTable";
 
   vec<llvm::Constant *> vTableMethods;
   vec<llvm::Type *> vTableMethodTypes;
 
-  for (const auto &method: classInfo->methodsMap) {
-    vTableMethods.push_back(method.second);
-    vTableMethodTypes.push_back(method.second->getType());
+  for (auto *method: classInfo->methods) {
+    vTableMethods.push_back(method);
+    vTableMethodTypes.push_back(method->getType());
   }
 
-  vTableType->setBody(vTableMethodTypes);
-  auto vTableValue = llvm::ConstantStruct::get(vTableType, vTableMethods);
+  classInfo->vTableType->setBody(vTableMethodTypes);
+  auto vTableValue = llvm::ConstantStruct::get(classInfo->vTableType, vTableMethods);
   // vTableGlobal->setInitializer(vTableValue);
-  createGlobalVariable(vTableName, vTableValue);
+  classInfo->vTable = createGlobalVariable(vTableName, vTableValue);
 }
-size_t CodeGenCtx::getFieldIndex(llvm::StructType *cls, const std::string &fieldName) {
-  auto &fMap = classMap[cls->getName().data()]->fieldsMap;
-  auto it = fMap.find(fieldName);
-  return std::distance(fMap.begin(), it) + RESERVED_FIELD_COUNT;// +1 because the first one is self
+CodeGenCtx::ClassInfo *CodeGenCtx::importClass(const ClassDecl &node, const ClassInfo &defined, Environment &env) {
+  const string &clsName = node.identifier();
+  const auto *clsSym = node.getClassSymbol();
+  curCls = llvm::StructType::create(getLLVMContext(), clsName);
+  module->getOrInsertGlobal(clsName, curCls);
+  auto *classInfo = addClsMap(node.ident(), std::make_unique<ClassInfo>(curCls, nullptr));
+
+  // the method symbols were given their prefixed names when the class was built
+  for (auto *method: clsSym->getMethods()) {
+    auto methodSig = buildSignature(method, false, true);
+    auto llvmFuncType =
+        llvm::FunctionType::get(methodSig.retTy, methodSig.paramTys, false);
+    auto *fn = createFunctionProto(method, llvmFuncType, env);
+    if (defined.ctor && defined.methods[classInfo->methods.size()] == defined.ctor) {
+      classInfo->ctor = fn;
+    }
+    classInfo->methods.push_back(fn);
+  }
+  classInfo->methodsMap = defined.methodsMap;
+  for (auto *field: clsSym->getFields()) {
+    classInfo->fieldTypes.push_back(getLLVMType(*(field->getType())));
+  }
+  classInfo->fieldsMap = defined.fieldsMap;
+
+  // same body as buildClassBody, but the vtable itself stays in its module
+  classInfo->vTableType = llvm::StructType::create(getLLVMContext(), clsName + "_vTable");
+  auto clsField = vec<llvm::Type *>{llvm::PointerType::get(classInfo->vTableType, 0)};
+  clsField.insert(clsField.end(), classInfo->fieldTypes.begin(), classInfo->fieldTypes.end());
+  curCls->setBody(clsField, false);
+  vec<llvm::Type *> vTableMethodTypes;
+  for (auto *method: classInfo->methods) {
+    vTableMethodTypes.push_back(method->getType());
+  }
+  classInfo->vTableType->setBody(vTableMethodTypes);
+  classInfo->vTable = declareGlobalVariable(defined.vTable->getName(), classInfo->vTableType);
+
+  curCls = nullptr;
+  return classInfo;
 }
-size_t CodeGenCtx::getMethodIndex(llvm::StructType *cls, const std::string &methodName) {
-  auto mMap = classMap[cls->getName().data()]->methodsMap;
-  auto it = mMap.find(methodName);
-  return std::distance(mMap.begin(), it);
+size_t CodeGenCtx::getFieldIndex(const ClassInfo *clsInfo, Ident fieldName) const {
+  return clsInfo->fieldsMap.lookup(fieldName) + RESERVED_FIELD_COUNT;// +1 because the first one is self
 }
-bool CodeGenCtx::isMethod(llvm::StructType *cls, const std::string &name) {
-  return false;
+size_t CodeGenCtx::getMethodIndex(const ClassInfo *clsInfo, Ident methodName) const {
+  return clsInfo->methodsMap.lookup(methodName);
 }
 
 CodeGenCtx::FuncSignature CodeGenCtx::buildSignature(const FuncSymbol *funcSym, bool isMain, bool isMethod) {
@@ -252,7 +309,7 @@ CodeGenCtx::FuncSignature CodeGenCtx::buildSignature(const FuncSymbol *funcSym,
 
   if (!isMain) {
     auto *fnSig =
-        funcSym ? static_cast<const FuncType *>(funcSym->getType().get())
+        funcSym ? static_cast<const FuncType *>(funcSym->getType())
                 : nullptr;
     sig.retTy = (fnSig && fnSig->returnType())
                     ? getLLVMType(*fnSig->returnType())
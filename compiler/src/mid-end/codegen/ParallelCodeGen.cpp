@@ -0,0 +1,105 @@
+#include "ParallelCodeGen.hpp"
+#include "catlib.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <string>
+#include <thread>
+
+ParallelCodeGen::ParallelCodeGen(CodeGen &header, SemanticCtx &semCtx, unsigned jobs)
+    : header(header), semCtx(semCtx), jobs(jobs) {}
+
+bool ParallelCodeGen::supports(const Program &program) {
+  for (auto *def: program.getDefs()) {
+    if (llvm::isa<VarDef>(def)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ParallelCodeGen::run(Program &program) {
+  lowerHeader(program);
+  // contiguous slices of about the same number of functions, so a function
+  // always lands in the same module
+  lowerFunctions(program, std::min<std::size_t>(jobs, functions.size()));
+}
+
+void ParallelCodeGen::run(Program &program, llvm::ArrayRef<ASTNode *> selected) {
+  lowerHeader(program);
+  functions.assign(selected.begin(), selected.end());
+  lowerFunctions(program, functions.size());
+}
+
+void ParallelCodeGen::lowerHeader(Program &program) {
+  // the main module: prototypes first, class methods may call any function
+  header.declareFunctions(program);
+  for (auto *def: program.getDefs()) {
+    if (llvm::isa<FuncDef>(def)) {
+      functions.push_back(def);
+    } else {
+      header.walk(def);
+    }
+  }
+}
+
+void ParallelCodeGen::lowerFunctions(Program &program, std::size_t moduleCount) {
+  if (functions.empty()) {
+    return;
+  }
+  for (std::size_t i = 0; i < moduleCount; ++i) {
+    Worker worker;
+    worker.ctx = std::make_unique<CodeGenCtx>("Cat_Module." + std::to_string(i + 1));
+    worker.gen = std::make_unique<CodeGen>(*worker.ctx, /*defineGlobals=*/false);
+    // marks the builtin symbols, done here rather than on the worker threads
+    Catime::genBuiltins(semCtx, *worker.gen);
+    const std::size_t begin = functions.size() * i / moduleCount;
+    const std::size_t end = functions.size() * (i + 1) / moduleCount;
+    worker.defs = ASTList<ASTNode>(functions).slice(begin, end - begin);
+    workers.push_back(std::move(worker));
+  }
+
+  vec<std::exception_ptr> errors(workers.size());
+  std::atomic<std::size_t> next{0};
+  auto lower = [&] {
+    for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < workers.size();) {
+      try {
+        Worker &worker = workers[i];
+        worker.gen->importDeclarations(program, header.getContext());
+        for (auto *def: worker.defs) {
+          worker.gen->walk(def);
+        }
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+  const std::size_t threads = std::min<std::size_t>(std::max(1u, jobs), workers.size());
+  vec<std::thread> pool;
+  for (std::size_t t = 1; t < threads; ++t) {
+    pool.emplace_back(lower);
+  }
+  lower();
+  for (auto &thread: pool) {
+    thread.join();
+  }
+  for (auto &error: errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+vec<CodeGenCtx *> ParallelCodeGen::modules() const {
+  vec<CodeGenCtx *> result;
+  for (const auto &worker: workers) {
+    result.push_back(worker.ctx.get());
+  }
+  return result;
+}
+
+void ParallelCodeGen::save() {
+  for (std::size_t i = 0; i < workers.size(); ++i) {
+    workers[i].gen->save("./out." + std::to_string(i + 1) + ".ll");
+  }
+}
@@ -0,0 +1,120 @@
+#include "SSABuilder.hpp"
+#include <cassert>
+#include <llvm-20/llvm/ADT/SmallVector.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/Support/Casting.h>
+
+void SSABuilder::write(const Symbol &sym, llvm::BasicBlock *block, llvm::Value *value) {
+  llvm::Type *type = types[sym.slot()];
+  if (value->getType() != type && value->getType()->isIntegerTy() && type->isIntegerTy()) {
+    value = builder.CreateZExtOrTrunc(value, type);
+  }
+  defs[{block, sym.slot()}] = value;
+}
+
+llvm::Value *SSABuilder::read(uint32_t slot, llvm::BasicBlock *block) {
+  auto it = defs.find({block, slot});
+  if (it == defs.end()) {
+    return readRecursive(slot, block);
+  }
+  llvm::Value *value = it->second;
+  for (auto next = replaced.find(value); next != replaced.end(); next = replaced.find(value)) {
+    value = next->second;
+  }
+  it->second = value;
+  return value;
+}
+
+llvm::Value *SSABuilder::readRecursive(uint32_t slot, llvm::BasicBlock *block) {
+  llvm::Value *value = nullptr;
+  if (!sealed.count(block)) {
+    auto *phi = createPhi(slot, block);
+    incompletePhis[block].emplace_back(slot, phi);
+    value = phi;
+  } else if (auto *pred = block->getSinglePredecessor()) {
+    value = read(slot, pred);
+  } else if (llvm::pred_empty(block)) {
+    // read before any write, like a load from a fresh alloca
+    value = llvm::UndefValue::get(types[slot]);
+  } else {
+    // recorded first so reads around a loop end at this phi
+    auto *phi = createPhi(slot, block);
+    defs[{block, slot}] = phi;
+    value = addOperands(slot, phi);
+  }
+  defs[{block, slot}] = value;
+  return value;
+}
+
+llvm::PHINode *SSABuilder::createPhi(uint32_t slot, llvm::BasicBlock *block) {
+  llvm::IRBuilderBase::InsertPointGuard guard(builder);
+  builder.SetInsertPoint(block, block->begin());
+  return builder.CreatePHI(types[slot], 2);
+}
+
+llvm::Value *SSABuilder::addOperands(uint32_t slot, llvm::PHINode *phi) {
+  filling.insert(phi);
+  for (auto *pred: llvm::predecessors(phi->getParent())) {
+    phi->addIncoming(read(slot, pred), pred);
+  }
+  filling.erase(phi);
+  return removeTrivialPhi(phi);
+}
+
+llvm::Value *SSABuilder::removeTrivialPhi(llvm::PHINode *phi) {
+  llvm::Value *same = nullptr;
+  for (llvm::Value *op: phi->incoming_values()) {
+    if (op == same || op == phi) {
+      continue;
+    }
+    if (same) {
+      return phi;// merges two values
+    }
+    same = op;
+  }
+  if (!same) {
+    same = llvm::UndefValue::get(phi->getType());
+  }
+
+  llvm::SmallVector<llvm::PHINode *, 8> users;
+  for (auto *user: phi->users()) {
+    if (auto *userPhi = llvm::dyn_cast<llvm::PHINode>(user); userPhi && userPhi != phi) {
+      users.push_back(userPhi);
+    }
+  }
+  phi->replaceAllUsesWith(same);
+  phi->dropAllReferences();
+  replaced[phi] = same;
+  removed.push_back(phi);
+  // users may have become trivial in turn; those still getting their operands
+  // are checked when they have them all
+  for (auto *user: users) {
+    if (!filling.count(user) && !replaced.count(user)) {
+      removeTrivialPhi(user);
+    }
+  }
+  return same;
+}
+
+void SSABuilder::seal(llvm::BasicBlock *block) {
+  sealed.insert(block);
+  auto it = incompletePhis.find(block);
+  if (it == incompletePhis.end()) {
+    return;
+  }
+  auto phis = std::move(it->second);
+  incompletePhis.erase(it);
+  for (auto &entry: phis) {
+    addOperands(entry.first, entry.second);
+  }
+}
+
+void SSABuilder::finish() {
+  assert(incompletePhis.empty() && "block left unsealed");
+  for (auto *phi: removed) {
+    phi->eraseFromParent();
+  }
+  removed.clear();
+  replaced.clear();
+}
@@ -1,4 +1,7 @@
 #include "Optimizer.hpp"
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <optional>
 #include <llvm/IR/PassManager.h>
 #include <llvm/Transforms/InstCombine/InstCombine.h>
 #include <llvm/Transforms/Scalar/GVN.h>
@@ -6,7 +9,12 @@
 #include <llvm/Transforms/Scalar/SCCP.h>
 #include <llvm/Transforms/Scalar/SimplifyCFG.h>
 
-Optimizier::Optimizier() : passBuilder() {
+Optimizier::Optimizier(bool timePasses_)
+    : timePasses(timePasses_ ? std::make_unique<llvm::TimePassesHandler>(true) : nullptr),
+      passBuilder(nullptr, llvm::PipelineTuningOptions(), std::nullopt, &instrumentation) {
+  if (timePasses) {
+    timePasses->registerCallbacks(instrumentation);
+  }
   // register all the basic analyses with the managers
   passBuilder.registerModuleAnalyses(moduleAM);
   passBuilder.registerCGSCCAnalyses(cgsccAM);
@@ -30,4 +38,29 @@ void Optimizier::optimize(llvm::Module &module, llvm::OptimizationLevel optLevel
     modulePM.addPass(passBuilder.buildPerModuleDefaultPipeline(optLevel));// default optimization pipeline
   }
   modulePM.run(module, moduleAM);
+  // a program lowered in parallel is optimized one module at a time, do not
+  // keep results keyed on this module's IR around
+  loopAM.clear();
+  functionAM.clear();
+  cgsccAM.clear();
+  moduleAM.clear();
+}
+
+std::string Optimizier::passReport(bool json) {
+  std::string report;
+  if (!timePasses) {
+    return report;
+  }
+  llvm::raw_string_ostream os(report);
+  if (json) {
+    // members only, CompileStats wraps them in an object
+    llvm::TimerGroup::printAllJSONValues(os, "");
+  } else {
+    timePasses->setOutStream(os);
+    timePasses->print();
+  }
+  os.flush();
+  // print() also resets the timers, keep the handler's destructor quiet
+  timePasses->setOutStream(llvm::nulls());
+  return report;
 }
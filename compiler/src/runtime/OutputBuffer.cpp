@@ -0,0 +1,145 @@
+#include "OutputBuffer.hpp"
+#include "catlib.hpp"
+
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+  // flushes of different threads do not interleave
+  std::mutex writeMutex;
+
+  constexpr char digitPairs[] = "00010203040506070809"
+                                "10111213141516171819"
+                                "20212223242526272829"
+                                "30313233343536373839"
+                                "40414243444546474849"
+                                "50515253545556575859"
+                                "60616263646566676869"
+                                "70717273747576777879"
+                                "80818283848586878889"
+                                "90919293949596979899";
+
+  // the output is dropped if stdout goes away, as stdio would
+  void writeAll(iovec *iov, int count) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    while (count > 0) {
+      ssize_t n = ::writev(STDOUT_FILENO, iov, count);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      // skip what a short write got out
+      while (count > 0 && static_cast<std::size_t>(n) >= iov->iov_len) {
+        n -= static_cast<ssize_t>(iov->iov_len);
+        ++iov;
+        --count;
+      }
+      if (count > 0) {
+        iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+        iov->iov_len -= static_cast<std::size_t>(n);
+      }
+    }
+  }
+}// namespace
+
+namespace Catime {
+  OutputBuffer::OutputBuffer() : lineBuffered(::isatty(STDOUT_FILENO)) {
+    // whatever the host printed through stdio goes first
+    std::fflush(stdout);
+  }
+
+  OutputBuffer &OutputBuffer::current() {
+    // on the heap, threads that never print do not carry a buffer
+    thread_local std::unique_ptr<OutputBuffer> buffer;
+    if (!buffer) {
+      buffer = std::make_unique<OutputBuffer>();
+    }
+    return *buffer;
+  }
+
+  void OutputBuffer::writeUnsigned(uint64_t value) {
+    // two digits at a time, from the right
+    char digits[20];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    while (value >= 100) {
+      p -= 2;
+      std::memcpy(p, digitPairs + (value % 100) * 2, 2);
+      value /= 100;
+    }
+    if (value >= 10) {
+      p -= 2;
+      std::memcpy(p, digitPairs + value * 2, 2);
+    } else {
+      *--p = static_cast<char>('0' + value);
+    }
+    write(p, static_cast<std::size_t>(end - p));
+  }
+
+  void OutputBuffer::writeSigned(int64_t value) {
+    if (value < 0) {
+      put('-');
+      writeUnsigned(0 - static_cast<uint64_t>(value));
+      return;
+    }
+    writeUnsigned(static_cast<uint64_t>(value));
+  }
+
+  void OutputBuffer::flush() {
+    if (used == 0) {
+      return;
+    }
+    iovec iov{data, used};
+    writeAll(&iov, 1);
+    used = 0;
+  }
+
+  void OutputBuffer::writeThrough(const char *text, std::size_t length) {
+    // one system call for the buffered text and the new one, no copy
+    iovec iov[2] = {{data, used}, {const_cast<char *>(text), length}};
+    writeAll(iov, 2);
+    used = 0;
+  }
+}// namespace Catime
+
+extern "C" void cat_print(const char *fmt, ...) {
+  char text[256];
+  va_list ap;
+  va_start(ap, fmt);
+  va_list retry;
+  va_copy(retry, ap);
+  int length = std::vsnprintf(text, sizeof(text), fmt, ap);
+  va_end(ap);
+  if (length >= static_cast<int>(sizeof(text))) {
+    std::vector<char> longer(static_cast<std::size_t>(length) + 1);
+    std::vsnprintf(longer.data(), longer.size(), fmt, retry);
+    Catime::OutputBuffer::current().write(longer.data(), static_cast<std::size_t>(length));
+  } else if (length > 0) {
+    Catime::OutputBuffer::current().write(text, static_cast<std::size_t>(length));
+  }
+  va_end(retry);
+}
+// what print lowers to, see parseFormat
+extern "C" void cat_write_lit(const char *text, int64_t length) {
+  Catime::OutputBuffer::current().write(text, static_cast<std::size_t>(length));
+}
+extern "C" void cat_write_i32(int32_t value) {
+  Catime::OutputBuffer::current().writeSigned(value);
+}
+extern "C" void cat_write_u32(uint32_t value) {
+  Catime::OutputBuffer::current().writeUnsigned(value);
+}
+extern "C" void cat_write_char(char value) {
+  Catime::OutputBuffer::current().put(value);
+}
+extern "C" void cat_write_str(const char *text) {
+  Catime::OutputBuffer::current().write(text, std::strlen(text));
+}
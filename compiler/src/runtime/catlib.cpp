@@ -1,33 +1,28 @@
 #include "catlib.hpp"
 
 
-#include <cstdarg>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <iterator>
 #include <llvm-20/llvm/IR/DebugInfoMetadata.h>
 #include <llvm-20/llvm/IR/Type.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Module.h>
 
-extern "C" void cat_print(const char *fmt, ...) {
-  va_list ap;
-  va_start(ap, fmt);
-  std::vprintf(fmt, ap);
-  va_end(ap);
-}
 namespace Catime {
 
   // Local helper structs for builtin declaration
   struct ParamInfo {
-    std::string name;
+    Ident name;
     Location loc = Location::builtIn();
     SemaTypePtr type;
     Symbol::ParamPass passMode = Symbol::ParamPass::BY_VAL;
   };
 
   struct HeaderInfo {
-    std::string name;
+    Ident name;
     Location loc = Location::builtIn();
     bool isProcedure = false;
     bool isVariadic = false;
@@ -36,14 +31,14 @@ namespace Catime {
   };
 
   void declareBuiltins(SemanticCtx &semCtx) {
-    for (std::size_t i = 0; i < sizeof(builtinTable) / sizeof(CatBuiltin); ++i) {
+    for (std::size_t i = 0; i < std::size(builtinTable); ++i) {
       HeaderInfo info;
       ParamInfo param;
       switch (i) {
         case 0: {
           info.params.clear();
           info.params.push_back({});
-          info.name = builtinTable[i].catName;
+          info.name = intern(builtinTable[i].catName);
           info.isProcedure = true;
           info.isVariadic = true;
           info.returnType = makeVoidType();
@@ -59,6 +54,8 @@ namespace Catime {
       }
       auto sig = makeFuncType(info.returnType, std::move(paramTypes));
       auto func = std::make_unique<FuncSymbol>(info.name, std::move(sig), info.isProcedure, info.isVariadic, info.loc);
+      // sema checks the arguments of some builtins itself, print's format
+      func->setBuiltin(true);
 
       semCtx.beginScope();
       for (const auto &pInfo: info.params) {
@@ -78,22 +75,46 @@ namespace Catime {
     auto &ctx = codegen.getContext();
     auto &module = ctx.getModule();
     auto &llctx = ctx.getLLVMContext();
-    auto globalEnv = codegen.getGlobalEnvironment();
-
-    auto *i32Ty = llvm::Type::getInt32Ty(llctx);
-    auto *i8Ty = llvm::Type::getInt8Ty(llctx);
-    auto *ptrTy = llvm::PointerType::get(llctx, 0);
+    auto &globalEnv = codegen.getGlobalEnvironment();
 
+    auto llvmType = [&](RuntimeType type) -> llvm::Type * {
+      switch (type) {
+        case RuntimeType::Void:
+          return llvm::Type::getVoidTy(llctx);
+        case RuntimeType::I8:
+          return llvm::Type::getInt8Ty(llctx);
+        case RuntimeType::I32:
+          return llvm::Type::getInt32Ty(llctx);
+        case RuntimeType::I64:
+          return llvm::Type::getInt64Ty(llctx);
+        case RuntimeType::Ptr:
+          return llvm::PointerType::get(llctx, 0);
+      }
+      return nullptr;
+    };
     auto bind = [&](const char *catName, llvm::Function *fn) {
       if (!fn) return;
       auto res = semCtx.lookup(catName);
       if (res.symbol && res.symbol->getKind() == Symbol::SymKind::FUNC) {
         auto res_func = static_cast<FuncSymbol *>(res.symbol);
         res_func->setBuiltin(true);
-        globalEnv->bindFunc(res_func, fn);
+        globalEnv.bindFunc(res_func, fn);
       }
     };
-    llvm::FunctionType *printTy = llvm::FunctionType::get(llvm::Type::getVoidTy(llctx), ptrTy, true);
-    bind("print", llvm::Function::Create(printTy, llvm::Function::ExternalLinkage, builtinTable[0].runtimeName, &module));
+    for (const auto &builtin: builtinTable) {
+      std::vector<llvm::Type *> params;
+      for (RuntimeType param: builtin.params) {
+        if (param == RuntimeType::Void) {
+          break;
+        }
+        params.push_back(llvmType(param));
+      }
+      auto *type = llvm::FunctionType::get(llvmType(builtin.result), params, builtin.isVariadic);
+      auto *fn = llvm::Function::Create(type, llvm::Function::ExternalLinkage, builtin.runtimeName, &module);
+      // the others are called by name from the lowered print calls
+      if (builtin.catName) {
+        bind(builtin.catName, fn);
+      }
+    }
   }
 }// namespace Catime